@@ -11,5 +11,9 @@ public class FPSProject3Target : TargetRules
 		DefaultBuildSettings = BuildSettingsVersion.V5;
 		IncludeOrderVersion = EngineIncludeOrderVersion.Unreal5_6;
 		ExtraModuleNames.Add("FPSProject3");
+
+		// push model replication needs its own build environment
+		BuildEnvironment = TargetBuildEnvironment.Unique;
+		bWithPushModel = true;
 	}
 }
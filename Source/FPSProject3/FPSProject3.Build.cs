@@ -18,7 +18,10 @@ public class FPSProject3 : ModuleRules
 			"StateTreeModule",
 			"GameplayStateTreeModule",
 			"UMG",
-			"Slate"
+			"Slate",
+			"NetCore",
+			"ReplicationGraph",
+			"MassEntity"
 		});
 
 		PrivateDependencyModuleNames.AddRange(new string[] { });
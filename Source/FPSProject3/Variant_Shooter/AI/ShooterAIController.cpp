@@ -7,6 +7,7 @@
 #include "Perception/AIPerceptionComponent.h"
 #include "Navigation/PathFollowingComponent.h"
 #include "AI/Navigation/PathFollowingAgentInterface.h"
+#include "ShooterPerceptionScheduler.h"
 
 AShooterAIController::AShooterAIController()
 {
@@ -33,6 +34,9 @@ void AShooterAIController::OnPossess(APawn* InPawn)
 
 		// subscribe to the pawn's OnDeath delegate
 		NPC->OnPawnDeath.AddDynamic(this, &AShooterAIController::OnPawnDeath);
+
+		// pick up the rates of the pawn's significance tier
+		ApplyAITier(NPC->GetAITierSettings());
 	}
 }
 
@@ -61,14 +65,48 @@ void AShooterAIController::ClearCurrentTarget()
 	TargetEnemy = nullptr;
 }
 
-void AShooterAIController::OnPerceptionUpdated(AActor* Actor, FAIStimulus Stimulus)
+void AShooterAIController::ProcessPerception(AActor* Actor, const FAIStimulus& Stimulus)
 {
+	NextPerceptionTime = GetWorld()->GetTimeSeconds() + PerceptionInterval;
+
 	// pass the data to the StateTree delegate hook
 	OnShooterPerceptionUpdated.ExecuteIfBound(Actor, Stimulus);
 }
 
+bool AShooterAIController::IsPerceptionReady() const
+{
+	return GetWorld()->GetTimeSeconds() >= NextPerceptionTime;
+}
+
+void AShooterAIController::ApplyAITier(const FShooterAITierSettings& Settings)
+{
+	StateTreeAI->SetComponentTickInterval(Settings.StateTreeTickInterval);
+
+	// a shorter interval takes effect right away
+	NextPerceptionTime = FMath::Min(NextPerceptionTime, GetWorld()->GetTimeSeconds() + Settings.PerceptionInterval);
+	PerceptionInterval = Settings.PerceptionInterval;
+}
+
+void AShooterAIController::OnPerceptionUpdated(AActor* Actor, FAIStimulus Stimulus)
+{
+	// spread the processing over frames with the other NPCs' stimuli
+	if (UShooterPerceptionScheduler* Scheduler = GetWorld()->GetSubsystem<UShooterPerceptionScheduler>())
+	{
+		Scheduler->QueueStimulus(this, Actor, Stimulus);
+		return;
+	}
+
+	ProcessPerception(Actor, Stimulus);
+}
+
 void AShooterAIController::OnPerceptionForgotten(AActor* Actor)
 {
+	// a stimulus still queued for the actor would bring it back
+	if (UShooterPerceptionScheduler* Scheduler = GetWorld()->GetSubsystem<UShooterPerceptionScheduler>())
+	{
+		Scheduler->CancelStimuli(this, Actor);
+	}
+
 	// pass the data to the StateTree delegate hook
 	OnShooterPerceptionForgotten.ExecuteIfBound(Actor);
 }
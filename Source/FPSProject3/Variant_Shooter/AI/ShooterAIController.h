@@ -9,6 +9,7 @@
 class UStateTreeAIComponent;
 class UAIPerceptionComponent;
 struct FAIStimulus;
+struct FShooterAITierSettings;
 
 DECLARE_DELEGATE_TwoParams(FShooterPerceptionUpdatedDelegate, AActor*, const FAIStimulus&);
 DECLARE_DELEGATE_OneParam(FShooterPerceptionForgottenDelegate, AActor*);
@@ -38,6 +39,12 @@ protected:
 	/** Enemy currently being targeted */
 	TObjectPtr<AActor> TargetEnemy;
 
+	/** Min seconds between processed perception stimuli, set by the AI significance tier */
+	float PerceptionInterval = 0.0f;
+
+	/** Time the next perception stimulus may be processed at */
+	double NextPerceptionTime = 0.0;
+
 public:
 
 	/** Called when an AI perception has been updated. StateTree task delegate hook */
@@ -73,9 +80,18 @@ public:
 	/** Returns the targeted enemy */
 	AActor* GetCurrentTarget() const { return TargetEnemy; };
 
+	/** Passes a perception update to the StateTree. Called by the perception scheduler when the stimulus comes up */
+	void ProcessPerception(AActor* Actor, const FAIStimulus& Stimulus);
+
+	/** Returns true if the perception interval allows processing another stimulus */
+	bool IsPerceptionReady() const;
+
+	/** Applies the StateTree and perception rates of an AI significance tier */
+	void ApplyAITier(const FShooterAITierSettings& Settings);
+
 protected:
 
-	/** Called when the AI perception component updates a perception on a given actor */
+	/** Called when the AI perception component updates a perception on a given actor. Queues it with the perception scheduler */
 	UFUNCTION()
 	void OnPerceptionUpdated(AActor* Actor, FAIStimulus Stimulus);
 
@@ -0,0 +1,226 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Variant_Shooter/AI/ShooterAISignificance.h"
+#include "Variant_Shooter/AI/ShooterNPC.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Variant_Shooter/ShooterStats.h"
+
+namespace ShooterAISignificance
+{
+	static int32 Enabled = 1;
+	static FAutoConsoleVariableRef CVarEnabled(
+		TEXT("Shooter.AI.Significance"),
+		Enabled,
+		TEXT("If non-zero, NPCs far from and out of view of the players run their AI at reduced rates. If zero, every NPC runs in the top tier"));
+
+	static int32 PinnedTier = -1;
+	static FAutoConsoleVariableRef CVarPinnedTier(
+		TEXT("Shooter.AI.PinnedTier"),
+		PinnedTier,
+		TEXT("If zero or more, every NPC that isn't promoted by damage runs in this tier regardless of the players, so bot benchmarks measure a fixed AI load"));
+}
+
+UShooterAISignificance::UShooterAISignificance()
+{
+	// near or in view: full rate
+	FShooterAITierSettings& High = Tiers.AddDefaulted_GetRef();
+	High.MaxDistance = 3000.0f;
+
+	// mid range
+	FShooterAITierSettings& Medium = Tiers.AddDefaulted_GetRef();
+	Medium.MaxDistance = 8000.0f;
+	Medium.StateTreeTickInterval = 0.1f;
+	Medium.PerceptionInterval = 0.25f;
+	Medium.MaxLineOfSightChecks = 3;
+
+	// everything else
+	FShooterAITierSettings& Low = Tiers.AddDefaulted_GetRef();
+	Low.StateTreeTickInterval = 0.5f;
+	Low.PerceptionInterval = 1.0f;
+	Low.MaxLineOfSightChecks = 2;
+	Low.bTraceAim = false;
+}
+
+bool UShooterAISignificance::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UShooterAISignificance::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	UpdateAccumulator += DeltaTime;
+
+	if (UpdateAccumulator >= UpdateInterval)
+	{
+		UpdateAccumulator = 0.0f;
+		UpdateTiers();
+	}
+}
+
+TStatId UShooterAISignificance::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterAISignificance, STATGROUP_Tickables);
+}
+
+void UShooterAISignificance::RegisterNPC(AShooterNPC* NPC)
+{
+	if (!NPC || NPCs.Contains(NPC))
+	{
+		return;
+	}
+
+	NPCs.Add(NPC);
+	NPCTiers.Add(0);
+	PromotedUntil.Add(0.0);
+
+	// start in the top tier until the next update places it
+	SetTier(NPCs.Num() - 1, 0);
+}
+
+void UShooterAISignificance::UnregisterNPC(AShooterNPC* NPC)
+{
+	const int32 Index = NPCs.IndexOfByKey(NPC);
+
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+
+	NPCs.RemoveAtSwap(Index);
+	NPCTiers.RemoveAtSwap(Index);
+	PromotedUntil.RemoveAtSwap(Index);
+}
+
+void UShooterAISignificance::PromoteNPC(AShooterNPC* NPC)
+{
+	const int32 Index = NPCs.IndexOfByKey(NPC);
+
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+
+	PromotedUntil[Index] = GetWorld()->GetTimeSeconds() + DamagePromotionTime;
+
+	if (NPCTiers[Index] != 0)
+	{
+		SetTier(Index, 0);
+	}
+}
+
+int32 UShooterAISignificance::GetNPCTier(const AShooterNPC* NPC) const
+{
+	const int32 Index = NPCs.IndexOfByKey(NPC);
+
+	return Index != INDEX_NONE ? NPCTiers[Index] : 0;
+}
+
+void UShooterAISignificance::UpdateTiers()
+{
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_ShooterAITasks);
+
+	if (Tiers.Num() == 0)
+	{
+		return;
+	}
+
+	// gather the human players' views
+	TArray<TPair<FVector, FVector>, TInlineAllocator<16>> Views;
+
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+
+		if (!PlayerController || !PlayerController->GetPawn())
+		{
+			continue;
+		}
+
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+		Views.Emplace(ViewLocation, ViewRotation.Vector());
+	}
+
+	const int32 LastTier = Tiers.Num() - 1;
+
+	// NPCs out of every player's range drop to the last tier. With nobody watching, as in a bot only match,
+	// there's nothing to be less significant to, so everyone stays in the top tier
+	int32 FallbackTier = Views.Num() > 0 ? LastTier : 0;
+
+	if (ShooterAISignificance::PinnedTier >= 0)
+	{
+		FallbackTier = FMath::Min(ShooterAISignificance::PinnedTier, LastTier);
+	}
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	const float MinViewDot = FMath::Cos(FMath::DegreesToRadians(ViewConeHalfAngle));
+
+	for (int32 Index = 0; Index < NPCs.Num(); ++Index)
+	{
+		const AShooterNPC* NPC = NPCs[Index].Get();
+
+		if (!NPC)
+		{
+			continue;
+		}
+
+		int32 Tier = FallbackTier;
+
+		if (!ShooterAISignificance::Enabled || Now < PromotedUntil[Index])
+		{
+			Tier = 0;
+
+		} else if (ShooterAISignificance::PinnedTier < 0) {
+
+			const FVector Location = NPC->GetActorLocation();
+
+			for (const TPair<FVector, FVector>& View : Views)
+			{
+				const FVector ToNPC = Location - View.Key;
+				const float Distance = ToNPC.Size();
+
+				// first tier the distance qualifies for
+				int32 ViewTier = LastTier;
+
+				for (int32 TierIndex = 0; TierIndex < LastTier; ++TierIndex)
+				{
+					if (Tiers[TierIndex].MaxDistance <= 0.0f || Distance <= Tiers[TierIndex].MaxDistance)
+					{
+						ViewTier = TierIndex;
+						break;
+					}
+				}
+
+				// NPCs the player is looking at count one tier closer
+				if (ViewTier > 0 && FVector::DotProduct(ToNPC.GetSafeNormal(), View.Value) >= MinViewDot)
+				{
+					--ViewTier;
+				}
+
+				Tier = FMath::Min(Tier, ViewTier);
+			}
+		}
+
+		if (Tier != NPCTiers[Index])
+		{
+			SetTier(Index, Tier);
+		}
+	}
+}
+
+void UShooterAISignificance::SetTier(int32 Index, int32 Tier)
+{
+	NPCTiers[Index] = static_cast<uint8>(Tier);
+
+	if (AShooterNPC* NPC = NPCs[Index].Get())
+	{
+		NPC->ApplyAITier(Tiers.IsValidIndex(Tier) ? Tiers[Tier] : FShooterAITierSettings());
+	}
+}
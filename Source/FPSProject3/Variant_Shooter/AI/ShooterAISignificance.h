@@ -0,0 +1,115 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterAISignificance.generated.h"
+
+class AShooterNPC;
+
+/**
+ *  Update rates for NPCs in one significance tier
+ */
+USTRUCT()
+struct FShooterAITierSettings
+{
+	GENERATED_BODY()
+
+	/** NPCs closer than this to a player, or visible to one within it, qualify for the tier. 0 means no limit */
+	UPROPERTY(Config)
+	float MaxDistance = 0.0f;
+
+	/** Seconds between StateTree ticks. 0 ticks every frame */
+	UPROPERTY(Config)
+	float StateTreeTickInterval = 0.0f;
+
+	/** Min seconds between processed perception stimuli. Stimuli from the current target are never held back */
+	UPROPERTY(Config)
+	float PerceptionInterval = 0.0f;
+
+	/** Max number of vertical line of sight checks against a target */
+	UPROPERTY(Config)
+	int32 MaxLineOfSightChecks = 5;
+
+	/** If false, shots aim at the unobstructed aim point instead of tracing for it */
+	UPROPERTY(Config)
+	bool bTraceAim = true;
+};
+
+/**
+ *  AI significance manager
+ *  Sorts the NPCs into tiers by distance to the human players, counting NPCs in a player's view as one tier
+ *  closer, and lowers the StateTree tick rate, perception rate and traces of the less significant tiers.
+ *  Damaged NPCs are promoted to the top tier straight away and held there for a while. Without any human
+ *  players every NPC runs in the top tier, unless Shooter.AI.PinnedTier fixes the tier. Server only
+ */
+UCLASS(Config=Game)
+class FPSPROJECT3_API UShooterAISignificance : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	/** Registered NPCs */
+	TArray<TWeakObjectPtr<AShooterNPC>> NPCs;
+
+	/** Current tier of each NPC */
+	TArray<uint8> NPCTiers;
+
+	/** Time each NPC's damage promotion runs out */
+	TArray<double> PromotedUntil;
+
+	/** Time since the tiers were last updated */
+	float UpdateAccumulator = 0.0f;
+
+protected:
+
+	/** Tiers, most significant first. An NPC falls into the first tier it qualifies for, or the last one */
+	UPROPERTY(Config)
+	TArray<FShooterAITierSettings> Tiers;
+
+	/** Seconds between tier updates */
+	UPROPERTY(Config)
+	float UpdateInterval = 0.5f;
+
+	/** Half angle of a player's view cone, in degrees */
+	UPROPERTY(Config)
+	float ViewConeHalfAngle = 60.0f;
+
+	/** Seconds a damaged NPC stays in the top tier */
+	UPROPERTY(Config)
+	float DamagePromotionTime = 5.0f;
+
+public:
+
+	/** Sets up the default tiers */
+	UShooterAISignificance();
+
+	/** Only run in game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Updates the tiers on the update interval */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Returns the stat id for this tickable */
+	virtual TStatId GetStatId() const override;
+
+	/** Starts managing an NPC. It starts in the top tier. Server only */
+	void RegisterNPC(AShooterNPC* NPC);
+
+	/** Stops managing an NPC */
+	void UnregisterNPC(AShooterNPC* NPC);
+
+	/** Moves an NPC to the top tier right away and keeps it there for the promotion time */
+	void PromoteNPC(AShooterNPC* NPC);
+
+	/** Returns the NPC's tier, 0 being the most significant */
+	int32 GetNPCTier(const AShooterNPC* NPC) const;
+
+protected:
+
+	/** Recomputes every NPC's tier */
+	void UpdateTiers();
+
+	/** Moves an NPC to a tier and applies its update rates */
+	void SetTier(int32 Index, int32 Tier);
+};
@@ -0,0 +1,292 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Variant_Shooter/AI/ShooterCrowd.h"
+#include "Variant_Shooter/AI/ShooterCrowdFragments.h"
+#include "Variant_Shooter/AI/ShooterCrowdProcessors.h"
+#include "Variant_Shooter/AI/ShooterNPC.h"
+#include "Variant_Shooter/ShooterGameMode.h"
+#include "Variant_Shooter/ShooterStats.h"
+#include "MassEntitySubsystem.h"
+#include "MassEntityManager.h"
+#include "MassExecutor.h"
+#include "MassProcessingContext.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+
+bool UShooterCrowd::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UShooterCrowd::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Collection.InitializeDependency<UMassEntitySubsystem>();
+}
+
+void UShooterCrowd::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// agents only live on the server
+	if (InWorld.GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	UMassEntitySubsystem* EntitySubsystem = InWorld.GetSubsystem<UMassEntitySubsystem>();
+
+	if (!EntitySubsystem)
+	{
+		return;
+	}
+
+	FMassEntityManager& EntityManager = EntitySubsystem->GetMutableEntityManager();
+
+	AgentArchetype = EntityManager.CreateArchetype({
+		FShooterCrowdAgentFragment::StaticStruct(),
+		FShooterCrowdTargetFragment::StaticStruct(),
+		FShooterCrowdCombatFragment::StaticStruct(),
+		FShooterCrowdAgentTag::StaticStruct()
+	});
+
+	// targets are picked before the shots, and the hits are applied after them so no processor writes another agent's fragments.
+	// Movement goes last so shots use the positions the targets were picked with
+	Processors.Add(NewObject<UShooterCrowdTargetingProcessor>(this));
+	Processors.Add(NewObject<UShooterCrowdShootingProcessor>(this));
+	Processors.Add(NewObject<UShooterCrowdDamageProcessor>(this));
+	Processors.Add(NewObject<UShooterCrowdMovementProcessor>(this));
+
+	for (UMassProcessor* Processor : Processors)
+	{
+		Processor->CallInitialize(this, EntityManager.AsShared());
+	}
+
+	// stream the NPC type in instead of hitching the match start. Agents just stay agents until it arrives
+	if (!NPCClass.IsNull())
+	{
+		NPCClassHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(NPCClass.ToSoftObjectPath(), FStreamableDelegate::CreateWeakLambda(this, [this]()
+		{
+			LoadedNPCClass = NPCClass.Get();
+		}));
+	}
+
+	bActive = true;
+}
+
+void UShooterCrowd::Deinitialize()
+{
+	if (NPCClassHandle.IsValid())
+	{
+		NPCClassHandle->CancelHandle();
+		NPCClassHandle.Reset();
+	}
+
+	Super::Deinitialize();
+}
+
+void UShooterCrowd::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_ShooterAICrowd);
+
+	UMassEntitySubsystem* EntitySubsystem = GetWorld()->GetSubsystem<UMassEntitySubsystem>();
+
+	if (!EntitySubsystem)
+	{
+		return;
+	}
+
+	FMassEntityManager& EntityManager = EntitySubsystem->GetMutableEntityManager();
+
+	if (Agents.Num() > 0)
+	{
+		FMassProcessingContext ProcessingContext(EntityManager, DeltaTime);
+		UE::Mass::Executor::RunProcessorsView(Processors, ProcessingContext);
+	}
+
+	LODAccumulator += DeltaTime;
+
+	if (LODAccumulator >= LODInterval)
+	{
+		LODAccumulator = 0.0f;
+		UpdateLOD(EntityManager);
+	}
+}
+
+TStatId UShooterCrowd::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterCrowd, STATGROUP_Tickables);
+}
+
+FMassEntityHandle UShooterCrowd::SpawnAgent(const FVector& Location, uint8 TeamByte, float Health)
+{
+	if (!bActive)
+	{
+		return FMassEntityHandle();
+	}
+
+	FMassEntityManager& EntityManager = GetWorld()->GetSubsystem<UMassEntitySubsystem>()->GetMutableEntityManager();
+
+	const FMassEntityHandle Agent = EntityManager.CreateEntity(AgentArchetype);
+
+	FShooterCrowdAgentFragment& AgentFragment = EntityManager.GetFragmentDataChecked<FShooterCrowdAgentFragment>(Agent);
+	AgentFragment.Location = Location;
+	AgentFragment.Home = Location;
+	AgentFragment.WanderDestination = Location;
+	AgentFragment.TeamByte = TeamByte;
+
+	// spread the target searches over the retarget interval
+	EntityManager.GetFragmentDataChecked<FShooterCrowdTargetFragment>(Agent).RetargetCooldown = FMath::FRandRange(0.0f, Settings.RetargetInterval);
+
+	EntityManager.GetFragmentDataChecked<FShooterCrowdCombatFragment>(Agent).Health = Health;
+
+	Agents.Add(Agent);
+
+	INC_DWORD_STAT(STAT_ShooterCrowdAgents);
+
+	return Agent;
+}
+
+void UShooterCrowd::RecordAgentKill(uint8 TeamByte)
+{
+	++NumAgentKills;
+
+	// score the same way a dying NPC does
+	if (AShooterGameMode* GM = Cast<AShooterGameMode>(GetWorld()->GetAuthGameMode()))
+	{
+		GM->IncrementTeamScore(TeamByte);
+	}
+}
+
+void UShooterCrowd::UpdateLOD(FMassEntityManager& EntityManager)
+{
+	// drop the agents killed since the last update
+	const int32 NumAgentsBefore = Agents.Num();
+	Agents.RemoveAllSwap([&EntityManager](const FMassEntityHandle& Agent) { return !EntityManager.IsEntityValid(Agent); });
+	DEC_DWORD_STAT_BY(STAT_ShooterCrowdAgents, NumAgentsBefore - Agents.Num());
+
+	// dead NPCs are on their way out, they don't come back as agents
+	UpgradedNPCs.RemoveAllSwap([](const TWeakObjectPtr<AShooterNPC>& NPC) { return !NPC.IsValid() || NPC->IsDead(); });
+
+	// gather the human players' locations
+	TArray<FVector, TInlineAllocator<16>> PlayerLocations;
+
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+
+		if (PlayerController && PlayerController->GetPawn())
+		{
+			PlayerLocations.Add(PlayerController->GetPawn()->GetActorLocation());
+		}
+	}
+
+	// returns the squared distance to the closest player
+	auto ClosestPlayerDistanceSquared = [&PlayerLocations](const FVector& Location)
+	{
+		float Closest = TNumericLimits<float>::Max();
+
+		for (const FVector& PlayerLocation : PlayerLocations)
+		{
+			Closest = FMath::Min(Closest, static_cast<float>(FVector::DistSquared(Location, PlayerLocation)));
+		}
+
+		return Closest;
+	};
+
+	// turn the NPCs everyone walked away from back into agents
+	const float DowngradeDistanceSquared = FMath::Square(DowngradeDistance);
+
+	for (int32 Index = UpgradedNPCs.Num() - 1; Index >= 0; --Index)
+	{
+		AShooterNPC* NPC = UpgradedNPCs[Index].Get();
+
+		if (ClosestPlayerDistanceSquared(NPC->GetActorLocation()) > DowngradeDistanceSquared)
+		{
+			UpgradedNPCs.RemoveAtSwap(Index);
+			DowngradeNPC(NPC);
+		}
+	}
+
+	// upgrade the agents close to a player, up to the actor budget
+	if (!LoadedNPCClass || PlayerLocations.Num() == 0)
+	{
+		return;
+	}
+
+	const float UpgradeDistanceSquared = FMath::Square(UpgradeDistance);
+
+	for (int32 Index = Agents.Num() - 1; Index >= 0 && UpgradedNPCs.Num() < MaxUpgradedNPCs; --Index)
+	{
+		const FMassEntityHandle Agent = Agents[Index];
+		const FShooterCrowdAgentFragment& AgentFragment = EntityManager.GetFragmentDataChecked<FShooterCrowdAgentFragment>(Agent);
+
+		if (ClosestPlayerDistanceSquared(AgentFragment.Location) > UpgradeDistanceSquared)
+		{
+			continue;
+		}
+
+		if (AShooterNPC* NPC = UpgradeAgent(EntityManager, Agent))
+		{
+			Agents.RemoveAtSwap(Index);
+			UpgradedNPCs.Add(NPC);
+
+			DEC_DWORD_STAT(STAT_ShooterCrowdAgents);
+		}
+	}
+}
+
+AShooterNPC* UShooterCrowd::UpgradeAgent(FMassEntityManager& EntityManager, FMassEntityHandle Agent)
+{
+	const FShooterCrowdAgentFragment& AgentFragment = EntityManager.GetFragmentDataChecked<FShooterCrowdAgentFragment>(Agent);
+	const FShooterCrowdTargetFragment& TargetFragment = EntityManager.GetFragmentDataChecked<FShooterCrowdTargetFragment>(Agent);
+	const FShooterCrowdCombatFragment& CombatFragment = EntityManager.GetFragmentDataChecked<FShooterCrowdCombatFragment>(Agent);
+
+	// face the target if there is one
+	const FVector Facing = TargetFragment.bHasTarget ? (TargetFragment.TargetLocation - AgentFragment.Location).GetSafeNormal2D() : FVector::ForwardVector;
+	const FTransform SpawnTransform(Facing.Rotation(), AgentFragment.Location);
+
+	AShooterNPC* NPC = GetWorld()->SpawnActorDeferred<AShooterNPC>(LoadedNPCClass, SpawnTransform, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn);
+
+	if (!NPC)
+	{
+		return nullptr;
+	}
+
+	// set the team before BeginPlay so the weapons and StateTree see it
+	NPC->SetTeamByte(AgentFragment.TeamByte);
+
+	// the SenseEnemies task targets this tag, and skips teammates
+	NPC->Tags.AddUnique(FName("Player"));
+
+	NPC->CurrentHP = CombatFragment.Health;
+
+	NPC->FinishSpawning(SpawnTransform);
+
+	if (!NPC->GetController())
+	{
+		NPC->SpawnDefaultController();
+	}
+
+	EntityManager.DestroyEntity(Agent);
+
+	++NumUpgrades;
+
+	return NPC;
+}
+
+void UShooterCrowd::DowngradeNPC(AShooterNPC* NPC)
+{
+	// keep the NPC's home where it is now, it wanders from there
+	SpawnAgent(NPC->GetActorLocation(), NPC->GetTeamByte(), NPC->CurrentHP);
+
+	NPC->Destroy();
+
+	++NumDowngrades;
+}
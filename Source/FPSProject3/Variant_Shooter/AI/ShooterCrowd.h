@@ -0,0 +1,200 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MassEntityTypes.h"
+#include "ShooterCrowd.generated.h"
+
+class AShooterNPC;
+class UMassProcessor;
+struct FMassEntityManager;
+struct FStreamableHandle;
+
+/**
+ *  Tuning for simulated shooter bots
+ */
+USTRUCT()
+struct FShooterCrowdSettings
+{
+	GENERATED_BODY()
+
+	/** Walking speed */
+	UPROPERTY(Config)
+	float MoveSpeed = 400.0f;
+
+	/** Distance agents look for enemies within */
+	UPROPERTY(Config)
+	float SightRange = 6000.0f;
+
+	/** Distance agents close to before they stop and shoot */
+	UPROPERTY(Config)
+	float EngageRange = 2000.0f;
+
+	/** Max distance agents can hit from */
+	UPROPERTY(Config)
+	float WeaponRange = 3000.0f;
+
+	/** Seconds between shots */
+	UPROPERTY(Config)
+	float FireInterval = 0.3f;
+
+	/** Chance for a shot to hit */
+	UPROPERTY(Config)
+	float HitChance = 0.25f;
+
+	/** Damage of a hit */
+	UPROPERTY(Config)
+	float Damage = 10.0f;
+
+	/** Seconds between target searches */
+	UPROPERTY(Config)
+	float RetargetInterval = 0.5f;
+
+	/** Size of the grid cells agents are bucketed in for target searches */
+	UPROPERTY(Config)
+	float TargetingCellSize = 2000.0f;
+
+	/** Radius around their home agents wander in when they have no target */
+	UPROPERTY(Config)
+	float WanderRadius = 3000.0f;
+};
+
+/**
+ *  Crowd of lightweight shooter bots simulated as Mass entities
+ *  Agents far from the players are plain fragments (position, team, target, health and fire cooldown)
+ *  run through the targeting, shooting, damage and movement processors. Agents that get close to a player are
+ *  upgraded to a full AShooterNPC, which is turned back into an agent once every player is far again.
+ *  Agents only exist on the server and only fight each other. Clients only see the upgraded actors, which
+ *  do all the fighting with players and other actors
+ */
+UCLASS(Config=Game)
+class FPSPROJECT3_API UShooterCrowd : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	/** Processors run each frame, in order */
+	UPROPERTY()
+	TArray<UMassProcessor*> Processors;
+
+	/** Loaded NPC type to upgrade agents to. Agents aren't upgraded until it has streamed in */
+	UPROPERTY()
+	TSubclassOf<AShooterNPC> LoadedNPCClass;
+
+	/** Handle of the NPC type load */
+	TSharedPtr<FStreamableHandle> NPCClassHandle;
+
+	/** Agent entities. Agents killed by the processors are pruned on the next LOD update */
+	TArray<FMassEntityHandle> Agents;
+
+	/** Damage dealt to each agent this frame, queued by the shooting processor for the damage processor */
+	TMap<FMassEntityHandle, float> PendingAgentDamage;
+
+	/** NPCs upgraded from agents */
+	TArray<TWeakObjectPtr<AShooterNPC>> UpgradedNPCs;
+
+	/** Archetype of every agent */
+	FMassArchetypeHandle AgentArchetype;
+
+	/** Time since the last LOD update */
+	float LODAccumulator = 0.0f;
+
+	/** True on the server once the processors are set up */
+	bool bActive = false;
+
+	/** Running totals */
+	int32 NumUpgrades = 0;
+	int32 NumDowngrades = 0;
+	int32 NumAgentKills = 0;
+
+protected:
+
+	/** Agent tuning */
+	UPROPERTY(Config)
+	FShooterCrowdSettings Settings;
+
+	/** NPC type agents are upgraded to near the players */
+	UPROPERTY(Config)
+	TSoftClassPtr<AShooterNPC> NPCClass;
+
+	/** Agents closer than this to a player are upgraded to actors */
+	UPROPERTY(Config)
+	float UpgradeDistance = 5000.0f;
+
+	/** Upgraded NPCs farther than this from every player turn back into agents. Kept above the upgrade distance so NPCs don't flip back and forth */
+	UPROPERTY(Config)
+	float DowngradeDistance = 7000.0f;
+
+	/** Max number of upgraded NPCs alive at once */
+	UPROPERTY(Config)
+	int32 MaxUpgradedNPCs = 32;
+
+	/** Seconds between upgrade and downgrade passes */
+	UPROPERTY(Config)
+	float LODInterval = 0.5f;
+
+public:
+
+	/** Only run in game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Makes sure the entity manager is around */
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	/** Sets up the archetype and processors on the server */
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	/** Cancels the NPC type load */
+	virtual void Deinitialize() override;
+
+	/** Runs the processors and the upgrade and downgrade passes */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Returns the stat id for this tickable */
+	virtual TStatId GetStatId() const override;
+
+	/** Only ticks on the server */
+	virtual bool IsTickable() const override { return bActive; }
+
+	/** Server: creates an agent. Returns an invalid handle if the crowd isn't running */
+	FMassEntityHandle SpawnAgent(const FVector& Location, uint8 TeamByte, float Health = 100.0f);
+
+	/** Returns the agent tuning */
+	const FShooterCrowdSettings& GetSettings() const { return Settings; }
+
+	/** Queues damage to an agent. Applied to the agent's own fragments by the damage processor */
+	void QueueAgentDamage(FMassEntityHandle Agent, float Damage) { PendingAgentDamage.FindOrAdd(Agent) += Damage; }
+
+	/** Hands the damage queued this frame to the damage processor */
+	TMap<FMassEntityHandle, float> TakePendingAgentDamage() { return MoveTemp(PendingAgentDamage); }
+
+	/** Called by the damage processor when an agent is killed */
+	void RecordAgentKill(uint8 TeamByte);
+
+	/** Returns the number of live agents */
+	int32 GetNumAgents() const { return Agents.Num(); }
+
+	/** Returns the number of upgraded NPCs alive */
+	int32 GetNumUpgradedNPCs() const { return UpgradedNPCs.Num(); }
+
+	/** Returns the number of agents upgraded to actors so far */
+	int32 GetNumUpgrades() const { return NumUpgrades; }
+
+	/** Returns the number of NPCs turned back into agents so far */
+	int32 GetNumDowngrades() const { return NumDowngrades; }
+
+	/** Returns the number of agents killed so far */
+	int32 GetNumAgentKills() const { return NumAgentKills; }
+
+protected:
+
+	/** Upgrades agents near the players and downgrades NPCs far from them */
+	void UpdateLOD(FMassEntityManager& EntityManager);
+
+	/** Turns an agent into an actor NPC */
+	AShooterNPC* UpgradeAgent(FMassEntityManager& EntityManager, FMassEntityHandle Agent);
+
+	/** Turns an actor NPC back into an agent */
+	void DowngradeNPC(AShooterNPC* NPC);
+};
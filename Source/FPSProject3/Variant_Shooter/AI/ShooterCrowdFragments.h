@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityTypes.h"
+#include "ShooterCrowdFragments.generated.h"
+
+/**
+ *  Position and team of a simulated shooter bot
+ */
+USTRUCT()
+struct FShooterCrowdAgentFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	/** Current location, at capsule center height like an actor NPC */
+	FVector Location = FVector::ZeroVector;
+
+	/** Location the agent was created at. Wandering stays around it */
+	FVector Home = FVector::ZeroVector;
+
+	/** Location the agent walks to when it has no target */
+	FVector WanderDestination = FVector::ZeroVector;
+
+	/** Team byte, same as AShooterNPC */
+	uint8 TeamByte = 0;
+};
+
+/**
+ *  Enemy agent a simulated shooter bot is engaging
+ */
+USTRUCT()
+struct FShooterCrowdTargetFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	/** Targeted agent */
+	FMassEntityHandle TargetEntity;
+
+	/** Last known target location */
+	FVector TargetLocation = FVector::ZeroVector;
+
+	/** True while the agent has a target */
+	bool bHasTarget = false;
+
+	/** Time left until the agent looks for a target again */
+	float RetargetCooldown = 0.0f;
+};
+
+/**
+ *  Health and weapon state of a simulated shooter bot
+ */
+USTRUCT()
+struct FShooterCrowdCombatFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	/** Current HP. The agent is destroyed when it reaches zero */
+	float Health = 100.0f;
+
+	/** Time left until the agent can fire again */
+	float FireCooldown = 0.0f;
+};
+
+/**
+ *  Marks simulated shooter bots
+ */
+USTRUCT()
+struct FShooterCrowdAgentTag : public FMassTag
+{
+	GENERATED_BODY()
+};
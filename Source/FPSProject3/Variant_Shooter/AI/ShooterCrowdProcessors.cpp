@@ -0,0 +1,367 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Variant_Shooter/AI/ShooterCrowdProcessors.h"
+#include "Variant_Shooter/AI/ShooterCrowd.h"
+#include "Variant_Shooter/AI/ShooterCrowdFragments.h"
+#include "Variant_Shooter/ShooterStats.h"
+#include "MassExecutionContext.h"
+#include "MassEntityManager.h"
+#include "MassCommandBuffer.h"
+
+UShooterCrowdProcessor::UShooterCrowdProcessor()
+{
+	// run by the crowd subsystem, on the game thread next to the actor LOD swaps
+	bAutoRegisterWithProcessingPhases = false;
+	bRequiresGameThreadExecution = true;
+	ExecutionFlags = (int32)(EProcessorExecutionFlags::Server | EProcessorExecutionFlags::Standalone);
+}
+
+UShooterCrowd* UShooterCrowdProcessor::GetCrowd() const
+{
+	return Cast<UShooterCrowd>(GetOuter());
+}
+
+UShooterCrowdTargetingProcessor::UShooterCrowdTargetingProcessor()
+	: EntityQuery(*this)
+{
+}
+
+void UShooterCrowdTargetingProcessor::ConfigureQueries(const TSharedRef<FMassEntityManager>& EntityManager)
+{
+	EntityQuery.AddRequirement<FShooterCrowdAgentFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddRequirement<FShooterCrowdTargetFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddTagRequirement<FShooterCrowdAgentTag>(EMassFragmentPresence::All);
+}
+
+void UShooterCrowdTargetingProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_ShooterAICrowd);
+
+	const UShooterCrowd* Crowd = GetCrowd();
+
+	if (!Crowd)
+	{
+		return;
+	}
+
+	const FShooterCrowdSettings& Settings = Crowd->GetSettings();
+	const float DeltaTime = Context.GetDeltaTimeSeconds();
+	const float SightRangeSquared = FMath::Square(Settings.SightRange);
+	const float CellSize = FMath::Max(1.0f, Settings.TargetingCellSize);
+
+	auto GetCell = [CellSize](const FVector& Location)
+	{
+		return FIntPoint(FMath::FloorToInt32(Location.X / CellSize), FMath::FloorToInt32(Location.Y / CellSize));
+	};
+
+	// snapshot every agent into a grid first so the second pass can search them across chunks
+	struct FAgentSnapshot
+	{
+		FMassEntityHandle Entity;
+		FVector Location;
+		uint8 TeamByte;
+	};
+
+	TArray<FAgentSnapshot> Snapshots;
+	Snapshots.Reserve(EntityQuery.GetNumMatchingEntities());
+
+	TMap<FIntPoint, TArray<int32>> Cells;
+
+	EntityQuery.ForEachEntityChunk(Context, [&](FMassExecutionContext& Context)
+	{
+		const TConstArrayView<FShooterCrowdAgentFragment> Agents = Context.GetFragmentView<FShooterCrowdAgentFragment>();
+
+		for (int32 EntityIndex = 0; EntityIndex < Context.GetNumEntities(); ++EntityIndex)
+		{
+			const int32 SnapshotIndex = Snapshots.Add({ Context.GetEntity(EntityIndex), Agents[EntityIndex].Location, Agents[EntityIndex].TeamByte });
+
+			Cells.FindOrAdd(GetCell(Agents[EntityIndex].Location)).Add(SnapshotIndex);
+		}
+	});
+
+	EntityQuery.ForEachEntityChunk(Context, [&](FMassExecutionContext& Context)
+	{
+		const TConstArrayView<FShooterCrowdAgentFragment> Agents = Context.GetFragmentView<FShooterCrowdAgentFragment>();
+		const TArrayView<FShooterCrowdTargetFragment> Targets = Context.GetMutableFragmentView<FShooterCrowdTargetFragment>();
+
+		for (int32 EntityIndex = 0; EntityIndex < Context.GetNumEntities(); ++EntityIndex)
+		{
+			FShooterCrowdTargetFragment& Target = Targets[EntityIndex];
+
+			Target.RetargetCooldown -= DeltaTime;
+
+			if (Target.RetargetCooldown > 0.0f)
+			{
+				continue;
+			}
+
+			Target.RetargetCooldown += Settings.RetargetInterval;
+
+			const FShooterCrowdAgentFragment& Agent = Agents[EntityIndex];
+
+			float BestDistanceSquared = SightRangeSquared;
+			FMassEntityHandle BestEntity;
+			FVector BestLocation = FVector::ZeroVector;
+
+			// nearest enemy agent in the cells within sight range
+			const FIntPoint MinCell = GetCell(Agent.Location - FVector(Settings.SightRange, Settings.SightRange, 0.0f));
+			const FIntPoint MaxCell = GetCell(Agent.Location + FVector(Settings.SightRange, Settings.SightRange, 0.0f));
+
+			for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+			{
+				for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+				{
+					const TArray<int32>* Cell = Cells.Find(FIntPoint(X, Y));
+
+					if (!Cell)
+					{
+						continue;
+					}
+
+					for (const int32 SnapshotIndex : *Cell)
+					{
+						const FAgentSnapshot& Other = Snapshots[SnapshotIndex];
+
+						if (Other.TeamByte == Agent.TeamByte)
+						{
+							continue;
+						}
+
+						const float DistanceSquared = FVector::DistSquared(Agent.Location, Other.Location);
+
+						if (DistanceSquared < BestDistanceSquared)
+						{
+							BestDistanceSquared = DistanceSquared;
+							BestEntity = Other.Entity;
+							BestLocation = Other.Location;
+						}
+					}
+				}
+			}
+
+			Target.TargetEntity = BestEntity;
+			Target.TargetLocation = BestLocation;
+			Target.bHasTarget = BestEntity.IsSet();
+		}
+	});
+}
+
+UShooterCrowdShootingProcessor::UShooterCrowdShootingProcessor()
+	: EntityQuery(*this)
+{
+}
+
+void UShooterCrowdShootingProcessor::ConfigureQueries(const TSharedRef<FMassEntityManager>& EntityManager)
+{
+	EntityQuery.AddRequirement<FShooterCrowdAgentFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddRequirement<FShooterCrowdTargetFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddRequirement<FShooterCrowdCombatFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddTagRequirement<FShooterCrowdAgentTag>(EMassFragmentPresence::All);
+}
+
+void UShooterCrowdShootingProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_ShooterAICrowd);
+
+	UShooterCrowd* Crowd = GetCrowd();
+
+	if (!Crowd)
+	{
+		return;
+	}
+
+	const FShooterCrowdSettings& Settings = Crowd->GetSettings();
+	const float DeltaTime = Context.GetDeltaTimeSeconds();
+	const float WeaponRangeSquared = FMath::Square(Settings.WeaponRange);
+
+	EntityQuery.ForEachEntityChunk(Context, [&](FMassExecutionContext& Context)
+	{
+		const TConstArrayView<FShooterCrowdAgentFragment> Agents = Context.GetFragmentView<FShooterCrowdAgentFragment>();
+		const TArrayView<FShooterCrowdTargetFragment> Targets = Context.GetMutableFragmentView<FShooterCrowdTargetFragment>();
+		const TArrayView<FShooterCrowdCombatFragment> Combats = Context.GetMutableFragmentView<FShooterCrowdCombatFragment>();
+
+		for (int32 EntityIndex = 0; EntityIndex < Context.GetNumEntities(); ++EntityIndex)
+		{
+			FShooterCrowdTargetFragment& Target = Targets[EntityIndex];
+			FShooterCrowdCombatFragment& Combat = Combats[EntityIndex];
+
+			// dead agents are destroyed at the end of the frame, they don't get to shoot back
+			if (Combat.Health <= 0.0f)
+			{
+				continue;
+			}
+
+			Combat.FireCooldown = FMath::Max(0.0f, Combat.FireCooldown - DeltaTime);
+
+			if (!Target.bHasTarget)
+			{
+				continue;
+			}
+
+			// follow the target, dropping it if it's gone. The target's fragments are only read here, hits go through the crowd
+			const bool bTargetValid = EntityManager.IsEntityValid(Target.TargetEntity);
+			const FShooterCrowdAgentFragment* TargetAgent = bTargetValid ? EntityManager.GetFragmentDataPtr<FShooterCrowdAgentFragment>(Target.TargetEntity) : nullptr;
+			const FShooterCrowdCombatFragment* TargetCombat = bTargetValid ? EntityManager.GetFragmentDataPtr<FShooterCrowdCombatFragment>(Target.TargetEntity) : nullptr;
+
+			if (!TargetAgent || !TargetCombat || TargetCombat->Health <= 0.0f)
+			{
+				Target.bHasTarget = false;
+				continue;
+			}
+
+			Target.TargetLocation = TargetAgent->Location;
+
+			const FShooterCrowdAgentFragment& Agent = Agents[EntityIndex];
+
+			if (Combat.FireCooldown > 0.0f || FVector::DistSquared(Agent.Location, Target.TargetLocation) > WeaponRangeSquared)
+			{
+				continue;
+			}
+
+			Combat.FireCooldown = Settings.FireInterval;
+
+			// a hit roll stands in for the shot trace
+			if (FMath::FRand() > Settings.HitChance)
+			{
+				continue;
+			}
+
+			Crowd->QueueAgentDamage(Target.TargetEntity, Settings.Damage);
+		}
+	});
+}
+
+UShooterCrowdDamageProcessor::UShooterCrowdDamageProcessor()
+	: EntityQuery(*this)
+{
+}
+
+void UShooterCrowdDamageProcessor::ConfigureQueries(const TSharedRef<FMassEntityManager>& EntityManager)
+{
+	EntityQuery.AddRequirement<FShooterCrowdAgentFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddRequirement<FShooterCrowdCombatFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddTagRequirement<FShooterCrowdAgentTag>(EMassFragmentPresence::All);
+}
+
+void UShooterCrowdDamageProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_ShooterAICrowd);
+
+	UShooterCrowd* Crowd = GetCrowd();
+
+	if (!Crowd)
+	{
+		return;
+	}
+
+	const TMap<FMassEntityHandle, float> PendingDamage = Crowd->TakePendingAgentDamage();
+
+	if (PendingDamage.Num() == 0)
+	{
+		return;
+	}
+
+	EntityQuery.ForEachEntityChunk(Context, [&](FMassExecutionContext& Context)
+	{
+		const TConstArrayView<FShooterCrowdAgentFragment> Agents = Context.GetFragmentView<FShooterCrowdAgentFragment>();
+		const TArrayView<FShooterCrowdCombatFragment> Combats = Context.GetMutableFragmentView<FShooterCrowdCombatFragment>();
+
+		for (int32 EntityIndex = 0; EntityIndex < Context.GetNumEntities(); ++EntityIndex)
+		{
+			const FMassEntityHandle Entity = Context.GetEntity(EntityIndex);
+			const float* Damage = PendingDamage.Find(Entity);
+
+			FShooterCrowdCombatFragment& Combat = Combats[EntityIndex];
+
+			// agents that already died are on their way out
+			if (!Damage || Combat.Health <= 0.0f)
+			{
+				continue;
+			}
+
+			Combat.Health -= *Damage;
+
+			if (Combat.Health <= 0.0f)
+			{
+				Crowd->RecordAgentKill(Agents[EntityIndex].TeamByte);
+
+				Context.Defer().DestroyEntity(Entity);
+			}
+		}
+	});
+}
+
+UShooterCrowdMovementProcessor::UShooterCrowdMovementProcessor()
+	: EntityQuery(*this)
+{
+}
+
+void UShooterCrowdMovementProcessor::ConfigureQueries(const TSharedRef<FMassEntityManager>& EntityManager)
+{
+	EntityQuery.AddRequirement<FShooterCrowdAgentFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddRequirement<FShooterCrowdTargetFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddTagRequirement<FShooterCrowdAgentTag>(EMassFragmentPresence::All);
+}
+
+void UShooterCrowdMovementProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_ShooterAICrowd);
+
+	const UShooterCrowd* Crowd = GetCrowd();
+
+	if (!Crowd)
+	{
+		return;
+	}
+
+	const FShooterCrowdSettings& Settings = Crowd->GetSettings();
+	const float Step = Settings.MoveSpeed * Context.GetDeltaTimeSeconds();
+
+	EntityQuery.ForEachEntityChunk(Context, [&](FMassExecutionContext& Context)
+	{
+		const TArrayView<FShooterCrowdAgentFragment> Agents = Context.GetMutableFragmentView<FShooterCrowdAgentFragment>();
+		const TConstArrayView<FShooterCrowdTargetFragment> Targets = Context.GetFragmentView<FShooterCrowdTargetFragment>();
+
+		for (int32 EntityIndex = 0; EntityIndex < Context.GetNumEntities(); ++EntityIndex)
+		{
+			FShooterCrowdAgentFragment& Agent = Agents[EntityIndex];
+			const FShooterCrowdTargetFragment& Target = Targets[EntityIndex];
+
+			FVector Destination;
+			float StopDistance;
+
+			if (Target.bHasTarget)
+			{
+				// close in until the target is in engagement range
+				Destination = Target.TargetLocation;
+				StopDistance = Settings.EngageRange;
+
+			} else {
+
+				// pick a new wander point around home once the last one is reached
+				if (FVector::DistSquared2D(Agent.Location, Agent.WanderDestination) <= FMath::Square(Step))
+				{
+					const FVector2D Offset = FMath::RandPointInCircle(Settings.WanderRadius);
+					Agent.WanderDestination = Agent.Home + FVector(Offset.X, Offset.Y, 0.0f);
+				}
+
+				Destination = Agent.WanderDestination;
+				StopDistance = 0.0f;
+			}
+
+			// agents have no navigation, they walk straight and keep their height
+			FVector ToDestination = Destination - Agent.Location;
+			ToDestination.Z = 0.0f;
+
+			const float Distance = ToDestination.Size();
+
+			if (Distance <= StopDistance)
+			{
+				continue;
+			}
+
+			Agent.Location += ToDestination / Distance * FMath::Min(Step, Distance - StopDistance);
+		}
+	});
+}
@@ -0,0 +1,131 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassProcessor.h"
+#include "MassEntityQuery.h"
+#include "ShooterCrowdProcessors.generated.h"
+
+class UShooterCrowd;
+
+/**
+ *  Base for the shooter crowd processors
+ *  They're owned and run by UShooterCrowd on the server game thread instead of the Mass processing phases
+ */
+UCLASS(Abstract)
+class FPSPROJECT3_API UShooterCrowdProcessor : public UMassProcessor
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Constructor */
+	UShooterCrowdProcessor();
+
+protected:
+
+	/** Returns the crowd that owns this processor */
+	UShooterCrowd* GetCrowd() const;
+};
+
+/**
+ *  Picks the nearest enemy agent for every agent. Agents are bucketed in a grid so a search only looks at the cells in sight range
+ */
+UCLASS()
+class FPSPROJECT3_API UShooterCrowdTargetingProcessor : public UShooterCrowdProcessor
+{
+	GENERATED_BODY()
+
+	/** Agents and their targets */
+	FMassEntityQuery EntityQuery;
+
+public:
+
+	/** Constructor */
+	UShooterCrowdTargetingProcessor();
+
+protected:
+
+	/** Sets up the query */
+	virtual void ConfigureQueries(const TSharedRef<FMassEntityManager>& EntityManager) override;
+
+	/** Retargets the agents whose retarget cooldown ran out */
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+};
+
+/**
+ *  Fires at the agents' targets on their weapon cooldown
+ *  Shots are resolved as a hit roll instead of a trace. Hits are queued on the crowd for the damage processor
+ */
+UCLASS()
+class FPSPROJECT3_API UShooterCrowdShootingProcessor : public UShooterCrowdProcessor
+{
+	GENERATED_BODY()
+
+	/** Agents, their targets and weapons */
+	FMassEntityQuery EntityQuery;
+
+public:
+
+	/** Constructor */
+	UShooterCrowdShootingProcessor();
+
+protected:
+
+	/** Sets up the query */
+	virtual void ConfigureQueries(const TSharedRef<FMassEntityManager>& EntityManager) override;
+
+	/** Tracks the targets and fires at the ones in range */
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+};
+
+/**
+ *  Applies the hits queued by the shooting processor, each agent to its own fragments, and destroys the agents that die
+ */
+UCLASS()
+class FPSPROJECT3_API UShooterCrowdDamageProcessor : public UShooterCrowdProcessor
+{
+	GENERATED_BODY()
+
+	/** Agents and their health */
+	FMassEntityQuery EntityQuery;
+
+public:
+
+	/** Constructor */
+	UShooterCrowdDamageProcessor();
+
+protected:
+
+	/** Sets up the query */
+	virtual void ConfigureQueries(const TSharedRef<FMassEntityManager>& EntityManager) override;
+
+	/** Applies the queued damage */
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+};
+
+/**
+ *  Moves the agents into engagement range of their targets, or wanders around their home when they have none
+ */
+UCLASS()
+class FPSPROJECT3_API UShooterCrowdMovementProcessor : public UShooterCrowdProcessor
+{
+	GENERATED_BODY()
+
+	/** Agents and their targets */
+	FMassEntityQuery EntityQuery;
+
+public:
+
+	/** Constructor */
+	UShooterCrowdMovementProcessor();
+
+protected:
+
+	/** Sets up the query */
+	virtual void ConfigureQueries(const TSharedRef<FMassEntityManager>& EntityManager) override;
+
+	/** Moves the agents */
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+};
@@ -0,0 +1,214 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Variant_Shooter/AI/ShooterLineOfSight.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+#include "Variant_Shooter/ShooterStats.h"
+
+namespace ShooterLineOfSight
+{
+	static float MaxAge = 0.2f;
+	static FAutoConsoleVariableRef CVarMaxAge(
+		TEXT("Shooter.AI.LineOfSightMaxAge"),
+		MaxAge,
+		TEXT("Seconds a cached AI line of sight answer is used before it's traced again"));
+
+	static int32 MaxRefreshesPerFrame = 32;
+	static FAutoConsoleVariableRef CVarMaxRefreshesPerFrame(
+		TEXT("Shooter.AI.LineOfSightRefreshesPerFrame"),
+		MaxRefreshesPerFrame,
+		TEXT("Max number of AI line of sight pairs whose async traces are dispatched each frame"));
+
+	/** Seconds an entry is kept without being asked for */
+	static constexpr float UnusedEntryTime = 2.0f;
+
+	/** Seconds between sweeps for unused entries */
+	static constexpr float PruneInterval = 1.0f;
+}
+
+bool UShooterLineOfSight::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UShooterLineOfSight::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	TraceDelegate.BindUObject(this, &UShooterLineOfSight::OnTraceCompleted);
+}
+
+void UShooterLineOfSight::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_ShooterAITasks);
+
+	// dispatch the oldest requests first
+	const int32 NumToDispatch = FMath::Min(Queue.Num(), FMath::Max(1, ShooterLineOfSight::MaxRefreshesPerFrame));
+
+	for (int32 Index = 0; Index < NumToDispatch; ++Index)
+	{
+		if (FShooterLineOfSightEntry* Entry = Entries.Find(Queue[Index]))
+		{
+			DispatchRefresh(Queue[Index], *Entry);
+		}
+	}
+
+	Queue.RemoveAt(0, NumToDispatch, EAllowShrinking::No);
+
+	PruneAccumulator += DeltaTime;
+
+	if (PruneAccumulator >= ShooterLineOfSight::PruneInterval)
+	{
+		PruneAccumulator = 0.0f;
+		PruneEntries();
+	}
+}
+
+TStatId UShooterLineOfSight::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterLineOfSight, STATGROUP_Tickables);
+}
+
+bool UShooterLineOfSight::GetLineOfSight(AActor* Observer, AActor* Target, const FVector& ViewLocation, int32 NumChecks, bool& bOutHasLineOfSight)
+{
+	bOutHasLineOfSight = false;
+
+	if (!IsValid(Observer) || !IsValid(Target))
+	{
+		return false;
+	}
+
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	FShooterLineOfSightEntry& Entry = Entries.FindOrAdd(FShooterLineOfSightKey(Observer, Target));
+	Entry.LastQueryTime = Now;
+
+	// refresh from wherever the observer is looking from now
+	Entry.ViewLocation = ViewLocation;
+	Entry.NumChecks = NumChecks;
+
+	if (!Entry.bPending && (!Entry.bHasResult || Now - Entry.ResultTime > ShooterLineOfSight::MaxAge))
+	{
+		Entry.bPending = true;
+		Queue.Emplace(Observer, Target);
+	}
+
+	bOutHasLineOfSight = Entry.bHasLineOfSight;
+
+	return Entry.bHasResult;
+}
+
+bool UShooterLineOfSight::GetCachedLineOfSight(AActor* Observer, AActor* Target, bool& bOutHasLineOfSight) const
+{
+	bOutHasLineOfSight = false;
+
+	const FShooterLineOfSightEntry* Entry = Entries.Find(FShooterLineOfSightKey(Observer, Target));
+
+	if (!Entry || !Entry->bHasResult || GetWorld()->GetTimeSeconds() - Entry->ResultTime > ShooterLineOfSight::MaxAge)
+	{
+		return false;
+	}
+
+	bOutHasLineOfSight = Entry->bHasLineOfSight;
+
+	return true;
+}
+
+void UShooterLineOfSight::DispatchRefresh(const FShooterLineOfSightKey& Key, FShooterLineOfSightEntry& Entry)
+{
+	AActor* Observer = Key.Key.Get();
+	AActor* Target = Key.Value.Get();
+
+	if (!Observer || !Target)
+	{
+		Entry.bPending = false;
+		return;
+	}
+
+	// spread the end points over the target's height, from the top down
+	FVector CenterOfMass, Extent;
+	Target->GetActorBounds(true, CenterOfMass, Extent, false);
+
+	const int32 NumTraces = Entry.NumChecks - 1;
+
+	if (NumTraces <= 0)
+	{
+		Entry.bHasLineOfSight = false;
+		Entry.bHasResult = true;
+		Entry.bPending = false;
+		Entry.ResultTime = GetWorld()->GetTimeSeconds();
+		return;
+	}
+
+	const float ExtentZOffset = Extent.Z * 2.0f / Entry.NumChecks;
+
+	// ignore the observer and target. We want an unobstructed trace not counting them
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ShooterLineOfSight), false);
+	QueryParams.AddIgnoredActor(Observer);
+	QueryParams.AddIgnoredActor(Target);
+
+	const uint32 BatchId = ++LastBatchId;
+
+	FShooterLineOfSightBatch& Batch = InFlight.Add(BatchId);
+	Batch.Key = Key;
+	Batch.TracesLeft = NumTraces;
+
+	for (int32 i = 0; i < NumTraces; ++i)
+	{
+		const FVector End = CenterOfMass + FVector(0.0f, 0.0f, Extent.Z - ExtentZOffset * i);
+
+		INC_DWORD_STAT(STAT_ShooterTraces);
+		GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Single, Entry.ViewLocation, End, ECC_Visibility, QueryParams, FCollisionResponseParams::DefaultResponseParam, &TraceDelegate, BatchId);
+	}
+}
+
+void UShooterLineOfSight::OnTraceCompleted(const FTraceHandle& Handle, FTraceDatum& Datum)
+{
+	FShooterLineOfSightBatch* Batch = InFlight.Find(Datum.UserData);
+
+	if (!Batch)
+	{
+		return;
+	}
+
+	// we only need one unobstructed trace
+	const bool bBlocked = Datum.OutHits.ContainsByPredicate([](const FHitResult& Hit) { return Hit.bBlockingHit; });
+
+	Batch->bClear |= !bBlocked;
+
+	if (--Batch->TracesLeft > 0)
+	{
+		return;
+	}
+
+	if (FShooterLineOfSightEntry* Entry = Entries.Find(Batch->Key))
+	{
+		Entry->bHasLineOfSight = Batch->bClear;
+		Entry->bHasResult = true;
+		Entry->bPending = false;
+		Entry->ResultTime = GetWorld()->GetTimeSeconds();
+	}
+
+	InFlight.Remove(Datum.UserData);
+}
+
+void UShooterLineOfSight::PruneEntries()
+{
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	for (auto It = Entries.CreateIterator(); It; ++It)
+	{
+		const bool bActorsGone = !It->Key.Key.IsValid() || !It->Key.Value.IsValid();
+		const bool bUnused = !It->Value.bPending && Now - It->Value.LastQueryTime > ShooterLineOfSight::UnusedEntryTime;
+
+		// pending entries of destroyed actors are dropped too, their batches find nothing to write to
+		if (bActorsGone || bUnused)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
@@ -0,0 +1,117 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "WorldCollision.h"
+#include "ShooterLineOfSight.generated.h"
+
+/** Observer and target a line of sight answer is cached for */
+using FShooterLineOfSightKey = TPair<TWeakObjectPtr<AActor>, TWeakObjectPtr<AActor>>;
+
+/**
+ *  Cached line of sight between an observer and a target
+ */
+struct FShooterLineOfSightEntry
+{
+	/** Observer eye location the next refresh traces from */
+	FVector ViewLocation = FVector::ZeroVector;
+
+	/** Number of vertically offset points on the target to trace to */
+	int32 NumChecks = 0;
+
+	/** Last answer */
+	bool bHasLineOfSight = false;
+
+	/** True once the first refresh has completed */
+	bool bHasResult = false;
+
+	/** True while the entry is queued or its traces are in flight */
+	bool bPending = false;
+
+	/** Time the last answer was traced at */
+	double ResultTime = 0.0;
+
+	/** Time the entry was last asked for. Entries nobody asks for are dropped */
+	double LastQueryTime = 0.0;
+};
+
+/**
+ *  A refresh whose traces are in flight
+ */
+struct FShooterLineOfSightBatch
+{
+	/** Pair being refreshed */
+	FShooterLineOfSightKey Key;
+
+	/** Traces not yet completed */
+	int32 TracesLeft = 0;
+
+	/** True if any completed trace was unobstructed */
+	bool bClear = false;
+};
+
+/**
+ *  Line of sight service for AI
+ *  NPCs read a cached answer per observer and target pair. Answers older than the staleness window
+ *  are refreshed in the background through async traces, dispatched in per frame batches,
+ *  so line of sight checks don't run synchronous traces on the game thread
+ */
+UCLASS()
+class FPSPROJECT3_API UShooterLineOfSight : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	/** Cached answers */
+	TMap<FShooterLineOfSightKey, FShooterLineOfSightEntry> Entries;
+
+	/** Pairs waiting for their traces to be dispatched, oldest first */
+	TArray<FShooterLineOfSightKey> Queue;
+
+	/** Refreshes with traces in flight, by id */
+	TMap<uint32, FShooterLineOfSightBatch> InFlight;
+
+	/** Id of the last dispatched refresh */
+	uint32 LastBatchId = 0;
+
+	/** Time since unused entries were last dropped */
+	float PruneAccumulator = 0.0f;
+
+	/** Trace completion delegate */
+	FTraceDelegate TraceDelegate;
+
+public:
+
+	/** Only run in game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Binds the trace delegate */
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	/** Dispatches the queued refreshes */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Returns the stat id for this tickable */
+	virtual TStatId GetStatId() const override;
+
+	/**
+	 *  Returns the cached line of sight from the observer's view location to any of NumChecks points spread over the target's height.
+	 *  Queues a refresh if the answer is missing or stale. Returns false if no answer has been traced yet
+	 */
+	bool GetLineOfSight(AActor* Observer, AActor* Target, const FVector& ViewLocation, int32 NumChecks, bool& bOutHasLineOfSight);
+
+	/** Returns true if the observer has a fresh cached answer for the target, without queuing a refresh */
+	bool GetCachedLineOfSight(AActor* Observer, AActor* Target, bool& bOutHasLineOfSight) const;
+
+protected:
+
+	/** Issues the async traces for a queued pair */
+	void DispatchRefresh(const FShooterLineOfSightKey& Key, FShooterLineOfSightEntry& Entry);
+
+	/** Collects an async trace result */
+	void OnTraceCompleted(const FTraceHandle& Handle, FTraceDatum& Datum);
+
+	/** Drops entries that haven't been asked for in a while, or whose actors are gone */
+	void PruneEntries();
+};
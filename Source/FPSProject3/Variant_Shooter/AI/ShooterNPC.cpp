@@ -11,6 +11,9 @@
 #include "Components/CapsuleComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "TimerManager.h"
+#include "ShooterDamageQuery.h"
+#include "ShooterStats.h"
+#include "ShooterAIController.h"
 
 void AShooterNPC::BeginPlay()
 {
@@ -23,24 +26,58 @@ void AShooterNPC::BeginPlay()
 	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
 
 	Weapon = GetWorld()->SpawnActor<AShooterWeapon>(WeaponClass, GetActorTransform(), SpawnParams);
+
+	// make us findable by explosions and other radius queries (server only)
+	if (HasAuthority())
+	{
+		if (UShooterDamageQuery* DamageQuery = GetWorld()->GetSubsystem<UShooterDamageQuery>())
+		{
+			DamageQuery->RegisterActor(this, GetCapsuleComponent(), GetCapsuleComponent()->GetScaledCapsuleRadius());
+		}
+
+		// run our AI at a rate that matches how close the players are
+		if (UShooterAISignificance* Significance = GetWorld()->GetSubsystem<UShooterAISignificance>())
+		{
+			Significance->RegisterNPC(this);
+		}
+	}
 }
 
 void AShooterNPC::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
 	Super::EndPlay(EndPlayReason);
 
+	if (UShooterDamageQuery* DamageQuery = GetWorld()->GetSubsystem<UShooterDamageQuery>())
+	{
+		DamageQuery->UnregisterActor(this);
+	}
+
+	if (UShooterAISignificance* Significance = GetWorld()->GetSubsystem<UShooterAISignificance>())
+	{
+		Significance->UnregisterNPC(this);
+	}
+
 	// clear the death timer
 	GetWorld()->GetTimerManager().ClearTimer(DeathTimer);
 }
 
 float AShooterNPC::TakeDamage(float Damage, struct FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
 {
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_ShooterTakeDamage);
+	INC_DWORD_STAT(STAT_ShooterDamageEvents);
+
 	// ignore if already dead
 	if (bIsDead)
 	{
 		return 0.0f;
 	}
 
+	// react at full rate while we're in a fight
+	if (UShooterAISignificance* Significance = GetWorld()->GetSubsystem<UShooterAISignificance>())
+	{
+		Significance->PromoteNPC(this);
+	}
+
 	// Reduce HP
 	CurrentHP -= Damage;
 
@@ -111,12 +148,19 @@ FVector AShooterNPC::GetWeaponTargetLocation()
 	// calculate the unobstructed aim target location
 	AimTarget = AimSource + (AimDir * AimRange);
 
+	// less significant NPCs skip the trace and let the shot find its own impact
+	if (!AITierSettings.bTraceAim)
+	{
+		return AimTarget;
+	}
+
 	// run a visibility trace to see if there's obstructions
 	FHitResult OutHit;
 
 	FCollisionQueryParams QueryParams;
 	QueryParams.AddIgnoredActor(this);
 
+	INC_DWORD_STAT(STAT_ShooterTraces);
 	GetWorld()->LineTraceSingleByChannel(OutHit, AimSource, AimTarget, ECC_Visibility, QueryParams);
 
 	// return either the impact point or the trace end
@@ -148,6 +192,23 @@ void AShooterNPC::OnSemiWeaponRefire()
 	}
 }
 
+void AShooterNPC::NotifyHitscanImpact(const FVector& TraceStart, const FVector& ImpactPoint, const FVector& ImpactNormal)
+{
+	// send the compact impact event to everyone, including the server
+	Multicast_OnHitscanImpact(TraceStart, ImpactPoint, ImpactNormal);
+}
+
+void AShooterNPC::Multicast_OnHitscanImpact_Implementation(FVector_NetQuantize TraceStart, FVector_NetQuantize ImpactPoint, FVector_NetQuantizeNormal ImpactNormal)
+{
+	INC_DWORD_STAT(STAT_ShooterRPCs);
+
+	// every machine spawns its own copy of the weapon, let it play the effects
+	if (IsValid(Weapon))
+	{
+		Weapon->BP_OnHitscanImpact(TraceStart, ImpactPoint, ImpactNormal);
+	}
+}
+
 void AShooterNPC::Die()
 {
 	// ignore if already dead
@@ -186,6 +247,16 @@ void AShooterNPC::DeferredDestruction()
 	Destroy();
 }
 
+void AShooterNPC::ApplyAITier(const FShooterAITierSettings& Settings)
+{
+	AITierSettings = Settings;
+
+	if (AShooterAIController* AIController = Cast<AShooterAIController>(GetController()))
+	{
+		AIController->ApplyAITier(Settings);
+	}
+}
+
 void AShooterNPC::StartShooting(AActor* ActorToShoot)
 {
 	// save the aim target
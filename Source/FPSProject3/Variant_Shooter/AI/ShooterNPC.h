@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "FPSProject3Character.h"
 #include "ShooterWeaponHolder.h"
+#include "ShooterAISignificance.h"
 #include "ShooterNPC.generated.h"
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FPawnDeathDelegate);
@@ -84,6 +85,9 @@ protected:
 	/** Deferred destruction on death timer */
 	FTimerHandle DeathTimer;
 
+	/** Update rates of the AI significance tier this character is in */
+	FShooterAITierSettings AITierSettings;
+
 public:
 
 	/** Delegate called when this NPC dies */
@@ -133,6 +137,9 @@ public:
 	/** Notifies the owner that the weapon cooldown has expired and it's ready to shoot again */
 	virtual void OnSemiWeaponRefire() override;
 
+	/** Broadcasts the cosmetic result of a server hitscan shot */
+	virtual void NotifyHitscanImpact(const FVector& TraceStart, const FVector& ImpactPoint, const FVector& ImpactNormal) override;
+
 	//~End IShooterWeaponHolder interface
 
 protected:
@@ -143,8 +150,27 @@ protected:
 	/** Called after death to destroy the actor */
 	void DeferredDestruction();
 
+	/** Multicast RPC: play hitscan tracer and impact effects for the weapon on all machines */
+	UFUNCTION(NetMulticast, Unreliable)
+	void Multicast_OnHitscanImpact(FVector_NetQuantize TraceStart, FVector_NetQuantize ImpactPoint, FVector_NetQuantizeNormal ImpactNormal);
+
 public:
 
+	/** Returns the team byte for this character */
+	uint8 GetTeamByte() const { return TeamByte; }
+
+	/** Sets the team byte for this character */
+	void SetTeamByte(uint8 InTeamByte) { TeamByte = InTeamByte; }
+
+	/** Returns true if this character has died */
+	bool IsDead() const { return bIsDead; }
+
+	/** Applies the update rates of an AI significance tier to this character and its controller */
+	void ApplyAITier(const FShooterAITierSettings& Settings);
+
+	/** Returns the update rates of this character's AI significance tier */
+	const FShooterAITierSettings& GetAITierSettings() const { return AITierSettings; }
+
 	/** Signals this character to start shooting at the passed actor */
 	void StartShooting(AActor* ActorToShoot);
 
@@ -0,0 +1,143 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Variant_Shooter/AI/ShooterPerceptionScheduler.h"
+#include "Variant_Shooter/AI/ShooterAIController.h"
+#include "HAL/IConsoleManager.h"
+#include "Variant_Shooter/ShooterStats.h"
+
+namespace ShooterPerceptionScheduler
+{
+	static float BudgetMs = 0.5f;
+	static FAutoConsoleVariableRef CVarBudgetMs(
+		TEXT("Shooter.AI.PerceptionBudgetMs"),
+		BudgetMs,
+		TEXT("Milliseconds per frame spent processing queued AI perception stimuli. At least one stimulus is processed every frame"));
+}
+
+bool UShooterPerceptionScheduler::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UShooterPerceptionScheduler::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (Pending.Num() == 0)
+	{
+		PriorityOrder.Reset();
+		Order.Reset();
+		return;
+	}
+
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_ShooterAITasks);
+
+	const double EndTime = FPlatformTime::Seconds() + ShooterPerceptionScheduler::BudgetMs / 1000.0;
+
+	int32 PriorityCursor = 0;
+	int32 Cursor = 0;
+	bool bProcessedAny = false;
+
+	// current targets first, then everything else, until the budget runs out
+	while (!bProcessedAny || FPlatformTime::Seconds() < EndTime)
+	{
+		if (!ProcessNext(PriorityOrder, PriorityCursor, false) && !ProcessNext(Order, Cursor, true))
+		{
+			break;
+		}
+
+		bProcessedAny = true;
+	}
+
+	PriorityOrder.RemoveAt(0, PriorityCursor, EAllowShrinking::No);
+	Order.RemoveAt(0, Cursor, EAllowShrinking::No);
+
+	// held back stimuli go to the back of the queue
+	Order.Append(Deferred);
+	Deferred.Reset();
+}
+
+TStatId UShooterPerceptionScheduler::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterPerceptionScheduler, STATGROUP_Tickables);
+}
+
+void UShooterPerceptionScheduler::QueueStimulus(AShooterAIController* Controller, AActor* Actor, const FAIStimulus& Stimulus)
+{
+	if (!Controller || !Actor)
+	{
+		return;
+	}
+
+	const FShooterStimulusKey Key(Controller, Actor);
+
+	// stimuli from the current target jump the queue
+	const bool bPriority = Actor == Controller->GetCurrentTarget();
+
+	if (FAIStimulus* Queued = Pending.Find(Key))
+	{
+		// only the latest stimulus matters, keep the queue position
+		*Queued = Stimulus;
+
+		if (bPriority)
+		{
+			PriorityOrder.AddUnique(Key);
+		}
+
+		return;
+	}
+
+	Pending.Add(Key, Stimulus);
+
+	if (bPriority)
+	{
+		PriorityOrder.Add(Key);
+
+	} else {
+
+		Order.Add(Key);
+	}
+}
+
+void UShooterPerceptionScheduler::CancelStimuli(AShooterAIController* Controller, AActor* Actor)
+{
+	// the keys left in the order arrays are skipped once they reach the front
+	Pending.Remove(FShooterStimulusKey(Controller, Actor));
+}
+
+bool UShooterPerceptionScheduler::ProcessNext(TArray<FShooterStimulusKey>& InOrder, int32& Cursor, bool bHonorInterval)
+{
+	while (Cursor < InOrder.Num())
+	{
+		const FShooterStimulusKey Key = InOrder[Cursor++];
+
+		// less significant NPCs process their stimuli less often. Keep it queued until then
+		if (bHonorInterval && Key.Key.IsValid() && !Key.Key->IsPerceptionReady() && Pending.Contains(Key))
+		{
+			Deferred.Add(Key);
+			continue;
+		}
+
+		FAIStimulus Stimulus;
+
+		// processed through the other order, cancelled, or replaced and requeued
+		if (!Pending.RemoveAndCopyValue(Key, Stimulus))
+		{
+			continue;
+		}
+
+		AShooterAIController* Controller = Key.Key.Get();
+		AActor* Actor = Key.Value.Get();
+
+		if (Controller && Actor)
+		{
+			INC_DWORD_STAT(STAT_ShooterAIStimuli);
+			Controller->ProcessPerception(Actor, Stimulus);
+		}
+
+		return true;
+	}
+
+	return false;
+}
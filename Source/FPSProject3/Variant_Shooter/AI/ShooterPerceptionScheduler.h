@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Perception/AIPerceptionTypes.h"
+#include "ShooterPerceptionScheduler.generated.h"
+
+class AShooterAIController;
+
+/** NPC controller and sensed actor a stimulus is queued for */
+using FShooterStimulusKey = TPair<TWeakObjectPtr<AShooterAIController>, TWeakObjectPtr<AActor>>;
+
+/**
+ *  Time sliced AI perception processing
+ *  Perception updates are queued instead of being handled as they arrive. Each NPC keeps only the latest
+ *  stimulus per sensed actor, and the queue is drained under a per frame time budget, stimuli from
+ *  current targets first. Bursts of stimuli, like an explosion heard by a whole squad, are spread over frames
+ */
+UCLASS()
+class FPSPROJECT3_API UShooterPerceptionScheduler : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	/** Latest queued stimulus for each controller and sensed actor */
+	TMap<FShooterStimulusKey, FAIStimulus> Pending;
+
+	/** Stimuli from the controllers' current targets, oldest first */
+	TArray<FShooterStimulusKey> PriorityOrder;
+
+	/** Other stimuli, oldest first */
+	TArray<FShooterStimulusKey> Order;
+
+	/** Stimuli held back this frame by their controller's perception interval */
+	TArray<FShooterStimulusKey> Deferred;
+
+public:
+
+	/** Only run in game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Processes queued stimuli until the frame budget runs out */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Returns the stat id for this tickable */
+	virtual TStatId GetStatId() const override;
+
+	/** Queues a stimulus, replacing any still queued for the same controller and actor */
+	void QueueStimulus(AShooterAIController* Controller, AActor* Actor, const FAIStimulus& Stimulus);
+
+	/** Drops the stimuli queued for a forgotten actor so they can't bring it back */
+	void CancelStimuli(AShooterAIController* Controller, AActor* Actor);
+
+	/** Returns the number of queued stimuli */
+	int32 GetNumPending() const { return Pending.Num(); }
+
+protected:
+
+	/**
+	 *  Processes the next stimulus still queued in the order, advancing the cursor. Returns false once the order is exhausted.
+	 *  If bHonorInterval is set, stimuli of controllers still within their perception interval are deferred to a later frame
+	 */
+	bool ProcessNext(TArray<FShooterStimulusKey>& InOrder, int32& Cursor, bool bHonorInterval);
+};
@@ -8,10 +8,15 @@
 #include "AIController.h"
 #include "Perception/AIPerceptionComponent.h"
 #include "ShooterAIController.h"
+#include "ShooterLineOfSight.h"
+#include "ShooterThreatMap.h"
 #include "StateTreeAsyncExecutionContext.h"
+#include "ShooterStats.h"
 
 bool FStateTreeLineOfSightToTargetCondition::TestCondition(FStateTreeExecutionContext& Context) const
 {
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_ShooterAITasks);
+
 	const FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
 
 	// ensure the target is valid
@@ -32,41 +37,26 @@ bool FStateTreeLineOfSightToTargetCondition::TestCondition(FStateTreeExecutionCo
 		return !InstanceData.bMustHaveLineOfSight;
 	}
 
-	// get the target's bounding box
-	FVector CenterOfMass, Extent;
-	InstanceData.Target->GetActorBounds(true, CenterOfMass, Extent, false);
+	// read the cached answer. Stale answers are refreshed in the background through async traces
+	UShooterLineOfSight* LineOfSight = InstanceData.Character->GetWorld()->GetSubsystem<UShooterLineOfSight>();
 
-	// divide the vertical extent by the number of line of sight checks we'll do
-	const float ExtentZOffset = Extent.Z * 2.0f / InstanceData.NumberOfVerticalLineOfSightChecks;
+	if (!LineOfSight)
+	{
+		return !InstanceData.bMustHaveLineOfSight;
+	}
 
 	// get the character's camera location as the source for the line checks
 	const FVector Start = InstanceData.Character->GetFirstPersonCameraComponent()->GetComponentLocation();
 
-	// ignore the character and target. We want to ensure there's an unobstructed trace not counting them
-	FCollisionQueryParams QueryParams;
-	QueryParams.AddIgnoredActor(InstanceData.Character);
-	QueryParams.AddIgnoredActor(InstanceData.Target);
+	bool bHasLineOfSight = false;
 
-	FHitResult OutHit;
+	// less significant NPCs trace fewer points
+	const int32 NumChecks = FMath::Min(InstanceData.NumberOfVerticalLineOfSightChecks, InstanceData.Character->GetAITierSettings().MaxLineOfSightChecks);
 
-	// run a number of vertically offset line traces to the target location
-	for (int32 i = 0; i < InstanceData.NumberOfVerticalLineOfSightChecks - 1; ++i)
-	{
-		// calculate the endpoint for the trace
-		const FVector End = CenterOfMass + FVector(0.0f, 0.0f, Extent.Z - ExtentZOffset * i);
+	// until the first answer arrives, act as if there's no line of sight
+	LineOfSight->GetLineOfSight(InstanceData.Character, InstanceData.Target, Start, NumChecks, bHasLineOfSight);
 
-		InstanceData.Character->GetWorld()->LineTraceSingleByChannel(OutHit, Start, End, ECC_Visibility, QueryParams);
-
-		// is the trace unobstructed?
-		if (!OutHit.bBlockingHit)
-		{
-			// we only need one unobstructed trace, so terminate early
-			return InstanceData.bMustHaveLineOfSight;
-		}
-	}
-
-	// no line of sight found
-	return !InstanceData.bMustHaveLineOfSight;
+	return bHasLineOfSight == InstanceData.bMustHaveLineOfSight;
 }
 
 #if WITH_EDITOR
@@ -80,6 +70,8 @@ FText FStateTreeLineOfSightToTargetCondition::GetDescription(const FGuid& ID, FS
 
 EStateTreeRunStatus FStateTreeFaceActorTask::EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
 {
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_ShooterAITasks);
+
 	// have we transitioned from another state?
 	if (Transition.ChangeType == EStateTreeStateChangeType::Changed)
 	{
@@ -95,6 +87,8 @@ EStateTreeRunStatus FStateTreeFaceActorTask::EnterState(FStateTreeExecutionConte
 
 void FStateTreeFaceActorTask::ExitState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
 {
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_ShooterAITasks);
+
 	// have we transitioned to another state?
 	if (Transition.ChangeType == EStateTreeStateChangeType::Changed)
 	{
@@ -117,6 +111,8 @@ FText FStateTreeFaceActorTask::GetDescription(const FGuid& ID, FStateTreeDataVie
 
 EStateTreeRunStatus FStateTreeFaceLocationTask::EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
 {
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_ShooterAITasks);
+
 	// have we transitioned from another state?
 	if (Transition.ChangeType == EStateTreeStateChangeType::Changed)
 	{
@@ -132,6 +128,8 @@ EStateTreeRunStatus FStateTreeFaceLocationTask::EnterState(FStateTreeExecutionCo
 
 void FStateTreeFaceLocationTask::ExitState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
 {
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_ShooterAITasks);
+
 	// have we transitioned to another state?
 	if (Transition.ChangeType == EStateTreeStateChangeType::Changed)
 	{
@@ -154,6 +152,8 @@ FText FStateTreeFaceLocationTask::GetDescription(const FGuid& ID, FStateTreeData
 
 EStateTreeRunStatus FStateTreeSetRandomFloatTask::EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
 {
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_ShooterAITasks);
+
 	// have we transitioned to another state?
 	if (Transition.ChangeType == EStateTreeStateChangeType::Changed)
 	{
@@ -178,6 +178,8 @@ FText FStateTreeSetRandomFloatTask::GetDescription(const FGuid& ID, FStateTreeDa
 
 EStateTreeRunStatus FStateTreeShootAtTargetTask::EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
 {
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_ShooterAITasks);
+
 	// have we transitioned from another state?
 	if (Transition.ChangeType == EStateTreeStateChangeType::Changed)
 	{
@@ -193,6 +195,8 @@ EStateTreeRunStatus FStateTreeShootAtTargetTask::EnterState(FStateTreeExecutionC
 
 void FStateTreeShootAtTargetTask::ExitState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
 {
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_ShooterAITasks);
+
 	// have we transitioned to another state?
 	if (Transition.ChangeType == EStateTreeStateChangeType::Changed)
 	{
@@ -213,6 +217,8 @@ FText FStateTreeShootAtTargetTask::GetDescription(const FGuid& ID, FStateTreeDat
 
 EStateTreeRunStatus FStateTreeSenseEnemiesTask::EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
 {
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_ShooterAITasks);
+
 	// have we transitioned from another state?
 	if (Transition.ChangeType == EStateTreeStateChangeType::Changed)
 	{
@@ -223,15 +229,24 @@ EStateTreeRunStatus FStateTreeSenseEnemiesTask::EnterState(FStateTreeExecutionCo
 		InstanceData.Controller->OnShooterPerceptionUpdated.BindLambda(
 			[WeakContext = Context.MakeWeakExecutionContext()](AActor* SensedActor, const FAIStimulus& Stimulus)
 			{
+				SHOOTER_SCOPE_CYCLE_COUNTER(STAT_ShooterAISenseEnemies);
+
 				// get the instance data inside the lambda
 				const FStateTreeStrongExecutionContext StrongContext = WeakContext.MakeStrongExecutionContext();
 
 				if (FInstanceDataType* LambdaInstanceData = StrongContext.GetInstanceDataPtr<FInstanceDataType>())
 				{
-					if (SensedActor->ActorHasTag(LambdaInstanceData->SenseTag))
+					// NPCs never target other NPCs on their own team
+					const AShooterNPC* SensedNPC = Cast<AShooterNPC>(SensedActor);
+					const bool bIsTeammate = SensedNPC && SensedNPC->GetTeamByte() == LambdaInstanceData->Character->GetTeamByte();
+
+					if (!bIsTeammate && SensedActor->ActorHasTag(LambdaInstanceData->SenseTag))
 					{
 						bool bDirectLOS = false;
 
+						const uint8 TeamByte = LambdaInstanceData->Character->GetTeamByte();
+						UShooterThreatMap* ThreatMap = LambdaInstanceData->Character->GetWorld()->GetSubsystem<UShooterThreatMap>();
+
 						// calculate the direction of the stimulus
 						const FVector StimulusDir = (Stimulus.StimulusLocation - LambdaInstanceData->Character->GetActorLocation()).GetSafeNormal();
 
@@ -242,16 +257,42 @@ EStateTreeRunStatus FStateTreeSenseEnemiesTask::EnterState(FStateTreeExecutionCo
 						// is the direction within our perception cone?
 						if (DirDot >= MaxDot)
 						{
-							// run a line trace between the character and the sensed actor
-							FCollisionQueryParams QueryParams;
-							QueryParams.AddIgnoredActor(LambdaInstanceData->Character);
-							QueryParams.AddIgnoredActor(SensedActor);
+							const UShooterLineOfSight* LineOfSight = LambdaInstanceData->Character->GetWorld()->GetSubsystem<UShooterLineOfSight>();
+							bool bCachedLOS = false;
 
-							FHitResult OutHit;
+							// our own recent line of sight check already sees the enemy, no need to trace again
+							if (LineOfSight && LineOfSight->GetCachedLineOfSight(LambdaInstanceData->Character, SensedActor, bCachedLOS) && bCachedLOS)
+							{
+								bDirectLOS = true;
 
-							// we have direct line of sight if this trace is unobstructed
-							bDirectLOS = !LambdaInstanceData->Character->GetWorld()->LineTraceSingleByChannel(OutHit, LambdaInstanceData->Character->GetActorLocation(), SensedActor->GetActorLocation(), ECC_Visibility, QueryParams);
+							} else {
+
+								// run a line trace between the character and the sensed actor
+								FCollisionQueryParams QueryParams;
+								QueryParams.AddIgnoredActor(LambdaInstanceData->Character);
+								QueryParams.AddIgnoredActor(SensedActor);
+
+								FHitResult OutHit;
+								INC_DWORD_STAT(STAT_ShooterTraces);
+
+								// we have direct line of sight if this trace is unobstructed
+								bDirectLOS = !LambdaInstanceData->Character->GetWorld()->LineTraceSingleByChannel(OutHit, LambdaInstanceData->Character->GetActorLocation(), SensedActor->GetActorLocation(), ECC_Visibility, QueryParams);
+							}
 
+							// share what we saw with the team
+							if (bDirectLOS && ThreatMap)
+							{
+								ThreatMap->ReportThreat(TeamByte, SensedActor, SensedActor->GetActorLocation(), true);
+							}
+						}
+
+						// a squad mate having eyes on the enemy only makes it worth checking out first, we still need our own sight to engage
+						const bool bTeamConfirmed = !bDirectLOS && ThreatMap && ThreatMap->IsThreatConfirmed(TeamByte, SensedActor);
+
+						// partial senses still tell the team roughly where the enemy is
+						if (!bDirectLOS && ThreatMap)
+						{
+							ThreatMap->ReportThreat(TeamByte, SensedActor, Stimulus.StimulusLocation, false);
 						}
 
 						// check if we have a direct line of sight to the stimulus
@@ -273,11 +314,11 @@ EStateTreeRunStatus FStateTreeSenseEnemiesTask::EnterState(FStateTreeExecutionCo
 							// if we already have a target, ignore the partial sense and keep on them
 							if (!IsValid(LambdaInstanceData->TargetActor))
 							{
-								// is this stimulus stronger than the last one we had?
-								if (Stimulus.Strength > LambdaInstanceData->LastStimulusStrength)
+								// is this stimulus stronger than the last one we had, or an enemy the team has confirmed?
+								if (bTeamConfirmed || Stimulus.Strength > LambdaInstanceData->LastStimulusStrength)
 								{
 									// update the stimulus strength
-									LambdaInstanceData->LastStimulusStrength = Stimulus.Strength;
+									LambdaInstanceData->LastStimulusStrength = FMath::Max(LambdaInstanceData->LastStimulusStrength, Stimulus.Strength);
 
 									// set the investigate location
 									LambdaInstanceData->InvestigateLocation = Stimulus.StimulusLocation;
@@ -344,8 +385,81 @@ EStateTreeRunStatus FStateTreeSenseEnemiesTask::EnterState(FStateTreeExecutionCo
 	return EStateTreeRunStatus::Running;
 }
 
+EStateTreeRunStatus FStateTreeSenseEnemiesTask::Tick(FStateTreeExecutionContext& Context, const float DeltaTime) const
+{
+	FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
+
+	// only look to the team while we have nothing of our own to chase
+	if (IsValid(InstanceData.TargetActor) || InstanceData.bHasInvestigateLocation)
+	{
+		return EStateTreeRunStatus::Running;
+	}
+
+	InstanceData.TeamThreatQueryCooldown -= DeltaTime;
+
+	if (InstanceData.TeamThreatQueryCooldown > 0.0f)
+	{
+		return EStateTreeRunStatus::Running;
+	}
+
+	InstanceData.TeamThreatQueryCooldown = InstanceData.TeamThreatQueryInterval;
+
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_ShooterAISenseEnemies);
+
+	const UShooterThreatMap* ThreatMap = InstanceData.Character->GetWorld()->GetSubsystem<UShooterThreatMap>();
+
+	if (!ThreatMap)
+	{
+		return EStateTreeRunStatus::Running;
+	}
+
+	FVector LastKnownLocation;
+	bool bConfirmed = false;
+
+	AActor* Threat = ThreatMap->FindBestThreat(InstanceData.Character->GetTeamByte(), InstanceData.Character->GetActorLocation(), InstanceData.TeamThreatRadius, LastKnownLocation, bConfirmed);
+
+	if (!Threat)
+	{
+		return EStateTreeRunStatus::Running;
+	}
+
+	// a squad mate's sighting isn't ours, only engage once our own line of sight clears
+	bool bHasLineOfSight = false;
+
+	if (bConfirmed)
+	{
+		if (UShooterLineOfSight* LineOfSight = InstanceData.Character->GetWorld()->GetSubsystem<UShooterLineOfSight>())
+		{
+			const FVector ViewLocation = InstanceData.Character->GetFirstPersonCameraComponent()->GetComponentLocation();
+			const int32 NumChecks = InstanceData.Character->GetAITierSettings().MaxLineOfSightChecks;
+
+			// queues a refresh when stale, so the next query picks up the answer
+			LineOfSight->GetLineOfSight(InstanceData.Character, Threat, ViewLocation, NumChecks, bHasLineOfSight);
+		}
+	}
+
+	if (bHasLineOfSight)
+	{
+		// join the fight a squad mate is already in
+		InstanceData.Controller->SetCurrentTarget(Threat);
+		InstanceData.TargetActor = Threat;
+		InstanceData.bHasTarget = true;
+		InstanceData.bHasInvestigateLocation = false;
+
+	} else {
+
+		// go check out where the team last saw or heard of an enemy
+		InstanceData.InvestigateLocation = LastKnownLocation;
+		InstanceData.bHasInvestigateLocation = true;
+	}
+
+	return EStateTreeRunStatus::Running;
+}
+
 void FStateTreeSenseEnemiesTask::ExitState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
 {
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_ShooterAITasks);
+
 	// have we transitioned to another state?
 	if (Transition.ChangeType == EStateTreeStateChangeType::Changed)
 	{
@@ -278,13 +278,28 @@ struct FStateTreeSenseEnemiesInstanceData
 	UPROPERTY(EditAnywhere, Category = Parameter)
 	float DirectLineOfSightCone = 85.0f;
 
+	/** Radius to look for threats known to the team in while the NPC has nothing to do */
+	UPROPERTY(EditAnywhere, Category = Parameter)
+	float TeamThreatRadius = 5000.0f;
+
+	/** Seconds between team threat queries while the NPC has nothing to do */
+	UPROPERTY(EditAnywhere, Category = Parameter)
+	float TeamThreatQueryInterval = 0.5f;
+
 	/** Strength of the last processed stimulus */
 	UPROPERTY(EditAnywhere)
 	float LastStimulusStrength = 0.0f;
+
+	/** Time until the next team threat query */
+	UPROPERTY()
+	float TeamThreatQueryCooldown = 0.0f;
 };
 
 /**
  *  StateTree task to have an NPC process AI Perceptions and sense nearby enemies
+ *  Sightings are shared with the rest of the team through the threat map, so enemies a squad mate
+ *  has eyes on are investigated first. Direct line of sight always comes from the NPC's own trace or cached check,
+ *  and a threat picked up from the team is only targeted once the NPC's own line of sight to it clears
  */
 USTRUCT(meta=(DisplayName="Sense Enemies", Category="Shooter"))
 struct FStateTreeSenseEnemiesTask : public FStateTreeTaskCommonBase
@@ -298,6 +313,9 @@ struct FStateTreeSenseEnemiesTask : public FStateTreeTaskCommonBase
 	/** Runs when the owning state is entered */
 	virtual EStateTreeRunStatus EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const override;
 
+	/** Runs while the owning state is active. Picks up threats known to the team while the NPC has nothing to do */
+	virtual EStateTreeRunStatus Tick(FStateTreeExecutionContext& Context, const float DeltaTime) const override;
+
 	/** Runs when the owning state is ended */
 	virtual void ExitState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const override;
 
@@ -0,0 +1,259 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Variant_Shooter/AI/ShooterThreatMap.h"
+#include "Variant_Shooter/AI/ShooterNPC.h"
+#include "Variant_Shooter/ShooterCharacter.h"
+#include "Variant_Shooter/ShooterStats.h"
+#include "Engine/World.h"
+
+namespace ShooterThreatMap
+{
+	/** Returns true if the threat's actor is gone or dead */
+	static bool IsThreatGone(const AActor* Actor)
+	{
+		if (!IsValid(Actor))
+		{
+			return true;
+		}
+
+		if (const AShooterNPC* NPC = Cast<AShooterNPC>(Actor))
+		{
+			return NPC->IsDead();
+		}
+
+		if (const AShooterCharacter* Character = Cast<AShooterCharacter>(Actor))
+		{
+			return Character->IsDead();
+		}
+
+		return false;
+	}
+}
+
+bool UShooterThreatMap::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UShooterThreatMap::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	PruneAccumulator += DeltaTime;
+
+	if (PruneAccumulator < PruneInterval)
+	{
+		return;
+	}
+
+	PruneAccumulator = 0.0f;
+
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_ShooterAITasks);
+
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	for (FShooterTeamThreats& Team : Teams)
+	{
+		for (int32 ThreatIndex = Team.Threats.Num() - 1; ThreatIndex >= 0; --ThreatIndex)
+		{
+			const FShooterThreat& Threat = Team.Threats[ThreatIndex];
+
+			if (Now - Threat.LastReportTime > MemoryTime || ShooterThreatMap::IsThreatGone(Threat.Actor.Get()))
+			{
+				RemoveThreatAt(Team, ThreatIndex);
+			}
+		}
+	}
+}
+
+TStatId UShooterThreatMap::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterThreatMap, STATGROUP_Tickables);
+}
+
+void UShooterThreatMap::ReportThreat(uint8 TeamByte, AActor* Actor, const FVector& Location, bool bConfirmed)
+{
+	if (!Actor)
+	{
+		return;
+	}
+
+	if (!Teams.IsValidIndex(TeamByte))
+	{
+		Teams.SetNum(TeamByte + 1);
+	}
+
+	FShooterTeamThreats& Team = Teams[TeamByte];
+
+	int32 ThreatIndex;
+
+	if (const int32* ExistingIndex = Team.ThreatIndices.Find(Actor))
+	{
+		ThreatIndex = *ExistingIndex;
+
+	} else {
+
+		ThreatIndex = Team.Threats.AddDefaulted();
+		Team.Threats[ThreatIndex].Actor = Actor;
+		Team.Threats[ThreatIndex].Cell = GetCell(Location);
+		Team.ThreatIndices.Add(Actor, ThreatIndex);
+
+		AddToCell(Team, Team.Threats[ThreatIndex].Cell, ThreatIndex);
+	}
+
+	FShooterThreat& Threat = Team.Threats[ThreatIndex];
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	// an unconfirmed sense, like a noise, doesn't overwrite a recently confirmed position
+	if (!bConfirmed && Now - Threat.LastConfirmedTime <= ConfirmedTime)
+	{
+		Threat.LastReportTime = Now;
+		return;
+	}
+
+	Threat.LastKnownLocation = Location;
+	Threat.LastReportTime = Now;
+
+	if (bConfirmed)
+	{
+		Threat.LastConfirmedTime = Now;
+	}
+
+	const FIntPoint NewCell = GetCell(Location);
+
+	if (NewCell != Threat.Cell)
+	{
+		RemoveFromCell(Team, Threat.Cell, ThreatIndex);
+		AddToCell(Team, NewCell, ThreatIndex);
+		Threat.Cell = NewCell;
+	}
+}
+
+bool UShooterThreatMap::IsThreatConfirmed(uint8 TeamByte, AActor* Actor) const
+{
+	if (!Teams.IsValidIndex(TeamByte))
+	{
+		return false;
+	}
+
+	const FShooterTeamThreats& Team = Teams[TeamByte];
+	const int32* ThreatIndex = Team.ThreatIndices.Find(Actor);
+
+	return ThreatIndex && GetWorld()->GetTimeSeconds() - Team.Threats[*ThreatIndex].LastConfirmedTime <= ConfirmedTime;
+}
+
+AActor* UShooterThreatMap::FindBestThreat(uint8 TeamByte, const FVector& Location, float Radius, FVector& OutLastKnownLocation, bool& bOutConfirmed) const
+{
+	bOutConfirmed = false;
+
+	if (!Teams.IsValidIndex(TeamByte))
+	{
+		return nullptr;
+	}
+
+	const FShooterTeamThreats& Team = Teams[TeamByte];
+	const double Now = GetWorld()->GetTimeSeconds();
+	const float RadiusSquared = FMath::Square(Radius);
+
+	const FIntPoint MinCell = GetCell(Location - FVector(Radius, Radius, 0.0f));
+	const FIntPoint MaxCell = GetCell(Location + FVector(Radius, Radius, 0.0f));
+
+	AActor* BestActor = nullptr;
+	float BestDistanceSquared = RadiusSquared;
+
+	for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+		{
+			const TArray<int32>* Cell = Team.Cells.Find(FIntPoint(X, Y));
+
+			if (!Cell)
+			{
+				continue;
+			}
+
+			for (const int32 ThreatIndex : *Cell)
+			{
+				const FShooterThreat& Threat = Team.Threats[ThreatIndex];
+				AActor* Actor = Threat.Actor.Get();
+
+				if (ShooterThreatMap::IsThreatGone(Actor))
+				{
+					continue;
+				}
+
+				const float DistanceSquared = FVector::DistSquared(Location, Threat.LastKnownLocation);
+
+				if (DistanceSquared > RadiusSquared)
+				{
+					continue;
+				}
+
+				// confirmed threats always beat unconfirmed ones, closer beats farther otherwise
+				const bool bConfirmed = Now - Threat.LastConfirmedTime <= ConfirmedTime;
+
+				if (bConfirmed == bOutConfirmed ? DistanceSquared < BestDistanceSquared : bConfirmed)
+				{
+					BestActor = Actor;
+					BestDistanceSquared = DistanceSquared;
+					OutLastKnownLocation = Threat.LastKnownLocation;
+					bOutConfirmed = bConfirmed;
+				}
+			}
+		}
+	}
+
+	return BestActor;
+}
+
+FIntPoint UShooterThreatMap::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt32(Location.X / CellSize), FMath::FloorToInt32(Location.Y / CellSize));
+}
+
+void UShooterThreatMap::RemoveThreatAt(FShooterTeamThreats& Team, int32 ThreatIndex)
+{
+	RemoveFromCell(Team, Team.Threats[ThreatIndex].Cell, ThreatIndex);
+	Team.ThreatIndices.Remove(Team.Threats[ThreatIndex].Actor);
+
+	// the last threat is about to move into this slot, so update its cell and index
+	const int32 LastIndex = Team.Threats.Num() - 1;
+
+	if (ThreatIndex != LastIndex)
+	{
+		const FShooterThreat& LastThreat = Team.Threats[LastIndex];
+
+		if (TArray<int32>* LastCell = Team.Cells.Find(LastThreat.Cell))
+		{
+			const int32 Slot = LastCell->Find(LastIndex);
+
+			if (Slot != INDEX_NONE)
+			{
+				(*LastCell)[Slot] = ThreatIndex;
+			}
+		}
+
+		Team.ThreatIndices.Add(LastThreat.Actor, ThreatIndex);
+	}
+
+	Team.Threats.RemoveAtSwap(ThreatIndex, 1, EAllowShrinking::No);
+}
+
+void UShooterThreatMap::AddToCell(FShooterTeamThreats& Team, const FIntPoint& Cell, int32 ThreatIndex)
+{
+	Team.Cells.FindOrAdd(Cell).Add(ThreatIndex);
+}
+
+void UShooterThreatMap::RemoveFromCell(FShooterTeamThreats& Team, const FIntPoint& Cell, int32 ThreatIndex)
+{
+	if (TArray<int32>* CellThreats = Team.Cells.Find(Cell))
+	{
+		CellThreats->RemoveSingleSwap(ThreatIndex, EAllowShrinking::No);
+
+		if (CellThreats->Num() == 0)
+		{
+			Team.Cells.Remove(Cell);
+		}
+	}
+}
@@ -0,0 +1,119 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterThreatMap.generated.h"
+
+/**
+ *  Enemy known to a team
+ */
+struct FShooterThreat
+{
+	/** Sighted enemy */
+	TWeakObjectPtr<AActor> Actor;
+
+	/** Where the enemy was last seen or heard */
+	FVector LastKnownLocation = FVector::ZeroVector;
+
+	/** Grid cell of the last known location */
+	FIntPoint Cell = FIntPoint::ZeroValue;
+
+	/** Time of the last report */
+	double LastReportTime = 0.0;
+
+	/** Time an NPC last had direct line of sight to the enemy */
+	double LastConfirmedTime = -UE_BIG_NUMBER;
+};
+
+/**
+ *  Enemies known to a team, bucketed by the grid cell of their last known location
+ */
+struct FShooterTeamThreats
+{
+	/** Known enemies */
+	TArray<FShooterThreat> Threats;
+
+	/** Threat index per enemy */
+	TMap<TWeakObjectPtr<AActor>, int32> ThreatIndices;
+
+	/** Threat indices per grid cell */
+	TMap<FIntPoint, TArray<int32>> Cells;
+};
+
+/**
+ *  Team level threat map shared by the NPCs
+ *  NPCs report the enemies they sense, confirmed when they have direct line of sight. Each team keeps
+ *  one last known location per enemy in a coarse grid, so an NPC can prioritise a target a squad mate
+ *  has already confirmed, and idle NPCs can find nearby fights by querying the grid
+ */
+UCLASS(Config=Game)
+class FPSPROJECT3_API UShooterThreatMap : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	/** Known enemies, indexed by the team that knows about them */
+	TArray<FShooterTeamThreats> Teams;
+
+	/** Time since threats were last expired */
+	float PruneAccumulator = 0.0f;
+
+protected:
+
+	/** Size of a grid cell */
+	UPROPERTY(Config)
+	float CellSize = 1000.0f;
+
+	/** Threats nobody reported for this long are forgotten */
+	UPROPERTY(Config)
+	float MemoryTime = 10.0f;
+
+	/** Sightings with direct line of sight count as confirmed for this long. Unconfirmed reports don't move a confirmed threat */
+	UPROPERTY(Config)
+	float ConfirmedTime = 2.0f;
+
+	/** Seconds between threat expiry passes */
+	UPROPERTY(Config)
+	float PruneInterval = 0.5f;
+
+public:
+
+	/** Only run in game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Forgets stale and dead threats */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Returns the stat id for this tickable */
+	virtual TStatId GetStatId() const override;
+
+	/** Records a sighting of an enemy by a member of the team. Confirmed sightings had direct line of sight */
+	void ReportThreat(uint8 TeamByte, AActor* Actor, const FVector& Location, bool bConfirmed);
+
+	/** Returns true if a member of the team recently had direct line of sight to the enemy */
+	bool IsThreatConfirmed(uint8 TeamByte, AActor* Actor) const;
+
+	/**
+	 *  Finds the team's best threat whose last known location is within the radius. Confirmed threats come first,
+	 *  then the closest. Returns nullptr if the team knows of no threat in range
+	 */
+	AActor* FindBestThreat(uint8 TeamByte, const FVector& Location, float Radius, FVector& OutLastKnownLocation, bool& bOutConfirmed) const;
+
+	/** Returns the number of threats known to the team */
+	int32 GetNumThreats(uint8 TeamByte) const { return Teams.IsValidIndex(TeamByte) ? Teams[TeamByte].Threats.Num() : 0; }
+
+protected:
+
+	/** Returns the grid cell containing the location */
+	FIntPoint GetCell(const FVector& Location) const;
+
+	/** Drops a team's threat, moving the last one into its slot */
+	static void RemoveThreatAt(FShooterTeamThreats& Team, int32 ThreatIndex);
+
+	/** Adds a threat index to a team's grid cell */
+	static void AddToCell(FShooterTeamThreats& Team, const FIntPoint& Cell, int32 ThreatIndex);
+
+	/** Removes a threat index from a team's grid cell */
+	static void RemoveFromCell(FShooterTeamThreats& Team, const FIntPoint& Cell, int32 ThreatIndex);
+};
@@ -2,34 +2,311 @@
 
 
 #include "Variant_Shooter/InventoryComponent.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "Variant_Shooter/ShooterLog.h"
 
+void FInventoryEntry::PostReplicatedAdd(const FInventoryList& InArraySerializer)
+{
+	if (InArraySerializer.OwnerComponent)
+	{
+		InArraySerializer.OwnerComponent->OnEntryReplicated(*this, false);
+	}
+}
+
+void FInventoryEntry::PostReplicatedChange(const FInventoryList& InArraySerializer)
+{
+	if (InArraySerializer.OwnerComponent)
+	{
+		InArraySerializer.OwnerComponent->OnEntryReplicated(*this, false);
+	}
+}
+
+void FInventoryEntry::PreReplicatedRemove(const FInventoryList& InArraySerializer)
+{
+	if (InArraySerializer.OwnerComponent)
+	{
+		InArraySerializer.OwnerComponent->OnEntryReplicated(*this, true);
+	}
+}
 
-// Sets default values for this component's properties
 UInventoryComponent::UInventoryComponent()
 {
-	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
-	// off to improve performance if you don't need them.
-	PrimaryComponentTick.bCanEverTick = true;
+	// the inventory only changes on events
+	PrimaryComponentTick.bCanEverTick = false;
+
+	SetIsReplicatedByDefault(true);
 
-	// ...
+	Inventory.OwnerComponent = this;
 }
 
+void UInventoryComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams SharedParams;
+	SharedParams.bIsPushBased = true;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(UInventoryComponent, Inventory, SharedParams);
+}
 
-// Called when the game starts
-void UInventoryComponent::BeginPlay()
+int32 UInventoryComponent::AddItem(int32 ItemDefId, int32 Count)
 {
-	Super::BeginPlay();
+	if (!GetOwner()->HasAuthority() || !GetItemDefinition(ItemDefId) || Count <= 0)
+	{
+		return Count;
+	}
+
+	const int32 MaxStackCount = GetMaxStackCount(ItemDefId);
+
+	// top up the stacks we already have
+	for (FInventoryEntry& Entry : Inventory.Entries)
+	{
+		if (Count == 0)
+		{
+			break;
+		}
+
+		if (Entry.ItemDefId == ItemDefId && Entry.StackCount < MaxStackCount)
+		{
+			const int32 Added = FMath::Min(Count, MaxStackCount - Entry.StackCount);
+
+			Entry.StackCount += Added;
+			Count -= Added;
+
+			MarkStackDirty(Entry);
+		}
+	}
 
-	// ...
-	
+	// start new stacks with the rest
+	while (Count > 0 && Inventory.Entries.Num() < MaxStacks)
+	{
+		const int32 Added = FMath::Min(Count, MaxStackCount);
+
+		AddStack(static_cast<uint16>(ItemDefId), Added);
+		Count -= Added;
+	}
+
+	if (Count > 0)
+	{
+		UE_LOG(LogShooter, Verbose, TEXT("%s AddItem: %d of item %d didn't fit"), *GetNameSafe(GetOwner()), Count, ItemDefId);
+	}
+
+	return Count;
 }
 
+int32 UInventoryComponent::RemoveItem(int32 ItemDefId, int32 Count)
+{
+	if (!GetOwner()->HasAuthority() || Count <= 0)
+	{
+		return 0;
+	}
+
+	int32 Removed = 0;
+
+	while (Removed < Count)
+	{
+		// take from the smallest stack so the full ones are kept
+		int32 SmallestIndex = INDEX_NONE;
 
-// Called every frame
-void UInventoryComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+		for (int32 Index = 0; Index < Inventory.Entries.Num(); ++Index)
+		{
+			const FInventoryEntry& Entry = Inventory.Entries[Index];
+
+			if (Entry.ItemDefId == ItemDefId && (SmallestIndex == INDEX_NONE || Entry.StackCount < Inventory.Entries[SmallestIndex].StackCount))
+			{
+				SmallestIndex = Index;
+			}
+		}
+
+		if (SmallestIndex == INDEX_NONE)
+		{
+			break;
+		}
+
+		FInventoryEntry& Entry = Inventory.Entries[SmallestIndex];
+		const int32 Taken = FMath::Min(Count - Removed, Entry.StackCount);
+
+		Entry.StackCount -= Taken;
+		Removed += Taken;
+
+		if (Entry.StackCount <= 0)
+		{
+			RemoveStackAt(SmallestIndex);
+
+		} else {
+
+			MarkStackDirty(Entry);
+		}
+	}
+
+	return Removed;
+}
+
+int32 UInventoryComponent::SplitStack(int32 StackId, int32 Count)
 {
-	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	if (!GetOwner()->HasAuthority() || Inventory.Entries.Num() >= MaxStacks)
+	{
+		return 0;
+	}
+
+	const int32 Index = FindStackIndex(StackId);
+
+	// both halves need at least one item
+	if (Index == INDEX_NONE || Count <= 0 || Count >= Inventory.Entries[Index].StackCount)
+	{
+		return 0;
+	}
 
-	// ...
+	Inventory.Entries[Index].StackCount -= Count;
+	MarkStackDirty(Inventory.Entries[Index]);
+
+	// adding may reallocate the entries, so take the item id by value
+	const uint16 ItemDefId = Inventory.Entries[Index].ItemDefId;
+	const int32 NewIndex = AddStack(ItemDefId, Count);
+
+	return Inventory.Entries[NewIndex].StackId;
 }
 
+bool UInventoryComponent::MergeStacks(int32 FromStackId, int32 ToStackId)
+{
+	if (!GetOwner()->HasAuthority() || FromStackId == ToStackId)
+	{
+		return false;
+	}
+
+	const int32 FromIndex = FindStackIndex(FromStackId);
+	const int32 ToIndex = FindStackIndex(ToStackId);
+
+	if (FromIndex == INDEX_NONE || ToIndex == INDEX_NONE || Inventory.Entries[FromIndex].ItemDefId != Inventory.Entries[ToIndex].ItemDefId)
+	{
+		return false;
+	}
+
+	FInventoryEntry& From = Inventory.Entries[FromIndex];
+	FInventoryEntry& To = Inventory.Entries[ToIndex];
+
+	const int32 Moved = FMath::Min(From.StackCount, GetMaxStackCount(To.ItemDefId) - To.StackCount);
+
+	if (Moved <= 0)
+	{
+		return false;
+	}
+
+	To.StackCount += Moved;
+	From.StackCount -= Moved;
+
+	MarkStackDirty(To);
+
+	if (From.StackCount <= 0)
+	{
+		RemoveStackAt(FromIndex);
+
+	} else {
+
+		MarkStackDirty(From);
+	}
+
+	return true;
+}
+
+int32 UInventoryComponent::GetItemCount(int32 ItemDefId) const
+{
+	int32 Count = 0;
+
+	for (const FInventoryEntry& Entry : Inventory.Entries)
+	{
+		if (Entry.ItemDefId == ItemDefId)
+		{
+			Count += Entry.StackCount;
+		}
+	}
+
+	return Count;
+}
+
+int32 UInventoryComponent::GetStackCount(int32 StackId) const
+{
+	const int32 Index = FindStackIndex(StackId);
+
+	return Index != INDEX_NONE ? Inventory.Entries[Index].StackCount : 0;
+}
+
+int32 UInventoryComponent::FindItemDefId(const FString& ItemID) const
+{
+	return ItemDefinitions.IndexOfByPredicate([&ItemID](const FGameItemData& Definition) { return Definition.ItemID == ItemID; });
+}
+
+const FGameItemData* UInventoryComponent::GetItemDefinition(int32 ItemDefId) const
+{
+	// definition ids have to fit in the replicated entry
+	if (!ItemDefinitions.IsValidIndex(ItemDefId) || ItemDefId > MAX_uint16)
+	{
+		return nullptr;
+	}
+
+	return &ItemDefinitions[ItemDefId];
+}
+
+void UInventoryComponent::OnEntryReplicated(const FInventoryEntry& Entry, bool bRemoved)
+{
+	OnStackChanged.Broadcast(Entry.StackId, Entry.ItemDefId, bRemoved ? 0 : Entry.StackCount);
+}
+
+int32 UInventoryComponent::GetMaxStackCount(int32 ItemDefId) const
+{
+	const FGameItemData* Definition = GetItemDefinition(ItemDefId);
+
+	if (!Definition)
+	{
+		return 0;
+	}
+
+	return Definition->bIsStackable ? FMath::Max(1, Definition->MaxStackCount) : 1;
+}
+
+int32 UInventoryComponent::FindStackIndex(int32 StackId) const
+{
+	return Inventory.Entries.IndexOfByPredicate([StackId](const FInventoryEntry& Entry) { return Entry.StackId == StackId; });
+}
+
+int32 UInventoryComponent::AddStack(uint16 ItemDefId, int32 Count)
+{
+	// hand out the next free id. 0 is kept for "no stack"
+	do
+	{
+		++LastStackId;
+
+	} while (LastStackId == 0 || FindStackIndex(LastStackId) != INDEX_NONE);
+
+	const int32 Index = Inventory.Entries.AddDefaulted();
+
+	FInventoryEntry& Entry = Inventory.Entries[Index];
+	Entry.StackId = LastStackId;
+	Entry.ItemDefId = ItemDefId;
+	Entry.StackCount = Count;
+
+	MarkStackDirty(Entry);
+
+	return Index;
+}
+
+void UInventoryComponent::MarkStackDirty(FInventoryEntry& Entry)
+{
+	Inventory.MarkItemDirty(Entry);
+	MARK_PROPERTY_DIRTY_FROM_NAME(UInventoryComponent, Inventory, this);
+
+	OnStackChanged.Broadcast(Entry.StackId, Entry.ItemDefId, Entry.StackCount);
+}
+
+void UInventoryComponent::RemoveStackAt(int32 Index)
+{
+	const FInventoryEntry Removed = Inventory.Entries[Index];
+
+	// order doesn't matter, stacks are found by id
+	Inventory.Entries.RemoveAtSwap(Index);
+	Inventory.MarkArrayDirty();
+	MARK_PROPERTY_DIRTY_FROM_NAME(UInventoryComponent, Inventory, this);
+
+	OnStackChanged.Broadcast(Removed.StackId, Removed.ItemDefId, 0);
+}
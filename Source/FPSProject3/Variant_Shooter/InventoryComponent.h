@@ -4,26 +4,171 @@
 
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
+#include "Net/Serialization/FastArraySerializer.h"
+#include "Variant_Shooter/GameItemData.h"
 #include "InventoryComponent.generated.h"
 
+class UInventoryComponent;
+struct FInventoryList;
 
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FInventoryStackChangedDelegate, int32, StackId, int32, ItemDefId, int32, StackCount);
+
+/**
+ *  A stack of items in an inventory
+ *  Only the compact definition id and the count are replicated. The item data is looked up from the definitions
+ */
+USTRUCT()
+struct FInventoryEntry : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	/** Identifies the stack within its inventory. Fast array order isn't kept on clients */
+	UPROPERTY()
+	uint16 StackId = 0;
+
+	/** Index of the item in the inventory's definitions */
+	UPROPERTY()
+	uint16 ItemDefId = 0;
+
+	/** Number of items in the stack */
+	UPROPERTY()
+	int32 StackCount = 0;
+
+	/** Notifies the owning component of the new stack */
+	void PostReplicatedAdd(const FInventoryList& InArraySerializer);
+
+	/** Notifies the owning component of the new count */
+	void PostReplicatedChange(const FInventoryList& InArraySerializer);
+
+	/** Notifies the owning component of the removed stack */
+	void PreReplicatedRemove(const FInventoryList& InArraySerializer);
+};
+
+/**
+ *  Replicated list of item stacks
+ *  Only the stacks that changed are sent, so updates cost bytes proportional to the change, not to the inventory size
+ */
+USTRUCT()
+struct FInventoryList : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	/** Item stacks */
+	UPROPERTY()
+	TArray<FInventoryEntry> Entries;
+
+	/** Component owning this list */
+	UPROPERTY(NotReplicated)
+	TObjectPtr<UInventoryComponent> OwnerComponent;
+
+	/** Delta serializes the changed stacks only */
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FInventoryEntry, FInventoryList>(Entries, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FInventoryList> : public TStructOpsTypeTraitsBase2<FInventoryList>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
+
+/**
+ *  Replicated item inventory
+ *  Items are kept as plain stacks keyed by a compact definition id. Stacking and splitting
+ *  only edit the stack array, no item objects are created. Changes are server authoritative
+ */
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class FPSPROJECT3_API UInventoryComponent : public UActorComponent
 {
 	GENERATED_BODY()
 
-public:	
-	// Sets default values for this component's properties
-	UInventoryComponent();  
+	/** Replicated item stacks */
+	UPROPERTY(Replicated)
+	FInventoryList Inventory;
+
+	/** Last stack id handed out. Server only */
+	uint16 LastStackId = 0;
 
 protected:
-	// Called when the game starts
-	virtual void BeginPlay() override;
 
-public:	
-	// Called every frame
-	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	/** Item definitions. The index of an item in this list is its compact definition id, so it must match on server and clients */
+	UPROPERTY(EditDefaultsOnly, Category="Inventory")
+	TArray<FGameItemData> ItemDefinitions;
+
+	/** Max number of stacks the inventory can hold */
+	UPROPERTY(EditDefaultsOnly, Category="Inventory", meta = (ClampMin = 1, ClampMax = 1024))
+	int32 MaxStacks = 32;
+
+public:
+
+	/** Called on the server and clients when a stack is added, changes count or is removed (StackCount 0) */
+	UPROPERTY(BlueprintAssignable, Category="Inventory")
+	FInventoryStackChangedDelegate OnStackChanged;
+
+public:
+
+	/** Constructor */
+	UInventoryComponent();
+
+	/** Sets up the replicated properties */
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	/** Server: adds items, topping up existing stacks first. Returns the number of items that didn't fit */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category="Inventory")
+	int32 AddItem(int32 ItemDefId, int32 Count);
+
+	/** Server: removes items, emptying the smallest stacks first. Returns the number of items removed */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category="Inventory")
+	int32 RemoveItem(int32 ItemDefId, int32 Count);
+
+	/** Server: moves part of a stack into a new stack. Returns the new stack id, or 0 if it couldn't be split */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category="Inventory")
+	int32 SplitStack(int32 StackId, int32 Count);
+
+	/** Server: moves as many items as fit from one stack into another of the same item. Returns true if any moved */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category="Inventory")
+	bool MergeStacks(int32 FromStackId, int32 ToStackId);
+
+	/** Returns the total number of items of a definition across all stacks */
+	UFUNCTION(BlueprintPure, Category="Inventory")
+	int32 GetItemCount(int32 ItemDefId) const;
+
+	/** Returns the number of items in a stack, or 0 if there's no such stack */
+	UFUNCTION(BlueprintPure, Category="Inventory")
+	int32 GetStackCount(int32 StackId) const;
+
+	/** Returns the compact definition id for an item id, or INDEX_NONE */
+	UFUNCTION(BlueprintPure, Category="Inventory")
+	int32 FindItemDefId(const FString& ItemID) const;
+
+	/** Returns the item data for a definition id, or nullptr */
+	const FGameItemData* GetItemDefinition(int32 ItemDefId) const;
+
+	/** Returns the item stacks */
+	const TArray<FInventoryEntry>& GetStacks() const { return Inventory.Entries; }
+
+	/** Called by the replicated list on clients when a stack changes */
+	void OnEntryReplicated(const FInventoryEntry& Entry, bool bRemoved);
+
+protected:
+
+	/** Returns the max count of a stack of this definition */
+	int32 GetMaxStackCount(int32 ItemDefId) const;
+
+	/** Returns the index of the stack in the entries, or INDEX_NONE */
+	int32 FindStackIndex(int32 StackId) const;
+
+	/** Server: adds a new stack and returns its index */
+	int32 AddStack(uint16 ItemDefId, int32 Count);
+
+	/** Server: marks a stack changed and notifies the listeners */
+	void MarkStackDirty(FInventoryEntry& Entry);
 
-		
-	
+	/** Server: removes the stack at the index and notifies the listeners */
+	void RemoveStackAt(int32 Index);
 };
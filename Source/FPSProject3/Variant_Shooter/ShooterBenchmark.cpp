@@ -0,0 +1,511 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Variant_Shooter/ShooterBenchmark.h"
+#include "Variant_Shooter/AI/ShooterNPC.h"
+#include "Variant_Shooter/AI/ShooterCrowd.h"
+#include "Variant_Shooter/ShooterGameState.h"
+#include "Variant_Shooter/ShooterLog.h"
+#include "Variant_Shooter/Weapons/ShooterProjectilePool.h"
+#include "Variant_Shooter/Weapons/ShooterProjectileSimulation.h"
+#include "Engine/World.h"
+#include "Engine/NetDriver.h"
+#include "Engine/NetConnection.h"
+#include "GameFramework/PlayerStart.h"
+#include "EngineUtils.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/UObjectGlobals.h"
+
+bool UShooterBenchmark::ShouldCreateSubsystem(UObject* Outer) const
+{
+	return FParse::Param(FCommandLine::Get(), TEXT("ShooterBenchmark")) && Super::ShouldCreateSubsystem(Outer);
+}
+
+bool UShooterBenchmark::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UShooterBenchmark::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// bots and scoring only exist on the server
+	if (InWorld.GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	ParseCommandLine();
+
+	LoadedBotClass = BotClass.LoadSynchronous();
+
+	if (!LoadedBotClass)
+	{
+		UE_LOG(LogShooterGameMode, Error, TEXT("ShooterBenchmark - No bot class set, add BotClass to DefaultGame.ini or pass -BenchmarkBotClass="));
+		FPlatformMisc::RequestExit(false);
+		return;
+	}
+
+	// fix every source of randomness so runs can be compared
+	FMath::RandInit(Seed);
+	FMath::SRandInit(Seed);
+	RandomStream.Initialize(Seed);
+
+	// keep the match going for the whole run
+	if (AShooterGameState* GameState = InWorld.GetGameState<AShooterGameState>())
+	{
+		GameState->WinningScore = MAX_int32;
+	}
+
+	PreGCHandle = FCoreUObjectDelegates::GetPreGarbageCollectDelegate().AddUObject(this, &UShooterBenchmark::OnPreGarbageCollect);
+	PostGCHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddUObject(this, &UShooterBenchmark::OnPostGarbageCollect);
+
+	const double Now = FPlatformTime::Seconds();
+
+	StartTime = Now;
+	LastSampleTime = Now;
+	MeasureStartTime = 0.0;
+	bClientsJoined = NumClients == 0;
+	bRunning = true;
+
+	RefillTeams();
+
+	UE_LOG(LogShooterGameMode, Log, TEXT("ShooterBenchmark - Started: Bots=%d Crowd=%d Clients=%d Minutes=%.1f Warmup=%.1fs Seed=%d CSV=%s"),
+		NumBots, NumCrowdAgents, NumClients, DurationMinutes, WarmupSeconds, Seed, *CSVPath);
+}
+
+void UShooterBenchmark::Deinitialize()
+{
+	FCoreUObjectDelegates::GetPreGarbageCollectDelegate().Remove(PreGCHandle);
+	FCoreUObjectDelegates::GetPostGarbageCollect().Remove(PostGCHandle);
+
+	Super::Deinitialize();
+}
+
+void UShooterBenchmark::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	const double Now = FPlatformTime::Seconds();
+
+	// measure the time the game thread was busy, so the idle time of a capped server tick rate doesn't hide the cost of the frame
+	const double FrameMs = FMath::Max(0.0, FApp::GetDeltaTime() - FApp::GetIdleTime()) * 1000.0;
+
+	if (MeasureStartTime == 0.0)
+	{
+		if (WaitForClients(Now) && Now - StartTime >= WarmupSeconds)
+		{
+			BeginMeasuring(Now);
+		}
+
+	} else {
+
+		FrameTimesMs.Add(static_cast<float>(FrameMs));
+	}
+
+	if (Now - LastSampleTime >= SampleInterval)
+	{
+		LastSampleTime = Now;
+
+		RefillTeams();
+		SpawnCrowd();
+
+		if (MeasureStartTime > 0.0)
+		{
+			SampleConnections();
+		}
+	}
+
+	if (MeasureStartTime > 0.0 && Now - MeasureStartTime >= DurationMinutes * 60.0f)
+	{
+		FinishRun();
+	}
+}
+
+TStatId UShooterBenchmark::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterBenchmark, STATGROUP_Tickables);
+}
+
+void UShooterBenchmark::ParseCommandLine()
+{
+	const TCHAR* CommandLine = FCommandLine::Get();
+
+	FParse::Value(CommandLine, TEXT("BenchmarkBots="), NumBots);
+	FParse::Value(CommandLine, TEXT("BenchmarkCrowd="), NumCrowdAgents);
+	FParse::Value(CommandLine, TEXT("BenchmarkClients="), NumClients);
+	FParse::Value(CommandLine, TEXT("BenchmarkClientTimeout="), ClientTimeoutSeconds);
+	FParse::Value(CommandLine, TEXT("BenchmarkMinutes="), DurationMinutes);
+	FParse::Value(CommandLine, TEXT("BenchmarkWarmup="), WarmupSeconds);
+	FParse::Value(CommandLine, TEXT("BenchmarkSeed="), Seed);
+	FParse::Value(CommandLine, TEXT("MaxShotCostUs="), MaxShotCostUs);
+
+	FString BotClassPath;
+
+	if (FParse::Value(CommandLine, TEXT("BenchmarkBotClass="), BotClassPath))
+	{
+		BotClass = TSoftClassPtr<AShooterNPC>(FSoftObjectPath(BotClassPath));
+	}
+
+	if (!FParse::Value(CommandLine, TEXT("BenchmarkCSV="), CSVPath))
+	{
+		CSVPath = FPaths::ProjectSavedDir() / TEXT("Benchmark") / FString::Printf(TEXT("ShooterBenchmark-%s.csv"), *FDateTime::Now().ToString());
+	}
+
+	NumBots = FMath::Max(2, NumBots);
+	NumCrowdAgents = FMath::Max(0, NumCrowdAgents);
+	NumClients = FMath::Max(0, NumClients);
+	DurationMinutes = FMath::Max(0.1f, DurationMinutes);
+	WarmupSeconds = FMath::Max(0.0f, WarmupSeconds);
+}
+
+void UShooterBenchmark::RefillTeams()
+{
+	const int32 BotsPerTeam = NumBots / 2;
+
+	for (uint8 TeamByte = 0; TeamByte < 2; ++TeamByte)
+	{
+		// dead bots drop out of the list once they're destroyed
+		TArray<TWeakObjectPtr<AShooterNPC>>& Bots = TeamBots[TeamByte];
+		Bots.RemoveAllSwap([](const TWeakObjectPtr<AShooterNPC>& Bot) { return !Bot.IsValid(); });
+
+		while (Bots.Num() < BotsPerTeam)
+		{
+			AShooterNPC* Bot = SpawnBot(TeamByte);
+
+			if (!Bot)
+			{
+				break;
+			}
+
+			Bots.Add(Bot);
+		}
+	}
+}
+
+AShooterNPC* UShooterBenchmark::SpawnBot(uint8 TeamByte)
+{
+	UWorld* World = GetWorld();
+
+	TArray<APlayerStart*> PlayerStarts;
+
+	for (TActorIterator<APlayerStart> It(World); It; ++It)
+	{
+		PlayerStarts.Add(*It);
+	}
+
+	FTransform SpawnTransform = FTransform::Identity;
+
+	if (PlayerStarts.Num() > 0)
+	{
+		// spread the bots around the start so they don't all pile onto the same spot
+		const APlayerStart* PlayerStart = PlayerStarts[RandomStream.RandRange(0, PlayerStarts.Num() - 1)];
+		const FVector Offset(RandomStream.FRandRange(-300.0f, 300.0f), RandomStream.FRandRange(-300.0f, 300.0f), 0.0f);
+
+		SpawnTransform = FTransform(PlayerStart->GetActorRotation(), PlayerStart->GetActorLocation() + Offset);
+	}
+
+	const uint64 SpawnStartCycles = FPlatformTime::Cycles64();
+
+	AShooterNPC* Bot = World->SpawnActorDeferred<AShooterNPC>(LoadedBotClass, SpawnTransform, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn);
+
+	if (!Bot)
+	{
+		return nullptr;
+	}
+
+	// set the team before BeginPlay so the weapons and StateTree see it
+	Bot->SetTeamByte(TeamByte);
+
+	// the SenseEnemies task targets this tag, and skips teammates
+	Bot->Tags.AddUnique(FName("Player"));
+
+	Bot->FinishSpawning(SpawnTransform);
+
+	if (!Bot->GetController())
+	{
+		Bot->SpawnDefaultController();
+	}
+
+	++BotsSpawned;
+
+	BotSpawnCost.Record(FPlatformTime::Cycles64() - SpawnStartCycles);
+
+	return Bot;
+}
+
+void UShooterBenchmark::SpawnCrowd()
+{
+	if (bCrowdSpawned || NumCrowdAgents == 0)
+	{
+		return;
+	}
+
+	// the crowd sets itself up in its own OnWorldBeginPlay, which may run after ours
+	UShooterCrowd* Crowd = GetWorld()->GetSubsystem<UShooterCrowd>();
+
+	if (!Crowd || !Crowd->IsTickable())
+	{
+		return;
+	}
+
+	bCrowdSpawned = true;
+
+	TArray<FVector> StartLocations;
+
+	for (TActorIterator<APlayerStart> It(GetWorld()); It; ++It)
+	{
+		StartLocations.Add(It->GetActorLocation());
+	}
+
+	if (StartLocations.Num() == 0)
+	{
+		StartLocations.Add(FVector::ZeroVector);
+	}
+
+	for (int32 AgentIndex = 0; AgentIndex < NumCrowdAgents; ++AgentIndex)
+	{
+		// alternate teams and scatter them around the starts so both sides run into each other
+		const FVector& StartLocation = StartLocations[RandomStream.RandRange(0, StartLocations.Num() - 1)];
+		const FVector Offset(RandomStream.FRandRange(-1500.0f, 1500.0f), RandomStream.FRandRange(-1500.0f, 1500.0f), 0.0f);
+
+		Crowd->SpawnAgent(StartLocation + Offset, static_cast<uint8>(AgentIndex % 2));
+	}
+}
+
+void UShooterBenchmark::SampleConnections()
+{
+	const UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+
+	if (!NetDriver)
+	{
+		return;
+	}
+
+	for (UNetConnection* Connection : NetDriver->ClientConnections)
+	{
+		if (!Connection || !Connection->PlayerController)
+		{
+			continue;
+		}
+
+		FShooterBenchmarkConnection& Samples = Connections.FindOrAdd(Connection);
+
+		if (Samples.Address.IsEmpty())
+		{
+			Samples.Address = Connection->LowLevelGetRemoteAddress(true);
+		}
+
+		Samples.InBytesPerSecondSum += Connection->InBytesPerSecond;
+		Samples.OutBytesPerSecondSum += Connection->OutBytesPerSecond;
+		++Samples.NumSamples;
+	}
+}
+
+int32 UShooterBenchmark::GetNumJoinedClients() const
+{
+	const UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+
+	if (!NetDriver)
+	{
+		return 0;
+	}
+
+	// only count clients that made it into the match, they're the ones actors replicate to
+	int32 NumJoined = 0;
+
+	for (const UNetConnection* Connection : NetDriver->ClientConnections)
+	{
+		if (Connection && Connection->PlayerController)
+		{
+			++NumJoined;
+		}
+	}
+
+	return NumJoined;
+}
+
+bool UShooterBenchmark::WaitForClients(double Now)
+{
+	if (bClientsJoined)
+	{
+		return true;
+	}
+
+	if (GetNumJoinedClients() >= NumClients)
+	{
+		// give the clients the full warmup so their initial replication burst isn't measured
+		bClientsJoined = true;
+		StartTime = Now;
+
+		UE_LOG(LogShooterGameMode, Log, TEXT("ShooterBenchmark - %d clients joined, warming up"), NumClients);
+		return true;
+	}
+
+	if (Now - StartTime >= ClientTimeoutSeconds)
+	{
+		UE_LOG(LogShooterGameMode, Error, TEXT("ShooterBenchmark - Only %d of %d clients joined within %.0fs"), GetNumJoinedClients(), NumClients, ClientTimeoutSeconds);
+
+		bRunning = false;
+		FPlatformMisc::RequestExitWithStatus(false, 1);
+	}
+
+	return false;
+}
+
+void UShooterBenchmark::BeginMeasuring(double Now)
+{
+	MeasureStartTime = Now;
+
+	FrameTimesMs.Reset();
+	FrameTimesMs.Reserve(FMath::CeilToInt(DurationMinutes * 60.0f * 120.0f));
+	Connections.Reset();
+
+	GCTotalMs = 0.0;
+	GCMaxMs = 0.0;
+	GCCount = 0;
+
+	const UShooterProjectilePool* Pool = GetWorld()->GetSubsystem<UShooterProjectilePool>();
+	const UShooterProjectileSimulation* Simulation = GetWorld()->GetSubsystem<UShooterProjectileSimulation>();
+
+	StartPooledProjectiles = Pool ? Pool->GetTotalAcquired() : 0;
+	StartSimulatedProjectiles = Simulation ? Simulation->GetNumLaunched() : 0;
+
+	// the cost counters are only read here, so restart them with the measured window
+	ShooterCost::Shots = FShooterCostCounter();
+	ShooterCost::Respawns = FShooterCostCounter();
+	BotSpawnCost = FShooterCostCounter();
+
+	UE_LOG(LogShooterGameMode, Log, TEXT("ShooterBenchmark - Warmup done, measuring for %.1f minutes"), DurationMinutes);
+}
+
+void UShooterBenchmark::FinishRun()
+{
+	bRunning = false;
+
+	const FString Report = BuildReport();
+
+	if (FFileHelper::SaveStringToFile(Report, *CSVPath))
+	{
+		UE_LOG(LogShooterGameMode, Log, TEXT("ShooterBenchmark - Wrote results to %s"), *FPaths::ConvertRelativePathToFull(CSVPath));
+
+	} else {
+
+		UE_LOG(LogShooterGameMode, Error, TEXT("ShooterBenchmark - Failed to write results to %s"), *CSVPath);
+	}
+
+	// fail the run so automation picks up the regression
+	const double ShotCostUs = ShooterCost::Shots.GetAverageUs();
+
+	if (MaxShotCostUs > 0.0f && ShotCostUs > MaxShotCostUs)
+	{
+		UE_LOG(LogShooterGameMode, Error, TEXT("ShooterBenchmark - Shot cost %.2fus is over the %.2fus budget"), ShotCostUs, MaxShotCostUs);
+		FPlatformMisc::RequestExitWithStatus(false, 1);
+		return;
+	}
+
+	FPlatformMisc::RequestExit(false);
+}
+
+FString UShooterBenchmark::BuildReport() const
+{
+	TArray<float> SortedFrameTimes = FrameTimesMs;
+	SortedFrameTimes.Sort();
+
+	const UShooterProjectilePool* Pool = GetWorld()->GetSubsystem<UShooterProjectilePool>();
+	const UShooterProjectileSimulation* Simulation = GetWorld()->GetSubsystem<UShooterProjectileSimulation>();
+
+	const int32 PooledProjectiles = (Pool ? Pool->GetTotalAcquired() : 0) - StartPooledProjectiles;
+	const int32 SimulatedProjectiles = (Simulation ? Simulation->GetNumLaunched() : 0) - StartSimulatedProjectiles;
+
+	FString Report = TEXT("Metric,Value\n");
+
+	Report += FString::Printf(TEXT("Seed,%d\n"), Seed);
+	Report += FString::Printf(TEXT("Bots,%d\n"), NumBots);
+	Report += FString::Printf(TEXT("Clients,%d\n"), Connections.Num());
+	Report += FString::Printf(TEXT("BotsSpawned,%d\n"), BotsSpawned);
+
+	if (const UShooterCrowd* Crowd = GetWorld()->GetSubsystem<UShooterCrowd>())
+	{
+		Report += FString::Printf(TEXT("CrowdAgents,%d\n"), NumCrowdAgents);
+		Report += FString::Printf(TEXT("CrowdAgentsAlive,%d\n"), Crowd->GetNumAgents());
+		Report += FString::Printf(TEXT("CrowdAgentKills,%d\n"), Crowd->GetNumAgentKills());
+		Report += FString::Printf(TEXT("CrowdUpgrades,%d\n"), Crowd->GetNumUpgrades());
+		Report += FString::Printf(TEXT("CrowdDowngrades,%d\n"), Crowd->GetNumDowngrades());
+	}
+
+	Report += FString::Printf(TEXT("DurationSeconds,%.1f\n"), DurationMinutes * 60.0f);
+	Report += FString::Printf(TEXT("Frames,%d\n"), SortedFrameTimes.Num());
+	Report += FString::Printf(TEXT("FrameMsP50,%.3f\n"), GetPercentile(SortedFrameTimes, 0.5f));
+	Report += FString::Printf(TEXT("FrameMsP90,%.3f\n"), GetPercentile(SortedFrameTimes, 0.9f));
+	Report += FString::Printf(TEXT("FrameMsP99,%.3f\n"), GetPercentile(SortedFrameTimes, 0.99f));
+	Report += FString::Printf(TEXT("FrameMsMax,%.3f\n"), SortedFrameTimes.Num() > 0 ? SortedFrameTimes.Last() : 0.0f);
+	Report += FString::Printf(TEXT("ProjectilesSpawned,%d\n"), PooledProjectiles + SimulatedProjectiles);
+	Report += FString::Printf(TEXT("ProjectilesPooled,%d\n"), PooledProjectiles);
+	Report += FString::Printf(TEXT("ProjectilesSimulated,%d\n"), SimulatedProjectiles);
+	Report += FString::Printf(TEXT("ServerShots,%d\n"), ShooterCost::Shots.Count);
+	Report += FString::Printf(TEXT("ShotCostUs,%.3f\n"), ShooterCost::Shots.GetAverageUs());
+	Report += FString::Printf(TEXT("MaxShotCostUs,%.3f\n"), MaxShotCostUs);
+	Report += FString::Printf(TEXT("BotSpawns,%d\n"), BotSpawnCost.Count);
+	Report += FString::Printf(TEXT("BotSpawnUsAvg,%.3f\n"), BotSpawnCost.GetAverageUs());
+	Report += FString::Printf(TEXT("BotSpawnUsMax,%.3f\n"), BotSpawnCost.GetMaxUs());
+	Report += FString::Printf(TEXT("Respawns,%d\n"), ShooterCost::Respawns.Count);
+	Report += FString::Printf(TEXT("RespawnUsAvg,%.3f\n"), ShooterCost::Respawns.GetAverageUs());
+	Report += FString::Printf(TEXT("RespawnUsMax,%.3f\n"), ShooterCost::Respawns.GetMaxUs());
+	Report += FString::Printf(TEXT("GCCount,%d\n"), GCCount);
+	Report += FString::Printf(TEXT("GCTotalMs,%.3f\n"), GCTotalMs);
+	Report += FString::Printf(TEXT("GCMaxMs,%.3f\n"), GCMaxMs);
+
+	int32 ConnectionIndex = 0;
+
+	for (const TPair<TWeakObjectPtr<UNetConnection>, FShooterBenchmarkConnection>& Pair : Connections)
+	{
+		const FShooterBenchmarkConnection& Samples = Pair.Value;
+		const int32 NumSamples = FMath::Max(1, Samples.NumSamples);
+
+		Report += FString::Printf(TEXT("Connection%d,%s\n"), ConnectionIndex, *Samples.Address);
+		Report += FString::Printf(TEXT("Connection%dInBytesPerSecond,%lld\n"), ConnectionIndex, Samples.InBytesPerSecondSum / NumSamples);
+		Report += FString::Printf(TEXT("Connection%dOutBytesPerSecond,%lld\n"), ConnectionIndex, Samples.OutBytesPerSecondSum / NumSamples);
+
+		++ConnectionIndex;
+	}
+
+	return Report;
+}
+
+float UShooterBenchmark::GetPercentile(const TArray<float>& SortedValues, float Percentile)
+{
+	if (SortedValues.Num() == 0)
+	{
+		return 0.0f;
+	}
+
+	const int32 Index = FMath::Clamp(FMath::CeilToInt(Percentile * SortedValues.Num()) - 1, 0, SortedValues.Num() - 1);
+
+	return SortedValues[Index];
+}
+
+void UShooterBenchmark::OnPreGarbageCollect()
+{
+	GCStartTime = FPlatformTime::Seconds();
+}
+
+void UShooterBenchmark::OnPostGarbageCollect()
+{
+	// only count collections inside the measured window
+	if (MeasureStartTime == 0.0 || GCStartTime == 0.0)
+	{
+		return;
+	}
+
+	const double GCMs = (FPlatformTime::Seconds() - GCStartTime) * 1000.0;
+
+	GCTotalMs += GCMs;
+	GCMaxMs = FMath::Max(GCMaxMs, GCMs);
+	++GCCount;
+}
@@ -0,0 +1,215 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterStats.h"
+#include "ShooterBenchmark.generated.h"
+
+class AShooterNPC;
+class UNetConnection;
+
+/**
+ *  Bandwidth samples for one client connection
+ */
+struct FShooterBenchmarkConnection
+{
+	/** Remote address of the connection */
+	FString Address;
+
+	/** Sum of the sampled incoming bytes per second */
+	int64 InBytesPerSecondSum = 0;
+
+	/** Sum of the sampled outgoing bytes per second */
+	int64 OutBytesPerSecondSum = 0;
+
+	/** Number of samples taken */
+	int32 NumSamples = 0;
+};
+
+/**
+ *  Headless bot match benchmark
+ *  Only created when the server is started with -ShooterBenchmark, for example:
+ *
+ *    FPSProject3Server Lvl_Shooter -ShooterBenchmark -BenchmarkBots=32 -BenchmarkMinutes=5 -BenchmarkSeed=1 -BenchmarkClients=2 -nullrhi -unattended
+ *
+ *  Replication only runs for connected clients, so to measure bandwidth start that many headless clients against the server:
+ *
+ *    FPSProject3 127.0.0.1 -nullrhi -nosound -unattended
+ *
+ *  Fills both teams with StateTree driven bots, keeps them topped up as they die, and after the
+ *  run writes game thread frame time percentiles, bandwidth per client connection, projectile counts, spawn and respawn cost and GC time
+ *  to a CSV before exiting. The warmup only starts once -BenchmarkClients= clients have joined, and the run
+ *  fails with a non zero exit code when they don't show up in time. Pass -MaxShotCostUs= to fail the run when the
+ *  average server cost of a shot regresses past the budget. Pass -BenchmarkCrowd= to add that many
+ *  simulated crowd agents on top of the bots
+ */
+UCLASS(Config=Game)
+class FPSPROJECT3_API UShooterBenchmark : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Bot type to spawn. Overridden with -BenchmarkBotClass= */
+	UPROPERTY(Config)
+	TSoftClassPtr<AShooterNPC> BotClass;
+
+	/** Total number of bots, split evenly between both teams. Overridden with -BenchmarkBots= */
+	UPROPERTY(Config)
+	int32 NumBots = 16;
+
+	/** Number of headless clients to wait for before warming up, so bandwidth can be measured. Overridden with -BenchmarkClients= */
+	UPROPERTY(Config)
+	int32 NumClients = 0;
+
+	/** Time to wait for the clients to join before failing the run. Overridden with -BenchmarkClientTimeout= */
+	UPROPERTY(Config)
+	float ClientTimeoutSeconds = 120.0f;
+
+	/** Number of lightweight crowd agents to add on top of the bots, split between both teams. Overridden with -BenchmarkCrowd= */
+	UPROPERTY(Config)
+	int32 NumCrowdAgents = 0;
+
+	/** Length of the measured part of the run. Overridden with -BenchmarkMinutes= */
+	UPROPERTY(Config)
+	float DurationMinutes = 5.0f;
+
+	/** Time to let the match settle before measuring. Overridden with -BenchmarkWarmup= */
+	UPROPERTY(Config)
+	float WarmupSeconds = 10.0f;
+
+	/** Seed for spawn selection and gameplay randomness. Overridden with -BenchmarkSeed= */
+	UPROPERTY(Config)
+	int32 Seed = 1;
+
+	/** Time between bot refills and bandwidth samples */
+	UPROPERTY(Config)
+	float SampleInterval = 1.0f;
+
+	/** Average server cost of a shot in microseconds above which the run fails. 0 disables the gate. Overridden with -MaxShotCostUs= */
+	UPROPERTY(Config)
+	float MaxShotCostUs = 0.0f;
+
+	/** Output file. Overridden with -BenchmarkCSV=, defaults to Saved/Benchmark */
+	FString CSVPath;
+
+	/** Loaded bot type */
+	UPROPERTY()
+	TSubclassOf<AShooterNPC> LoadedBotClass;
+
+	/** Bots by team */
+	TArray<TWeakObjectPtr<AShooterNPC>> TeamBots[2];
+
+	/** Spawn selection */
+	FRandomStream RandomStream;
+
+	/** True once the match has started */
+	bool bRunning = false;
+
+	/** Time the run started, or the last client joined */
+	double StartTime = 0.0;
+
+	/** True once every expected client has joined */
+	bool bClientsJoined = false;
+
+	/** Time the measured part of the run started */
+	double MeasureStartTime = 0.0;
+
+	/** Time of the last bot refill and bandwidth sample */
+	double LastSampleTime = 0.0;
+
+	/** Measured game thread frame times in milliseconds */
+	TArray<float> FrameTimesMs;
+
+	/** Bandwidth samples keyed by connection */
+	TMap<TWeakObjectPtr<UNetConnection>, FShooterBenchmarkConnection> Connections;
+
+	/** Projectile counters when measuring started */
+	int32 StartPooledProjectiles = 0;
+	int32 StartSimulatedProjectiles = 0;
+
+	/** Cost of spawning a fresh bot, for comparison with recycled player respawns */
+	FShooterCostCounter BotSpawnCost;
+
+	/** Time the current garbage collection started */
+	double GCStartTime = 0.0;
+
+	/** Garbage collection totals over the measured part of the run */
+	double GCTotalMs = 0.0;
+	double GCMaxMs = 0.0;
+	int32 GCCount = 0;
+
+	/** Bots spawned over the whole run */
+	int32 BotsSpawned = 0;
+
+	/** True once the crowd agents have been added */
+	bool bCrowdSpawned = false;
+
+	/** GC delegate handles */
+	FDelegateHandle PreGCHandle;
+	FDelegateHandle PostGCHandle;
+
+public:
+
+	/** Only created on servers started with -ShooterBenchmark */
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	/** Only run in game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Starts the match once gameplay begins */
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	/** Removes the GC hooks */
+	virtual void Deinitialize() override;
+
+	/** Records frame times, refills bots and ends the run */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Returns the stat id for this tickable */
+	virtual TStatId GetStatId() const override;
+
+	/** Only ticks while the run is going */
+	virtual bool IsTickable() const override { return bRunning; }
+
+protected:
+
+	/** Reads command line overrides */
+	void ParseCommandLine();
+
+	/** Spawns bots until both teams are full */
+	void RefillTeams();
+
+	/** Spawns a bot for the team at a random player start */
+	AShooterNPC* SpawnBot(uint8 TeamByte);
+
+	/** Adds the crowd agents around the player starts once the crowd is running */
+	void SpawnCrowd();
+
+	/** Samples the bandwidth of every client connection */
+	void SampleConnections();
+
+	/** Returns the number of clients that have joined the match */
+	int32 GetNumJoinedClients() const;
+
+	/** Holds the warmup back until the expected clients have joined, failing the run if they take too long */
+	bool WaitForClients(double Now);
+
+	/** Resets the counters at the end of the warmup */
+	void BeginMeasuring(double Now);
+
+	/** Writes the results and shuts the server down */
+	void FinishRun();
+
+	/** Builds the CSV rows */
+	FString BuildReport() const;
+
+	/** Returns the frame time at the percentile, in milliseconds */
+	static float GetPercentile(const TArray<float>& SortedValues, float Percentile);
+
+	/** GC hooks */
+	void OnPreGarbageCollect();
+	void OnPostGarbageCollect();
+};
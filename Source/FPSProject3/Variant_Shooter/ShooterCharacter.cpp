@@ -13,12 +13,46 @@
 #include "TimerManager.h"
 #include "ShooterGameMode.h"
 #include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
 #include "Engine/Engine.h"
 #include "ShooterPlayerController.h"
 #include "Weapons/ShooterProjectile.h"
 #include "Variant_Shooter/ShooterGameState.h"
+#include "Variant_Shooter/ShooterLagCompensation.h"
+#include "Variant_Shooter/ShooterDamageQuery.h"
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/PlayerState.h"
+#include "Engine/NetConnection.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Variant_Shooter/ShooterLog.h"
+#include "Variant_Shooter/ShooterStats.h"
 #include "Animation/AnimInstance.h" // for UAnimInstance
 
+static FAutoConsoleCommandWithWorld DumpInputStreamStatsCommand(
+	TEXT("Shooter.Net.InputStats"),
+	TEXT("Logs input command stream and connection bytes per second for every shooter character"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (!World)
+		{
+			return;
+		}
+
+		for (TActorIterator<AShooterCharacter> It(World); It; ++It)
+		{
+			const FShooterInputStreamStats& Stats = It->GetInputStreamStats();
+			const UNetConnection* Connection = It->GetNetConnection();
+
+			UE_LOG(LogShooterNet, Log, TEXT("InputStream [%s] Connection=%s Input=%.1f B/s Commands=%.1f/s Batches=%.1f/s ConnectionIn=%d B/s ConnectionOut=%d B/s"),
+				*It->GetName(), Connection ? *Connection->LowLevelGetRemoteAddress(true) : TEXT("Local"),
+				Stats.BytesPerSecond, Stats.CommandsPerSecond, Stats.BatchesPerSecond,
+				Connection ? Connection->InBytesPerSecond : 0, Connection ? Connection->OutBytesPerSecond : 0);
+		}
+	})
+);
+
 AShooterCharacter::AShooterCharacter()
 {
 	// create the noise emitter component
@@ -27,8 +61,9 @@ AShooterCharacter::AShooterCharacter()
 	// configure movement
 	GetCharacterMovement()->RotationRate = FRotator(0.0f, 600.0f, 0.0f);
 
-	UE_LOG(LogTemp, Log, TEXT("Set ShooterCharacter BReplicates!"));
-	bReplicates = true; 
+	bReplicates = true;
+
+	WeaponInventory.Owner = this;
 }
 
 void AShooterCharacter::BeginPlay()
@@ -37,19 +72,61 @@ void AShooterCharacter::BeginPlay()
 
 	// reset HP to max
 	CurrentHP = MaxHP;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShooterCharacter, CurrentHP, this);
 
 	BindPawnBroadcast();
 
+	// remember how the mesh sits on the capsule so a recycled character can be put back together after its ragdoll
+	MeshCollisionProfile = GetMesh()->GetCollisionProfileName();
+	CapsuleCollisionProfile = GetCapsuleComponent()->GetCollisionProfileName();
+	MeshRelativeTransform = GetMesh()->GetRelativeTransform();
+
+	// record our poses on the server so shots against us can be lag compensated
+	if (HasAuthority())
+	{
+		if (UShooterLagCompensation* LagCompensation = GetWorld()->GetSubsystem<UShooterLagCompensation>())
+		{
+			LagCompensation->RegisterCharacter(this);
+		}
+
+		// make us findable by explosions and other radius queries
+		if (UShooterDamageQuery* DamageQuery = GetWorld()->GetSubsystem<UShooterDamageQuery>())
+		{
+			DamageQuery->RegisterActor(this, GetCapsuleComponent(), GetCapsuleComponent()->GetScaledCapsuleRadius());
+		}
+	}
+
 	// update the HUD
 	OnDamaged.Broadcast(1.0f);
-	UE_LOG(LogTemp, Warning, TEXT("%s OnDamaged Broadcast in AShooterCharacter::BeginPlay"), *GetName());
+	UE_LOG(LogShooter, Verbose, TEXT("%s OnDamaged Broadcast in AShooterCharacter::BeginPlay"), *GetName());
 }
 
 void AShooterCharacter::EndPlay(EEndPlayReason::Type EndPlayReason)
 {
+	if (UShooterLagCompensation* LagCompensation = GetWorld()->GetSubsystem<UShooterLagCompensation>())
+	{
+		LagCompensation->UnregisterCharacter(this);
+	}
+
+	if (UShooterDamageQuery* DamageQuery = GetWorld()->GetSubsystem<UShooterDamageQuery>())
+	{
+		DamageQuery->UnregisterActor(this);
+	}
+
 	Super::EndPlay(EndPlayReason);
 }
 
+void AShooterCharacter::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// keep the input stream flowing while the trigger is held, and resend recent changes
+	if (IsLocallyControlled() && !HasAuthority())
+	{
+		SendInputCommand();
+	}
+}
+
 void AShooterCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
 {
 	// base class handles move, aim and jump inputs
@@ -70,10 +147,13 @@ void AShooterCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputCo
 
 float AShooterCharacter::TakeDamage(float Damage, struct FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
 {
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_ShooterTakeDamage);
+	INC_DWORD_STAT(STAT_ShooterDamageEvents);
+
 	// 仅服务端处理伤害逻辑（客户端不处理，避免数据不一致）
 	if (GetLocalRole() != ROLE_Authority)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("Client received TakeDamage - ignoring (should be handled by server)"));
+		UE_LOG(LogShooter, Verbose, TEXT("Client received TakeDamage - ignoring (should be handled by server)"));
 		return 0.0f;
 	}
 	float oldHP = CurrentHP;
@@ -85,7 +165,8 @@ float AShooterCharacter::TakeDamage(float Damage, struct FDamageEvent const& Dam
 
 	// Reduce HP
 	CurrentHP -= Damage;
-	UE_LOG(LogTemp, Log, TEXT("%s TakeDamage: Damage=%f, OldHP=%f, NewHP=%f"),
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShooterCharacter, CurrentHP, this);
+	UE_LOG(LogShooter, Verbose, TEXT("%s TakeDamage: Damage=%f, OldHP=%f, NewHP=%f"),
 		*GetName(), Damage, oldHP, CurrentHP);
 
 	// Have we depleted HP?
@@ -96,7 +177,7 @@ float AShooterCharacter::TakeDamage(float Damage, struct FDamageEvent const& Dam
 
 	// update the HUD
 	OnDamaged.Broadcast(FMath::Max(0.0f, CurrentHP / MaxHP));
-	UE_LOG(LogTemp, Warning, TEXT("%s OnDamaged Broadcast in AShooterCharacter::TakeDamage"), *GetName());
+	UE_LOG(LogShooter, VeryVerbose, TEXT("%s OnDamaged Broadcast in AShooterCharacter::TakeDamage"), *GetName());
 
 	return Damage;
 }
@@ -112,14 +193,17 @@ void AShooterCharacter::DoStartFiring()
 	//Client
 	if (GetLocalRole() != ROLE_Authority)
 	{
-		UE_LOG(LogTemp, Log, TEXT("Client DoStartFiring - Send RPC to server"));
-		Server_RequestWeaponFire(false);
-		// To Implement: Client Only firing effects
-		//CurrentWeapon->PlayFireFX_ClientOnly();
+		UE_LOG(LogShooterWeapon, Verbose, TEXT("Client DoStartFiring - Send input command to server"));
+		// tell the server which shot we start from, then fire right away. Ammo, recoil and effects are predicted locally
+		bInputFireHeld = true;
+		InputShotSequence = CurrentWeapon->GetShotSequence();
+		SendInputCommand();
+
+		CurrentWeapon->StartFiring();
 		return;
 	}
 	// Server: fire the current weapon
-	UE_LOG(LogTemp, Log, TEXT("Server DoStartFiring - Direct fire weapon"));
+	UE_LOG(LogShooterWeapon, Verbose, TEXT("Server DoStartFiring - Direct fire weapon"));
 	CurrentWeapon->StartFiring();
 }
 
@@ -134,10 +218,13 @@ void AShooterCharacter::DoStopFiring()
 	//Client
 	if (GetLocalRole() != ROLE_Authority)
 	{
-		UE_LOG(LogTemp, Log, TEXT("Client StopFiring - Send RPC to server"));
-		Server_RequestWeaponFire(true);
-		// To Implement: Client Only firing effects
-		//CurrentWeapon->PlayFireFX_ClientOnly();
+		UE_LOG(LogShooterWeapon, Verbose, TEXT("Client StopFiring - Send input command to server"));
+		// stop predicting, then tell the server how many shots we ended up firing
+		CurrentWeapon->StopFiring();
+
+		bInputFireHeld = false;
+		InputShotSequence = CurrentWeapon->GetShotSequence();
+		SendInputCommand();
 		return;
 	}
 	CurrentWeapon->StopFiring();
@@ -148,19 +235,20 @@ void AShooterCharacter::DoSwitchWeapon()
 	// ensure we have at least two weapons two switch between
 	if (OwnedWeapons.Num() > 1)
 	{
-		// find the index of the current weapon in the owned list
-		int32 WeaponIndex = OwnedWeapons.Find(CurrentWeapon);
-		// is this the last weapon?
-		if (WeaponIndex == OwnedWeapons.Num() - 1)
+		// find the slot of the current weapon in the owned list
+		const int32 CurrentIndex = OwnedWeapons.Find(CurrentWeapon);
+
+		// select the next slot holding a weapon, looping back to the beginning of the array
+		for (int32 Offset = 1; Offset < OwnedWeapons.Num(); ++Offset)
 		{
-			// loop back to the beginning of the array
-			WeaponIndex = 0;
-		}
-		else {
-			// select the next weapon index
-			++WeaponIndex;
+			const int32 WeaponIndex = (CurrentIndex + Offset) % OwnedWeapons.Num();
+
+			if (IsValid(OwnedWeapons[WeaponIndex]))
+			{
+				ChangeIntoWeapon(WeaponIndex);
+				break;
+			}
 		}
-		ChangeIntoWeapon(WeaponIndex);
 	}
 }
 
@@ -169,36 +257,48 @@ void AShooterCharacter::ChangeIntoWeapon(int WeaponIndex)
 	// Validate index locally
 	if (!OwnedWeapons.IsValidIndex(WeaponIndex))
 	{
-		UE_LOG(LogTemp, Warning, TEXT("ChangeIntoWeapon - Invalid WeaponIndex %d"), WeaponIndex);
+		UE_LOG(LogShooterWeapon, Warning, TEXT("ChangeIntoWeapon - Invalid WeaponIndex %d"), WeaponIndex);
 		return;
 	}
 
-	// If client, forward request to server
+	// If client, request the switch through the input stream. Only the owning client can ask
 	if (GetLocalRole() != ROLE_Authority)
 	{
-		UE_LOG(LogTemp, Log, TEXT("Client ChangeIntoWeapon - sending RPC to server, Index=%d"), WeaponIndex);
-		ServerChangeIntoWeapon(WeaponIndex);
+		if (IsLocallyControlled())
+		{
+			if (WeaponIndex >= (1 << FShooterInputCommand::NumWeaponIndexBits))
+			{
+				UE_LOG(LogShooterWeapon, Warning, TEXT("ChangeIntoWeapon - WeaponIndex %d can't be sent in an input command"), WeaponIndex);
+				return;
+			}
+
+			UE_LOG(LogShooterWeapon, Verbose, TEXT("Client ChangeIntoWeapon - sending input command to server, Index=%d"), WeaponIndex);
+			InputWeaponIndex = static_cast<uint8>(WeaponIndex);
+			InputWeaponSwitchCount = (InputWeaponSwitchCount + 1) & ((1 << FShooterInputCommand::NumWeaponSwitchBits) - 1);
+			SendInputCommand();
+		}
 		return;
 	}
 
-	// Server: broadcast to all clients (and server) to perform the change
-	UE_LOG(LogTemp, Log, TEXT("Server ChangeIntoWeapon - broadcasting Index=%d"), WeaponIndex);
-	MulticastChangeIntoWeapon(WeaponIndex);
+	// Server: equip it. Clients follow the replicated slot
+	UE_LOG(LogShooterWeapon, Verbose, TEXT("Server ChangeIntoWeapon - Index=%d"), WeaponIndex);
+	SetCurrentWeaponSlot(static_cast<uint8>(WeaponIndex));
 }
 
 void AShooterCharacter::DoChangeIntoWeapon(int32 WeaponIndex)
 {
-	// executed on server and all clients (via multicast)
-	if (!OwnedWeapons.IsValidIndex(WeaponIndex))
+	// executed on server and all clients (from the replicated slot). The slot may replicate
+	// before its inventory entry, in which case the entry equips the weapon once it's spawned
+	if (!OwnedWeapons.IsValidIndex(WeaponIndex) || !IsValid(OwnedWeapons[WeaponIndex]))
 	{
-		UE_LOG(LogTemp, Warning, TEXT("DoChangeIntoWeapon - Invalid index %d"), WeaponIndex);
+		UE_LOG(LogShooterWeapon, Verbose, TEXT("DoChangeIntoWeapon - No weapon spawned in slot %d yet"), WeaponIndex);
 		return;
 	}
 
 	AShooterWeapon* NewWeapon = OwnedWeapons[WeaponIndex];
-	if (!IsValid(NewWeapon))
+
+	if (NewWeapon == CurrentWeapon)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("DoChangeIntoWeapon - NewWeapon is null at index %d"), WeaponIndex);
 		return;
 	}
 
@@ -245,8 +345,8 @@ void AShooterCharacter::UpdateWeaponHUD(int32 CurrentAmmo, int32 MagazineSize)
 	// Forward the update to the owning client when this actor is server-authoritative and not locally controlled.
 	if (GetLocalRole() == ROLE_Authority && !IsLocallyControlled())
 	{
-		// send to owning client
-		Client_UpdateWeaponHUD(CurrentAmmo, MagazineSize);
+		// send to owning client, tagged with the shot count so it can reconcile its predicted ammo
+		Client_UpdateWeaponHUD(CurrentAmmo, MagazineSize, CurrentWeapon ? CurrentWeapon->GetShotSequence() : 0);
 		return;
 	}
 
@@ -254,9 +354,18 @@ void AShooterCharacter::UpdateWeaponHUD(int32 CurrentAmmo, int32 MagazineSize)
 	OnBulletCountUpdated.Broadcast(MagazineSize, CurrentAmmo);
 }
 
-void AShooterCharacter::Client_UpdateWeaponHUD_Implementation(int32 CurrentAmmo, int32 MagazineSize)
+void AShooterCharacter::Client_UpdateWeaponHUD_Implementation(int32 CurrentAmmo, int32 MagazineSize, uint16 ShotSequence)
 {
-	// Running on owning client: broadcast to trigger Blueprint HUD update bound to the delegate.
+	INC_DWORD_STAT(STAT_ShooterRPCs);
+
+	// Running on owning client: apply the server's ammo on top of any shots it hasn't seen yet
+	if (IsValid(CurrentWeapon))
+	{
+		CurrentWeapon->ReconcileAmmo(CurrentAmmo, ShotSequence);
+		CurrentAmmo = CurrentWeapon->GetBulletCount();
+	}
+
+	// broadcast to trigger Blueprint HUD update bound to the delegate.
 	OnBulletCountUpdated.Broadcast(MagazineSize, CurrentAmmo);
 }
 
@@ -266,47 +375,217 @@ FVector AShooterCharacter::GetWeaponTargetLocation()
 	FHitResult OutHit;
 
 	const FVector Start = GetFirstPersonCameraComponent()->GetComponentLocation();
-	const FVector Forward = GetFirstPersonCameraComponent()->GetForwardVector();
+	// remote players aim along their latest input command on the server
+	const FVector Forward = (HasAuthority() && !IsLocallyControlled() && bHasProcessedInput)
+		? LastProcessedInput.GetAimRotation().Vector()
+		: GetFirstPersonCameraComponent()->GetForwardVector();
 	const FVector End = Start + (Forward * MaxAimDistance);
-	FString forwardString = Forward.ToString();
-	UE_LOG(LogTemp, Log, TEXT("GetWeaponTargetLocation: Forward = %s"), *forwardString);
 
 	FCollisionQueryParams QueryParams;
 	QueryParams.AddIgnoredActor(this);
 
-	GetWorld()->LineTraceSingleByChannel(OutHit, Start, End, ECC_Visibility, QueryParams);
+	// aim at other characters where our client saw them, not where the server has them now
+	if (UShooterLagCompensation* LagCompensation = GetWorld()->GetSubsystem<UShooterLagCompensation>())
+	{
+		LagCompensation->LineTraceRewound(OutHit, Start, End, ECC_Visibility, QueryParams, this);
+
+	} else {
+
+		INC_DWORD_STAT(STAT_ShooterTraces);
+		GetWorld()->LineTraceSingleByChannel(OutHit, Start, End, ECC_Visibility, QueryParams);
+	}
 
 	// return either the impact point or the trace end
 	return OutHit.bBlockingHit ? OutHit.ImpactPoint : OutHit.TraceEnd;
 }
 
+double AShooterCharacter::GetClientServerTime() const
+{
+	// the game state keeps the client's clock synced to the server
+	if (const AGameStateBase* GameState = GetWorld()->GetGameState())
+	{
+		return GameState->GetServerWorldTimeSeconds();
+	}
+
+	return GetWorld()->GetTimeSeconds();
+}
+
+double AShooterCharacter::GetClientViewTime() const
+{
+	double ViewTime = GetClientServerTime();
+
+	// other characters' movement reaches us half a round trip after the server simulated it
+	if (const APlayerState* OwnPlayerState = GetPlayerState())
+	{
+		ViewTime -= OwnPlayerState->GetPingInMilliseconds() * 0.0005;
+	}
+
+	// and is then smoothed over this long before we see it
+	const UCharacterMovementComponent* Movement = GetCharacterMovement();
+
+	if (Movement->NetworkSmoothingMode != ENetworkSmoothingMode::Disabled)
+	{
+		ViewTime -= Movement->NetworkSimulatedSmoothLocationTime;
+	}
+
+	return ViewTime;
+}
+
 void AShooterCharacter::AddWeaponClass(const TSubclassOf<AShooterWeapon>& WeaponClass)
 {
+	// the inventory is server state. Clients spawn their weapons as it replicates to them
+	if (!HasAuthority() || !WeaponClass)
+	{
+		return;
+	}
+
 	// do we already own this weapon?
-	AShooterWeapon* OwnedWeapon = FindWeaponOfType(WeaponClass);
+	if (FShooterWeaponInventoryEntry* OwnedEntry = WeaponInventory.FindWeaponClass(WeaponClass))
+	{
+		// refill it here and on every client
+		++OwnedEntry->RefillCount;
+		WeaponInventory.MarkItemDirty(*OwnedEntry);
+		MARK_PROPERTY_DIRTY_FROM_NAME(AShooterCharacter, WeaponInventory, this);
+
+		OnWeaponEntryChanged(*OwnedEntry);
+		return;
+	}
+
+	// the slot has to fit in an input command weapon switch request
+	const int32 Slot = WeaponInventory.Entries.Num();
 
-	if (!OwnedWeapon)
+	if (Slot >= (1 << FShooterInputCommand::NumWeaponIndexBits))
 	{
-		// spawn the new weapon
-		FActorSpawnParameters SpawnParams;
-		SpawnParams.Owner = this;
-		SpawnParams.Instigator = this;
-		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
-		SpawnParams.TransformScaleMethod = ESpawnActorScaleMethod::MultiplyWithRoot;
+		UE_LOG(LogShooterWeapon, Warning, TEXT("AddWeaponClass - Inventory full, can't add %s"), *GetNameSafe(WeaponClass));
+		return;
+	}
 
-		AShooterWeapon* AddedWeapon = GetWorld()->SpawnActor<AShooterWeapon>(WeaponClass, GetActorTransform(), SpawnParams);
+	FShooterWeaponInventoryEntry& NewEntry = WeaponInventory.Entries.AddDefaulted_GetRef();
+	NewEntry.WeaponClass = WeaponClass;
+	NewEntry.Slot = static_cast<uint8>(Slot);
 
-		if (AddedWeapon)
-		{
-			// add the weapon to the owned list
-			OwnedWeapons.Add(AddedWeapon);
-			int32 WeaponIndex = OwnedWeapons.Find(AddedWeapon);
-			ChangeIntoWeapon(WeaponIndex);
-		}
+	WeaponInventory.MarkItemDirty(NewEntry);
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShooterCharacter, WeaponInventory, this);
+
+	// spawn our copy and switch to it
+	OnWeaponEntryAdded(NewEntry);
+	SetCurrentWeaponSlot(NewEntry.Slot);
+}
+
+void AShooterCharacter::OnWeaponEntryAdded(const FShooterWeaponInventoryEntry& Entry)
+{
+	if (!Entry.WeaponClass || (OwnedWeapons.IsValidIndex(Entry.Slot) && IsValid(OwnedWeapons[Entry.Slot])))
+	{
+		return;
 	}
-	else {
-		OwnedWeapon->Reload();
+
+	// spawn the new weapon
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.Owner = this;
+	SpawnParams.Instigator = this;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.TransformScaleMethod = ESpawnActorScaleMethod::MultiplyWithRoot;
+
+	AShooterWeapon* AddedWeapon = GetWorld()->SpawnActor<AShooterWeapon>(Entry.WeaponClass, GetActorTransform(), SpawnParams);
+
+	if (!AddedWeapon)
+	{
+		return;
 	}
+
+	// add the weapon to the owned list under its slot
+	if (!OwnedWeapons.IsValidIndex(Entry.Slot))
+	{
+		OwnedWeapons.SetNum(Entry.Slot + 1);
+	}
+
+	OwnedWeapons[Entry.Slot] = AddedWeapon;
+
+	// equip it if the slot already replicated, otherwise keep it holstered
+	if (CurrentWeaponSlot == Entry.Slot)
+	{
+		DoChangeIntoWeapon(Entry.Slot);
+	}
+	else
+	{
+		AddedWeapon->DeactivateWeapon();
+	}
+}
+
+void AShooterCharacter::OnWeaponEntryChanged(const FShooterWeaponInventoryEntry& Entry)
+{
+	// the only change to an entry is a refill
+	if (OwnedWeapons.IsValidIndex(Entry.Slot) && IsValid(OwnedWeapons[Entry.Slot]))
+	{
+		OwnedWeapons[Entry.Slot]->Reload();
+	}
+}
+
+void AShooterCharacter::OnWeaponEntryRemoved(const FShooterWeaponInventoryEntry& Entry)
+{
+	if (!OwnedWeapons.IsValidIndex(Entry.Slot))
+	{
+		return;
+	}
+
+	AShooterWeapon* Weapon = OwnedWeapons[Entry.Slot];
+	OwnedWeapons[Entry.Slot] = nullptr;
+
+	if (Weapon == CurrentWeapon)
+	{
+		CurrentWeapon = nullptr;
+	}
+
+	if (IsValid(Weapon))
+	{
+		Weapon->Destroy();
+	}
+}
+
+void AShooterCharacter::SetCurrentWeaponSlot(uint8 Slot)
+{
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	CurrentWeaponSlot = Slot;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShooterCharacter, CurrentWeaponSlot, this);
+
+	DoChangeIntoWeapon(Slot);
+}
+
+void AShooterCharacter::OnRep_CurrentWeaponSlot()
+{
+	// the weapons were cleared, their entries remove them
+	if (CurrentWeaponSlot == NoWeaponSlot)
+	{
+		return;
+	}
+
+	DoChangeIntoWeapon(CurrentWeaponSlot);
+}
+
+void AShooterCharacter::ClearWeapons()
+{
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	for (const FShooterWeaponInventoryEntry& Entry : WeaponInventory.Entries)
+	{
+		OnWeaponEntryRemoved(Entry);
+	}
+
+	WeaponInventory.Entries.Reset();
+	WeaponInventory.MarkArrayDirty();
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShooterCharacter, WeaponInventory, this);
+
+	OwnedWeapons.Reset();
+
+	CurrentWeaponSlot = NoWeaponSlot;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShooterCharacter, CurrentWeaponSlot, this);
 }
 
 void AShooterCharacter::OnWeaponActivated(AShooterWeapon* Weapon)
@@ -320,20 +599,10 @@ void AShooterCharacter::OnWeaponActivated(AShooterWeapon* Weapon)
 		// Owning client sets first-person anim instance
 		GetFirstPersonMesh()->SetAnimInstanceClass(Weapon->GetFirstPersonAnimInstanceClass());
 	}
-	//GetMesh()->SetAnimInstanceClass(Weapon->GetThirdPersonAnimInstanceClass());
-	// Server broadcasts to all clients with the third-person anim class (safer than sending weapon pointer)
-	if (HasAuthority())
-	{
-		Multicast_OnWeaponActivated_ChangeAnim(Weapon->GetThirdPersonAnimInstanceClass());
-	}
-}
 
-void AShooterCharacter::Multicast_OnWeaponActivated_ChangeAnim_Implementation(TSubclassOf<UAnimInstance> ThirdPersonAnimClass)
-{
-	// All clients run this. Set the third-person anim instance so remote views animate correctly.
-	// It's safe to call on the owning client too (third-person mesh may be owner-no-see).
-	UE_LOG(LogTemp, Log, TEXT("%s 设置第三人称动画实例（ChangeAim）"), *GetName());
-	if (ThirdPersonAnimClass)
+	// every machine activates the weapon from the replicated slot, so the third-person anim instance is set locally.
+	// It's safe to set on the owning client too (third-person mesh may be owner-no-see).
+	if (TSubclassOf<UAnimInstance> ThirdPersonAnimClass = Weapon->GetThirdPersonAnimInstanceClass())
 	{
 		GetMesh()->SetAnimInstanceClass(ThirdPersonAnimClass);
 	}
@@ -349,12 +618,35 @@ void AShooterCharacter::OnSemiWeaponRefire()
 	// unused
 }
 
+void AShooterCharacter::NotifyHitscanImpact(const FVector& TraceStart, const FVector& ImpactPoint, const FVector& ImpactNormal)
+{
+	// send the compact impact event to everyone, including the server
+	Multicast_OnHitscanImpact(TraceStart, ImpactPoint, ImpactNormal);
+}
+
+void AShooterCharacter::Multicast_OnHitscanImpact_Implementation(FVector_NetQuantize TraceStart, FVector_NetQuantize ImpactPoint, FVector_NetQuantizeNormal ImpactNormal)
+{
+	INC_DWORD_STAT(STAT_ShooterRPCs);
+
+	// every machine holds its own copy of the current weapon, let it play the effects
+	if (IsValid(CurrentWeapon))
+	{
+		// the owning client already played this shot when it predicted it
+		if (IsLocallyControlled() && !HasAuthority() && CurrentWeapon->PredictsImpactEffects())
+		{
+			return;
+		}
+
+		CurrentWeapon->BP_OnHitscanImpact(TraceStart, ImpactPoint, ImpactNormal);
+	}
+}
+
 AShooterWeapon* AShooterCharacter::FindWeaponOfType(TSubclassOf<AShooterWeapon> WeaponClass) const
 {
 	// check each owned weapon
 	for (AShooterWeapon* Weapon : OwnedWeapons)
 	{
-		if (Weapon->IsA(WeaponClass))
+		if (IsValid(Weapon) && Weapon->IsA(WeaponClass))
 		{
 			return Weapon;
 		}
@@ -365,18 +657,8 @@ AShooterWeapon* AShooterCharacter::FindWeaponOfType(TSubclassOf<AShooterWeapon>
 
 }
 
-void AShooterCharacter::Die(AActor* DamageCauser)
+AShooterCharacter* AShooterCharacter::FindKiller(AActor* DamageCauser)
 {
-	if (!HasAuthority()) {
-		UE_LOG(LogTemp, Error, TEXT("Client attempted to call Die() - ignoring (should be handled by server)"));
-		return;
-	}
-
-	// local and client effects
-	Die_Local();
-	Multicast_NotifyDie();
-
-	// Determine killer character: direct actor or via projectile -> weapon -> owner
 	AShooterCharacter* Killer = nullptr;
 
 	// If damage causer is a projectile, try to locate weapon and its owner
@@ -391,12 +673,38 @@ void AShooterCharacter::Die(AActor* DamageCauser)
 		}
 	}
 
+	// Hitscan shots use the weapon itself as the damage causer
+	if (!Killer)
+	{
+		if (AShooterWeapon* FromWeapon = Cast<AShooterWeapon>(DamageCauser))
+		{
+			Killer = Cast<AShooterCharacter>(FromWeapon->GetOwner());
+		}
+	}
+
 	// If not found via projectile, check if DamageCauser is directly a character
 	if (!Killer)
 	{
 		Killer = Cast<AShooterCharacter>(DamageCauser);
 	}
 
+	return Killer;
+}
+
+void AShooterCharacter::Die(AActor* DamageCauser)
+{
+	if (!HasAuthority()) {
+		UE_LOG(LogShooter, Error, TEXT("Client attempted to call Die() - ignoring (should be handled by server)"));
+		return;
+	}
+
+	// local and client effects
+	Die_Local();
+	Multicast_NotifyDie();
+
+	// Determine killer character: direct actor or via projectile -> weapon -> owner
+	AShooterCharacter* Killer = FindKiller(DamageCauser);
+
 	// award point to killer's team if we found a killer character
 	if (AShooterGameMode* GM = Cast<AShooterGameMode>(GetWorld()->GetAuthGameMode()))
 	{
@@ -405,13 +713,13 @@ void AShooterCharacter::Die(AActor* DamageCauser)
 			const uint8 KillerTeam = Killer->GetTeamByte();
 			const uint8 VictimTeam = GetTeamByte();
 			if (KillerTeam != VictimTeam) {
-				UE_LOG(LogTemp, Log, TEXT("Die: awarding point to team %d (killer %s)"), KillerTeam, *Killer->GetName());
+				UE_LOG(LogShooterGameMode, Log, TEXT("Die: awarding point to team %d (killer %s)"), KillerTeam, *Killer->GetName());
 				GM->IncrementTeamScore(KillerTeam);
 			}
 		}
 		else
 		{
-			UE_LOG(LogTemp, Log, TEXT("Die: No killer character identified; no team awarded"));
+			UE_LOG(LogShooterGameMode, Log, TEXT("Die: No killer character identified; no team awarded"));
 		}
 
 		bool isGameOver = false;
@@ -431,7 +739,7 @@ void AShooterCharacter::Die(AActor* DamageCauser)
 	}
 
 	// DO NOT Destroy() here so death animation / ragdoll can play on server + clients.
-	// GameMode will destroy the old pawn right before respawning a new one.
+	// GameMode will reuse or destroy the old pawn when it respawns the controller.
 }
 
 void AShooterCharacter::Die_Local()
@@ -453,41 +761,221 @@ void AShooterCharacter::Die_Local()
 
 void AShooterCharacter::Multicast_NotifyDie_Implementation()
 {
+	INC_DWORD_STAT(STAT_ShooterRPCs);
+
 	Die_Local(); // 客户端执行本地死亡逻辑
 }
 
 void AShooterCharacter::OnRespawn()
 {
 	// kept for compatibility, no-op (respawn managed by GameMode)
-	UE_LOG(LogTemp, Verbose, TEXT("AShooterCharacter::OnRespawn called - respawn handled by GameMode"));
+	UE_LOG(LogShooter, Verbose, TEXT("AShooterCharacter::OnRespawn called - respawn handled by GameMode"));
+}
+
+void AShooterCharacter::ResetForRespawn(const FTransform& SpawnTransform)
+{
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	// restore HP
+	CurrentHP = MaxHP;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShooterCharacter, CurrentHP, this);
+
+	// move to the chosen start
+	TeleportTo(SpawnTransform.GetLocation(), SpawnTransform.Rotator(), false, true);
+
+	// restart the pose history so shots aren't rewound to where we died
+	if (UShooterLagCompensation* LagCompensation = GetWorld()->GetSubsystem<UShooterLagCompensation>())
+	{
+		LagCompensation->UnregisterCharacter(this);
+		LagCompensation->RegisterCharacter(this);
+	}
+
+	// drop the weapons, a respawned character starts empty handed like a freshly spawned one.
+	// Clients destroy theirs as the emptied inventory replicates
+	ClearWeapons();
+
+	// server and clients undo the death effects
+	Multicast_NotifyRespawn();
+}
+
+void AShooterCharacter::ResetForRespawn_Local()
+{
+	// undo the death ragdoll: stop simulating and put the mesh back on the capsule where it was spawned
+	USkeletalMeshComponent* ThirdPersonMesh = GetMesh();
+	ThirdPersonMesh->SetSimulatePhysics(false);
+	ThirdPersonMesh->SetCollisionProfileName(MeshCollisionProfile);
+	ThirdPersonMesh->AttachToComponent(GetCapsuleComponent(), FAttachmentTransformRules::KeepRelativeTransform);
+	ThirdPersonMesh->SetRelativeTransform(MeshRelativeTransform);
+
+	GetCapsuleComponent()->SetCollisionProfileName(CapsuleCollisionProfile);
+
+	// restore collision, movement and controls
+	SetActorEnableCollision(true);
+	GetCharacterMovement()->SetMovementMode(MOVE_Walking);
+	EnableInput(nullptr);
+
+	// reset the HUD
+	OnBulletCountUpdated.Broadcast(0, 0);
+	OnDamaged.Broadcast(1.0f);
+
+	// call the BP handler for any other death effects
+	BP_OnRespawn();
+}
+
+void AShooterCharacter::Multicast_NotifyRespawn_Implementation()
+{
+	INC_DWORD_STAT(STAT_ShooterRPCs);
+
+	ResetForRespawn_Local();
 }
 
-/*void AShooterCharacter::Server_RequestWeaponFire()
+void AShooterCharacter::SendInputCommand()
 {
-	UE_LOG(LogTemp, Warning, TEXT("Client RPC - Request weapon fire on server. Function Not Implemented."));
-}*/
+	// build the command from the current input state
+	FShooterInputCommand Command;
+	Command.Sequence = NextInputSequence;
+	Command.Buttons = bInputFireHeld ? FShooterInputCommand::ButtonFire : 0;
+	Command.WeaponIndex = InputWeaponIndex;
+	Command.WeaponSwitchCount = InputWeaponSwitchCount;
+	Command.ShotSequence = InputShotSequence;
+	Command.SetAimRotation(GetControlRotation());
+	Command.SetViewTime(GetClientViewTime());
+
+	// a change is sent in the next few packets too, in case some of them are dropped
+	const bool bChanged = SentInputCommands.Num() == 0 ? Command.HasInputChanged(FShooterInputCommand()) : Command.HasInputChanged(SentInputCommands[0]);
+
+	if (bChanged)
+	{
+		InputResendsLeft = InputResendCount;
+
+	} else if (!bInputFireHeld) {
+
+		// idle. Send while a change still has resends left, then only a slow heartbeat in case all of them were dropped
+		if (InputResendsLeft > 0)
+		{
+			--InputResendsLeft;
+
+		} else if (GetWorld()->GetTimeSeconds() - LastInputSendTime < InputHeartbeatInterval) {
+
+			return;
+		}
+	}
+
+	++NextInputSequence;
+
+	// keep the newest commands, newest first
+	if (SentInputCommands.Num() == FShooterInputCommandBatch::MaxCommands)
+	{
+		SentInputCommands.Pop(EAllowShrinking::No);
+	}
+
+	SentInputCommands.Insert(Command, 0);
+
+	FShooterInputCommandBatch Batch;
+	Batch.Commands = SentInputCommands;
+
+	InputStreamStats.Record(GetWorld()->GetTimeSeconds(), Batch.GetNumBits(), 1);
 
-bool AShooterCharacter::Server_RequestWeaponFire_Validate(bool StopFire)
+	LastInputSendTime = GetWorld()->GetTimeSeconds();
+
+	Server_SendInputCommands(Batch);
+}
+
+bool AShooterCharacter::Server_SendInputCommands_Validate(const FShooterInputCommandBatch& Batch)
 {
-	return CurrentWeapon != nullptr;
+	return Batch.Commands.Num() > 0 && Batch.Commands.Num() <= FShooterInputCommandBatch::MaxCommands;
 }
 
-void AShooterCharacter::Server_RequestWeaponFire_Implementation(bool StopFire)
+void AShooterCharacter::Server_SendInputCommands_Implementation(const FShooterInputCommandBatch& Batch)
+{
+	INC_DWORD_STAT(STAT_ShooterRPCs);
+
+	int32 NumNewCommands = 0;
+
+	// apply the commands we haven't seen yet, oldest first. The signed sequence difference survives wrap around
+	for (int32 Index = Batch.Commands.Num() - 1; Index >= 0; --Index)
+	{
+		const FShooterInputCommand& Command = Batch.Commands[Index];
+
+		if (bHasProcessedInput && static_cast<int16>(Command.Sequence - LastProcessedInput.Sequence) <= 0)
+		{
+			continue;
+		}
+
+		// make the command current before applying it, so shots it starts aim along its own rotation
+		const FShooterInputCommand PreviousCommand = LastProcessedInput;
+
+		LastProcessedInput = Command;
+		bHasProcessedInput = true;
+		++NumNewCommands;
+
+		ApplyInputCommand(Command, PreviousCommand);
+	}
+
+	InputStreamStats.Record(GetWorld()->GetTimeSeconds(), Batch.GetNumBits(), NumNewCommands);
+}
+
+void AShooterCharacter::ApplyInputCommand(const FShooterInputCommand& Command, const FShooterInputCommand& PreviousCommand)
+{
+	// switch weapons on a new switch request
+	if (Command.WeaponSwitchCount != PreviousCommand.WeaponSwitchCount)
+	{
+		if (OwnedWeapons.IsValidIndex(Command.WeaponIndex) && IsValid(OwnedWeapons[Command.WeaponIndex]) && OwnedWeapons[Command.WeaponIndex] != CurrentWeapon)
+		{
+			UE_LOG(LogShooterNet, Verbose, TEXT("ApplyInputCommand - Weapon switch request, Index=%d"), Command.WeaponIndex);
+			// Server authoritative: clients follow the replicated slot
+			SetCurrentWeaponSlot(Command.WeaponIndex);
+		}
+	}
+
+	// start or stop firing when the trigger changes
+	if (Command.IsFiring() != PreviousCommand.IsFiring())
+	{
+		HandleFireInput(!Command.IsFiring(), Command.GetViewTime(GetWorld()->GetTimeSeconds()), Command.ShotSequence);
+	}
+}
+
+void AShooterCharacter::HandleFireInput(bool bStopFire, double ViewTime, uint16 ShotSequence)
 {
 	if (!HasAuthority() || !CurrentWeapon) return;
 
-	UE_LOG(LogTemp, Warning, TEXT("Server RPC - Trigger weapon fire"));
-	if(StopFire)
+	// remember how far behind the client's view was, so its shots are validated against what it saw
+	if (UShooterLagCompensation* LagCompensation = GetWorld()->GetSubsystem<UShooterLagCompensation>())
+	{
+		LagCompensation->SetShooterTimestamp(this, ViewTime);
+	}
+
+	// line our shot count up with the client's, so each ammo update we send matches one of its predicted shots
+	CurrentWeapon->SetShotSequence(ShotSequence);
+
+	UE_LOG(LogShooterNet, Verbose, TEXT("Server input - Trigger weapon fire"));
+	if (bStopFire)
+	{
 		CurrentWeapon->StopFiring();
+
+		// send the authoritative ammo so the client's prediction settles on it
+		UpdateWeaponHUD(CurrentWeapon->GetBulletCount(), CurrentWeapon->GetMagazineSize());
+	}
 	else
+	{
 		CurrentWeapon->StartFiring();
+	}
 }
 
 void AShooterCharacter::GetLifetimeReplicatedProps(TArray <FLifetimeProperty>& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(AShooterCharacter, CurrentHP);
+	// HP only changes on damage, so it's only compared when marked dirty
+	FDoRepLifetimeParams SharedParams;
+	SharedParams.bIsPushBased = true;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShooterCharacter, CurrentHP, SharedParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShooterCharacter, WeaponInventory, SharedParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShooterCharacter, CurrentWeaponSlot, SharedParams);
 }
 
 void AShooterCharacter::OnRep_CurrentHealth()
@@ -497,9 +985,9 @@ void AShooterCharacter::OnRep_CurrentHealth()
 
 void AShooterCharacter::OnHealthUpdate()
 {
-	UE_LOG(LogTemp, Log, TEXT("%s OnRep_CurrentHealth: NewHP=%f"), *GetName(), CurrentHP);
+	UE_LOG(LogShooter, Verbose, TEXT("%s OnRep_CurrentHealth: NewHP=%f"), *GetName(), CurrentHP);
 	OnDamaged.Broadcast(FMath::Max(0.0f, CurrentHP / MaxHP));
-	UE_LOG(LogTemp, Warning, TEXT("%s OnDamaged Broadcast in AShooterCharacter::OnHealthUpdate"), *GetName());
+	UE_LOG(LogShooter, VeryVerbose, TEXT("%s OnDamaged Broadcast in AShooterCharacter::OnHealthUpdate"), *GetName());
 	//Client
 	if (IsLocallyControlled())
 	{
@@ -526,32 +1014,6 @@ void AShooterCharacter::OnHealthUpdate()
 	*/
 }
 
-// 服务器 RPC 实现：仅服务端执行
-void AShooterCharacter::ServerNotifyPickUpWeapon_Implementation(AShooterPickup* Pickup)
-{
-	Pickup->GivePickupToHolder(this);
-	// 广播到所有客户端执行
-	MulticastPickUpWeapon(Pickup);
-}
-
-bool AShooterCharacter::ServerNotifyPickUpWeapon_Validate(AShooterPickup* Pickup)
-{
-	return Pickup != nullptr; // 简单验证：武器类不为空
-}
-
-// 多播 RPC 实现：所有客户端执行添加武器逻辑
-void AShooterCharacter::MulticastPickUpWeapon_Implementation(AShooterPickup* Pickup)
-{
-	// 客户端执行添加武器（本地角色视角同步）
-	//UE_LOG(LogTemp, Log, TEXT("MulticastPickUpWeapon - 通过网络传播，玩家获得武器: %s"), *Pickup->GetName());
-	Pickup->GivePickupToHolder(this);
-}
-
-bool AShooterCharacter::MulticastPickUpWeapon_Validate(AShooterPickup* Pickup)
-{
-	return Pickup != nullptr;
-}
-
 void AShooterCharacter::BindPawnBroadcast()
 {
 	// 注册一些广播事件
@@ -562,10 +1024,10 @@ void AShooterCharacter::BindPawnBroadcast()
 		{
 			// 绑定子弹更新事件到 PlayerController 的处理函数
 			// 注意：AddDynamic 的第一个参数必须是实现回调函数的对象实例（这里是 PC）
-			OnBulletCountUpdated.AddDynamic(PC, &AShooterPlayerController::OnBulletCountUpdated);
-			OnDamaged.AddDynamic(PC, &AShooterPlayerController::OnPawnDamaged);
-			OnDestroyed.AddDynamic(PC, &AShooterPlayerController::OnPawnDestroyed);
-			Tags.Add(PC->PlayerPawnTag);
+			OnBulletCountUpdated.AddUniqueDynamic(PC, &AShooterPlayerController::OnBulletCountUpdated);
+			OnDamaged.AddUniqueDynamic(PC, &AShooterPlayerController::OnPawnDamaged);
+			OnDestroyed.AddUniqueDynamic(PC, &AShooterPlayerController::OnPawnDestroyed);
+			Tags.AddUnique(PC->PlayerPawnTag);
 			OnDamaged.Broadcast(1.0f);
 		}
 	}
@@ -580,7 +1042,7 @@ uint8 AShooterCharacter::GetTeamByte() const
 	}
 	else
 	{
-		UE_LOG(LogTemp, Error, TEXT("%s GetTeamByte: No PlayerController found, defaulting to team 0"), *GetName());
+		UE_LOG(LogShooter, Error, TEXT("%s GetTeamByte: No PlayerController found, defaulting to team 0"), *GetName());
 	}
 	return 0; // Default team
 }
@@ -601,29 +1063,4 @@ uint16 AShooterCharacter::GetPlayerNetworkID()
 		return PC->NetworkPlayerID;
 	}
 	return 0;
-}
-
-/** Server RPC: client->server request to change weapon */
-bool AShooterCharacter::ServerChangeIntoWeapon_Validate(int32 WeaponIndex)
-{
-	// simple validation: index in bounds and weapon exists
-	return OwnedWeapons.IsValidIndex(WeaponIndex) && IsValid(OwnedWeapons[WeaponIndex]);
-}
-
-void AShooterCharacter::ServerChangeIntoWeapon_Implementation(int32 WeaponIndex)
-{
-	if (!HasAuthority())
-	{
-		return;
-	}
-	UE_LOG(LogTemp, Log, TEXT("ServerChangeIntoWeapon_Implementation - Received request, Index=%d"), WeaponIndex);
-	// Server authoritative: broadcast to all clients (and server) to perform the change
-	MulticastChangeIntoWeapon(WeaponIndex);
-}
-
-/** Multicast RPC implementation: executed on server + all clients */
-void AShooterCharacter::MulticastChangeIntoWeapon_Implementation(int32 WeaponIndex)
-{
-	UE_LOG(LogTemp, Log, TEXT("MulticastChangeIntoWeapon_Implementation - Executing change on all clients, Index=%d"), WeaponIndex);
-	DoChangeIntoWeapon(WeaponIndex);
 }
\ No newline at end of file
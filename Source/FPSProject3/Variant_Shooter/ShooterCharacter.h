@@ -7,6 +7,8 @@
 #include "ShooterWeaponHolder.h"
 #include "GameFramework\Character.h"
 #include "Weapons/ShooterPickup.h"
+#include "ShooterInputCommand.h"
+#include "Weapons/ShooterWeaponInventory.h"
 #include "ShooterCharacter.generated.h"
 
 class AShooterWeapon;
@@ -68,17 +70,80 @@ protected:
 	UFUNCTION(BlueprintCallable, Category = "Team")
 	uint8 GetTeamByte() const;
 
-	/** List of weapons picked up by the character */
+	/** Local weapon actors spawned from the inventory, indexed by inventory slot */
 	TArray<AShooterWeapon*> OwnedWeapons;
 
+	/** Replicated weapon inventory. Every machine spawns its own weapon actors from it */
+	UPROPERTY(Replicated)
+	FShooterWeaponInventory WeaponInventory;
+
+	/** Inventory slot of the equipped weapon, or NoWeaponSlot */
+	UPROPERTY(ReplicatedUsing = OnRep_CurrentWeaponSlot)
+	uint8 CurrentWeaponSlot = NoWeaponSlot;
+
+	/** Equips the replicated weapon slot */
+	UFUNCTION()
+	void OnRep_CurrentWeaponSlot();
+
 	/** Weapon currently equipped and ready to shoot with */
 	TObjectPtr<AShooterWeapon> CurrentWeapon;
 
 	UPROPERTY(EditAnywhere, Category ="Destruction", meta = (ClampMin = 0, ClampMax = 10, Units = "s"))
 	float RespawnTime = 5.0f;
 
+	/** Third person mesh and capsule collision as spawned, restored when the character is recycled */
+	FName MeshCollisionProfile;
+	FName CapsuleCollisionProfile;
+
+	/** Third person mesh placement on the capsule as spawned, restored when the character is recycled */
+	FTransform MeshRelativeTransform;
+
+	/** Number of extra packets each input change is sent in, on top of the redundancy within a batch */
+	UPROPERTY(EditAnywhere, Category ="Input", meta = (ClampMin = 0, ClampMax = 10))
+	int32 InputResendCount = 3;
+
+	/** Input commands most recently sent to the server, newest first. Owning client only */
+	TArray<FShooterInputCommand, TInlineAllocator<FShooterInputCommandBatch::MaxCommands>> SentInputCommands;
+
+	/** Sequence number of the next input command. Owning client only */
+	uint16 NextInputSequence = 0;
+
+	/** Remaining resends of the last input change. Owning client only */
+	int32 InputResendsLeft = 0;
+
+	/** Seconds between commands while the input is idle, so a release lost past its resends still reaches the server */
+	UPROPERTY(EditAnywhere, Category ="Input", meta = (ClampMin = 0, ClampMax = 5, Units = "s"))
+	float InputHeartbeatInterval = 0.25f;
+
+	/** Time the last input command was sent. Owning client only */
+	double LastInputSendTime = 0.0;
+
+	/** True while the local player holds the trigger. Owning client only */
+	bool bInputFireHeld = false;
+
+	/** Weapon index of the last weapon switch request. Owning client only */
+	uint8 InputWeaponIndex = 0;
+
+	/** Counter of weapon switch requests, wrapped to the bits sent. Owning client only */
+	uint8 InputWeaponSwitchCount = 0;
+
+	/** Weapon shot count at the last trigger change. Owning client only */
+	uint16 InputShotSequence = 0;
+
+	/** Last input command applied on the server */
+	FShooterInputCommand LastProcessedInput;
+
+	/** True once the server has applied an input command from this character's client */
+	bool bHasProcessedInput = false;
+
+	/** Input stream bandwidth. Counts sent bytes on the owning client and received bytes on the server */
+	FShooterInputStreamStats InputStreamStats;
+
 public:
 
+	/** CurrentWeaponSlot value when no weapon is equipped */
+	static constexpr uint8 NoWeaponSlot = MAX_uint8;
+
 	/** Bullet count updated delegate */
 	FBulletCountUpdatedDelegate OnBulletCountUpdated;
 
@@ -98,6 +163,13 @@ protected:
 	/** Gameplay cleanup */
 	virtual void EndPlay(EEndPlayReason::Type EndPlayReason) override;
 
+public:
+
+	/** Sends the input command stream from the owning client */
+	virtual void Tick(float DeltaTime) override;
+
+protected:
+
 	/** Set up input action bindings */
 	virtual void SetupPlayerInputComponent(UInputComponent* InputComponent) override;
 
@@ -106,6 +178,15 @@ public:
 	/** Handle incoming damage */
 	virtual float TakeDamage(float Damage, struct FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser) override;
 
+	/** Returns true once this character's HP has been depleted */
+	bool IsDead() const { return CurrentHP <= 0.0f; }
+
+	/** Returns the character credited with damage from the causer: the owner of the projectile's weapon, the owner of a hitscan weapon, or the causer itself */
+	static AShooterCharacter* FindKiller(AActor* DamageCauser);
+
+	/** Brings this dead character back at the spawn transform so the GameMode can reuse it instead of spawning a new one. Server only */
+	void ResetForRespawn(const FTransform& SpawnTransform);
+
 public:
 
 	/** Handles start firing input */
@@ -144,6 +225,12 @@ public:
 	/** Calculates and returns the aim location for the weapon */
 	virtual FVector GetWeaponTargetLocation() override;
 
+	/** Returns this client's estimate of the current server world time */
+	double GetClientServerTime() const;
+
+	/** Returns the server time of the world state this client is viewing. Remote characters arrive half a round trip late and are smoothed behind that */
+	double GetClientViewTime() const;
+
 	/** Gives a weapon of this class to the owner */
 	virtual void AddWeaponClass(const TSubclassOf<AShooterWeapon>& WeaponClass) override;
 
@@ -156,6 +243,9 @@ public:
 	/** Notifies the owner that the weapon cooldown has expired and it's ready to shoot again */
 	virtual void OnSemiWeaponRefire() override;
 
+	/** Broadcasts the cosmetic result of a server hitscan shot */
+	virtual void NotifyHitscanImpact(const FVector& TraceStart, const FVector& ImpactPoint, const FVector& ImpactNormal) override;
+
 	//~End IShooterWeaponHolder interface
 
 protected:
@@ -180,50 +270,70 @@ protected:
 	/** Called from the respawn timer to destroy this character and force the PC to respawn */
 	void OnRespawn();
 
+	/** Undoes the local death effects and drops the owned weapons */
+	void ResetForRespawn_Local();
+
+	/** Multicast RPC: notify all clients that this character has been recycled for a respawn */
+	UFUNCTION(NetMulticast, Reliable)
+	void Multicast_NotifyRespawn();
+	virtual void Multicast_NotifyRespawn_Implementation();
+
+	/** Called to allow Blueprint code to undo its death effects when this character is recycled for a respawn */
+	UFUNCTION(BlueprintImplementableEvent, Category="Shooter", meta = (DisplayName = "On Respawn"))
+	void BP_OnRespawn();
+
+	/** Builds the current input command and sends it with the previous ones if anything needs to go out. Owning client only */
+	void SendInputCommand();
+
+	/** Applies an input command received from the owning client, acting on what changed since the previous one. Server only */
+	void ApplyInputCommand(const FShooterInputCommand& Command, const FShooterInputCommand& PreviousCommand);
+
+	/** Starts or stops firing for the owning client. Server only */
+	void HandleFireInput(bool bStopFire, double ViewTime, uint16 ShotSequence);
+
 public:
-	UFUNCTION(Server, Reliable, WithValidation)
-	void Server_RequestWeaponFire(bool StopFire);
-	bool Server_RequestWeaponFire_Validate(bool StopFire);
-	void Server_RequestWeaponFire_Implementation(bool StopFire);
+	/** Server RPC: the owning client's newest input commands. Unreliable, every batch repeats the commands before it */
+	UFUNCTION(Server, Unreliable, WithValidation)
+	void Server_SendInputCommands(const FShooterInputCommandBatch& Batch);
+	bool Server_SendInputCommands_Validate(const FShooterInputCommandBatch& Batch);
+	void Server_SendInputCommands_Implementation(const FShooterInputCommandBatch& Batch);
+
+	/** Returns the input stream bandwidth counters */
+	const FShooterInputStreamStats& GetInputStreamStats() const { return InputStreamStats; }
+
 	void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
-	/** Client RPC: server tells owning client to update HUD (will broadcast OnBulletCountUpdated on client) */
+	/** Client RPC: server tells owning client its authoritative ammo after ShotSequence shots. The client reconciles its predicted ammo and broadcasts OnBulletCountUpdated. Reliable, the update sent when the trigger is released is the last one and nothing re-sends it */
 	UFUNCTION(Client, Reliable)
-	void Client_UpdateWeaponHUD(int32 CurrentAmmo, int32 MagazineSize);
+	void Client_UpdateWeaponHUD(int32 CurrentAmmo, int32 MagazineSize, uint16 ShotSequence);
 
-	/** Multicast RPC: notify all clients to change third-person anim instance when weapon activates */
-	UFUNCTION(NetMulticast, Reliable)
-	void Multicast_OnWeaponActivated_ChangeAnim(TSubclassOf<UAnimInstance> ThirdPersonAnimClass);
+	/** Multicast RPC: play hitscan tracer and impact effects for the current weapon on all machines */
+	UFUNCTION(NetMulticast, Unreliable)
+	void Multicast_OnHitscanImpact(FVector_NetQuantize TraceStart, FVector_NetQuantize ImpactPoint, FVector_NetQuantizeNormal ImpactNormal);
 
 public:
-	//  RPCɷ˵ãڴಥ
-	UFUNCTION(Server, Reliable, WithValidation)
-	void ServerNotifyPickUpWeapon(AShooterPickup* weaponPickUp);
-	bool ServerNotifyPickUpWeapon_Validate(AShooterPickup* weaponPickUp);
-	void ServerNotifyPickUpWeapon_Implementation(AShooterPickup* weaponPickUp);
-
-	// ಥ RPCɷ˹㲥пͻˣִ
-	UFUNCTION(NetMulticast, Reliable, WithValidation)
-	void MulticastPickUpWeapon(AShooterPickup* weaponPickUp);
-	bool MulticastPickUpWeapon_Validate(AShooterPickup* weaponPickUp);
-	void MulticastPickUpWeapon_Implementation(AShooterPickup* weaponPickUp);
 
 	void BindPawnBroadcast();
 
-	// лͻ ->  -> 㲥пͻ
-	UFUNCTION(Server, Reliable, WithValidation)
-	void ServerChangeIntoWeapon(int32 WeaponIndex);
-	bool ServerChangeIntoWeapon_Validate(int32 WeaponIndex);
-	void ServerChangeIntoWeapon_Implementation(int32 WeaponIndex);
+	/** Spawns the local weapon for a new inventory entry */
+	void OnWeaponEntryAdded(const FShooterWeaponInventoryEntry& Entry);
 
-	UFUNCTION(NetMulticast, Reliable)
-	void MulticastChangeIntoWeapon(int32 WeaponIndex);
-	void MulticastChangeIntoWeapon_Implementation(int32 WeaponIndex);
+	/** Refills the local weapon of an inventory entry */
+	void OnWeaponEntryChanged(const FShooterWeaponInventoryEntry& Entry);
+
+	/** Destroys the local weapon of a removed inventory entry */
+	void OnWeaponEntryRemoved(const FShooterWeaponInventoryEntry& Entry);
 
 	/** л߿Ϊͻ˻ˣ */
 	void ChangeIntoWeapon(int WeaponIndex);
 
 private:
-	/** жˣ+ͻˣִʵл߼ multicast ã */
+	/** жˣ+ͻˣִʵл߼ CurrentWeaponSlot  */
 	void DoChangeIntoWeapon(int32 WeaponIndex);
+
+	/** Server: equips the weapon in the slot and replicates the choice */
+	void SetCurrentWeaponSlot(uint8 Slot);
+
+	/** Server: drops every owned weapon */
+	void ClearWeapons();
 };
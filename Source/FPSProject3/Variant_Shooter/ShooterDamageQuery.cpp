@@ -0,0 +1,237 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Variant_Shooter/ShooterDamageQuery.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/World.h"
+#include "Variant_Shooter/ShooterStats.h"
+
+bool UShooterDamageQuery::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UShooterDamageQuery::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterDamageQuery, STATGROUP_Tickables);
+}
+
+void UShooterDamageQuery::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// refresh locations and move entries that crossed into another cell. Back to front so stale entries can be swap removed
+	for (int32 Index = Entries.Num() - 1; Index >= 0; --Index)
+	{
+		FShooterDamageQueryEntry& Entry = Entries[Index];
+
+		const AActor* Actor = Entry.Actor.Get();
+
+		if (!Actor)
+		{
+			RemoveEntryAt(Index);
+			continue;
+		}
+
+		Entry.Location = Actor->GetActorLocation();
+
+		const FIntPoint NewCell = GetCell(Entry.Location);
+
+		if (NewCell != Entry.Cell)
+		{
+			RemoveFromCell(Entry.Cell, Index);
+			AddToCell(NewCell, Index);
+			Entry.Cell = NewCell;
+		}
+	}
+}
+
+void UShooterDamageQuery::RegisterActor(AActor* Actor, UPrimitiveComponent* Component, float Radius)
+{
+	if (!IsValid(Actor) || IsActorRegistered(Actor))
+	{
+		return;
+	}
+
+	FShooterDamageQueryEntry& Entry = Entries.AddDefaulted_GetRef();
+	Entry.Actor = Actor;
+	Entry.Component = Component;
+	Entry.Location = Actor->GetActorLocation();
+	Entry.Radius = Radius;
+	Entry.Cell = GetCell(Entry.Location);
+
+	AddToCell(Entry.Cell, Entries.Num() - 1);
+}
+
+void UShooterDamageQuery::UnregisterActor(AActor* Actor)
+{
+	const int32 Index = Entries.IndexOfByPredicate([Actor](const FShooterDamageQueryEntry& Entry)
+	{
+		return Entry.Actor == Actor;
+	});
+
+	if (Index != INDEX_NONE)
+	{
+		RemoveEntryAt(Index);
+	}
+}
+
+bool UShooterDamageQuery::IsActorRegistered(const AActor* Actor) const
+{
+	return Entries.ContainsByPredicate([Actor](const FShooterDamageQueryEntry& Entry)
+	{
+		return Entry.Actor == Actor;
+	});
+}
+
+void UShooterDamageQuery::ForEachActorInRadius(const FVector& Center, float Radius, TFunctionRef<void(AActor*)> Visitor) const
+{
+	// only visit the cells the query circle can reach, padded by one cell for actors straddling a border
+	const FIntPoint MinCell = GetCell(Center - FVector(Radius, Radius, 0.0f)) - FIntPoint(1, 1);
+	const FIntPoint MaxCell = GetCell(Center + FVector(Radius, Radius, 0.0f)) + FIntPoint(1, 1);
+
+	for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+		{
+			const TArray<int32>* Cell = Cells.Find(FIntPoint(X, Y));
+
+			if (!Cell)
+			{
+				continue;
+			}
+
+			for (const int32 EntryIndex : *Cell)
+			{
+				const FShooterDamageQueryEntry& Entry = Entries[EntryIndex];
+
+				// every actor is filed under exactly one cell, so there are no duplicates to weed out
+				if (FVector::DistSquared(Center, Entry.Location) <= FMath::Square(Radius + Entry.Radius))
+				{
+					if (AActor* Actor = Entry.Actor.Get())
+					{
+						Visitor(Actor);
+					}
+				}
+			}
+		}
+	}
+}
+
+void UShooterDamageQuery::QueryRadius(const FVector& Center, float Radius, const FShooterRadialQueryParams& Params, TArray<FShooterRadialQueryResult>& OutResults) const
+{
+	OutResults.Reset();
+
+	const FIntPoint MinCell = GetCell(Center - FVector(Radius, Radius, 0.0f)) - FIntPoint(1, 1);
+	const FIntPoint MaxCell = GetCell(Center + FVector(Radius, Radius, 0.0f)) + FIntPoint(1, 1);
+
+	FCollisionQueryParams OcclusionParams(SCENE_QUERY_STAT(ShooterDamageOcclusion), false);
+
+	for (const AActor* IgnoredActor : Params.IgnoredActors)
+	{
+		OcclusionParams.AddIgnoredActor(IgnoredActor);
+	}
+
+	// gather, falloff and occlusion in a single pass over the candidate cells
+	for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+		{
+			const TArray<int32>* Cell = Cells.Find(FIntPoint(X, Y));
+
+			if (!Cell)
+			{
+				continue;
+			}
+
+			for (const int32 EntryIndex : *Cell)
+			{
+				const FShooterDamageQueryEntry& Entry = Entries[EntryIndex];
+
+				const float DistSquared = FVector::DistSquared(Center, Entry.Location);
+
+				if (DistSquared > FMath::Square(Radius + Entry.Radius))
+				{
+					continue;
+				}
+
+				AActor* Actor = Entry.Actor.Get();
+
+				if (!Actor || Params.IgnoredActors.Contains(Actor))
+				{
+					continue;
+				}
+
+				// skip actors behind cover
+				if (Params.bCheckOcclusion)
+				{
+					// hitting the actor itself means nothing is in the way
+					FHitResult OutHit;
+					INC_DWORD_STAT(STAT_ShooterTraces);
+
+					if (GetWorld()->LineTraceSingleByChannel(OutHit, Center, Entry.Location, Params.OcclusionChannel, OcclusionParams) && OutHit.GetActor() != Actor)
+					{
+						continue;
+					}
+				}
+
+				// measure the falloff from the actor's bounds, so anything touching the center takes full damage
+				const float EdgeDistance = FMath::Max(0.0f, FMath::Sqrt(DistSquared) - Entry.Radius);
+				const float DistanceAlpha = Radius > 0.0f ? FMath::Clamp(EdgeDistance / Radius, 0.0f, 1.0f) : 0.0f;
+
+				FShooterRadialQueryResult& Result = OutResults.AddDefaulted_GetRef();
+				Result.Actor = Actor;
+				Result.Component = Entry.Component.Get();
+				Result.Direction = (Entry.Location - Center).GetSafeNormal();
+				Result.DamageScale = Params.FalloffExponent > 0.0f ? FMath::Pow(1.0f - DistanceAlpha, Params.FalloffExponent) : 1.0f;
+			}
+		}
+	}
+}
+
+FIntPoint UShooterDamageQuery::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt32(Location.X / CellSize), FMath::FloorToInt32(Location.Y / CellSize));
+}
+
+void UShooterDamageQuery::AddToCell(const FIntPoint& Cell, int32 EntryIndex)
+{
+	Cells.FindOrAdd(Cell).Add(EntryIndex);
+}
+
+void UShooterDamageQuery::RemoveFromCell(const FIntPoint& Cell, int32 EntryIndex)
+{
+	if (TArray<int32>* CellEntries = Cells.Find(Cell))
+	{
+		CellEntries->RemoveSingleSwap(EntryIndex, EAllowShrinking::No);
+
+		// drop empty cells so the map stays proportional to the occupied area
+		if (CellEntries->Num() == 0)
+		{
+			Cells.Remove(Cell);
+		}
+	}
+}
+
+void UShooterDamageQuery::RemoveEntryAt(int32 EntryIndex)
+{
+	RemoveFromCell(Entries[EntryIndex].Cell, EntryIndex);
+
+	// the last entry is about to move into this slot, so update its cell
+	const int32 LastIndex = Entries.Num() - 1;
+
+	if (EntryIndex != LastIndex)
+	{
+		if (TArray<int32>* LastCell = Cells.Find(Entries[LastIndex].Cell))
+		{
+			const int32 Slot = LastCell->Find(LastIndex);
+
+			if (Slot != INDEX_NONE)
+			{
+				(*LastCell)[Slot] = EntryIndex;
+			}
+		}
+	}
+
+	Entries.RemoveAtSwap(EntryIndex, 1, EAllowShrinking::No);
+}
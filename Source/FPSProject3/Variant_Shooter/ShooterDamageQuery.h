@@ -0,0 +1,126 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterDamageQuery.generated.h"
+
+class UPrimitiveComponent;
+
+/**
+ *  A damageable actor tracked by the damage query grid
+ */
+struct FShooterDamageQueryEntry
+{
+	/** Tracked actor */
+	TWeakObjectPtr<AActor> Actor;
+
+	/** Component to push and report hits against */
+	TWeakObjectPtr<UPrimitiveComponent> Component;
+
+	/** Actor location as of the last grid update */
+	FVector Location = FVector::ZeroVector;
+
+	/** Bounding radius of the actor, added to query radii */
+	float Radius = 0.0f;
+
+	/** Grid cell the actor is filed under */
+	FIntPoint Cell = FIntPoint::ZeroValue;
+};
+
+/**
+ *  Options for a radial damage query
+ */
+struct FShooterRadialQueryParams
+{
+	/** Exponent of the damage falloff towards the edge of the radius. Zero applies full damage across the whole radius */
+	float FalloffExponent = 0.0f;
+
+	/** If true, actors blocked from the center on OcclusionChannel are skipped */
+	bool bCheckOcclusion = false;
+
+	/** Channel used for occlusion traces */
+	TEnumAsByte<ECollisionChannel> OcclusionChannel = ECC_Visibility;
+
+	/** Actors to leave out of the results */
+	TArray<const AActor*, TInlineAllocator<2>> IgnoredActors;
+};
+
+/**
+ *  An actor affected by a radial damage query
+ */
+struct FShooterRadialQueryResult
+{
+	/** Affected actor */
+	AActor* Actor = nullptr;
+
+	/** Component to push */
+	UPrimitiveComponent* Component = nullptr;
+
+	/** Direction from the query center to the actor */
+	FVector Direction = FVector::ZeroVector;
+
+	/** Damage multiplier from the falloff */
+	float DamageScale = 1.0f;
+};
+
+/**
+ *  Uniform grid of damageable characters for radius queries such as explosions
+ *  Characters register on the server and are re-filed as they move, so a query only
+ *  looks at the cells it overlaps instead of running a physics overlap per explosion
+ */
+UCLASS()
+class FPSPROJECT3_API UShooterDamageQuery : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	/** Tracked actors */
+	TArray<FShooterDamageQueryEntry> Entries;
+
+	/** Entry indices filed by grid cell */
+	TMap<FIntPoint, TArray<int32>> Cells;
+
+	/** Size of a grid cell. Around an explosion radius keeps queries to a handful of cells */
+	float CellSize = 1000.0f;
+
+public:
+
+	/** Only track actors in game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Re-files actors that moved to a different cell */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Returns the stat id for this tickable */
+	virtual TStatId GetStatId() const override;
+
+	/** Starts tracking a damageable actor. Server only */
+	void RegisterActor(AActor* Actor, UPrimitiveComponent* Component, float Radius);
+
+	/** Stops tracking an actor */
+	void UnregisterActor(AActor* Actor);
+
+	/** Finds every tracked actor within the radius. Each actor is returned once */
+	void QueryRadius(const FVector& Center, float Radius, const FShooterRadialQueryParams& Params, TArray<FShooterRadialQueryResult>& OutResults) const;
+
+	/** Calls the visitor for every tracked actor within the radius, without falloff or occlusion */
+	void ForEachActorInRadius(const FVector& Center, float Radius, TFunctionRef<void(AActor*)> Visitor) const;
+
+	/** Returns true if the actor is tracked by the grid */
+	bool IsActorRegistered(const AActor* Actor) const;
+
+protected:
+
+	/** Returns the cell containing the location */
+	FIntPoint GetCell(const FVector& Location) const;
+
+	/** Files the entry under the cell */
+	void AddToCell(const FIntPoint& Cell, int32 EntryIndex);
+
+	/** Removes the entry from the cell */
+	void RemoveFromCell(const FIntPoint& Cell, int32 EntryIndex);
+
+	/** Removes an entry by swapping the last one into its slot */
+	void RemoveEntryAt(int32 EntryIndex);
+};
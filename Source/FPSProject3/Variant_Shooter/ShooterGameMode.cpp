@@ -3,72 +3,240 @@
 
 #include "Variant_Shooter/ShooterGameMode.h"
 #include "ShooterUI.h"
-#include "Kismet/GameplayStatics.h"
 #include "Engine/World.h"
 #include "Variant_Shooter/ShooterCharacter.h"
 #include "GameFramework/PlayerStart.h"
 #include "GameFramework/PlayerState.h"
 #include "Variant_Shooter/ShooterPlayerController.h"
 #include "Variant_Shooter/ShooterGameState.h"
+#include "Variant_Shooter/ShooterLog.h"
+#include "Variant_Shooter/ShooterDamageQuery.h"
+#include "Variant_Shooter/AI/ShooterNPC.h"
+#include "Variant_Shooter/ShooterStats.h"
+#include "Engine/Level.h"
+#include "HAL/IConsoleManager.h"
+
+namespace ShooterGameMode
+{
+	static int32 RecyclePawns = 1;
+	static FAutoConsoleVariableRef CVarRecyclePawns(
+		TEXT("Shooter.RecyclePawns"),
+		RecyclePawns,
+		TEXT("If non-zero, respawns reset and re-possess the dead character instead of destroying it and spawning a new one"));
+}
+
+void AShooterGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	Super::InitGame(MapName, Options, ErrorMessage);
+
+	// index the spawn points before the listen server host is spawned during the map load,
+	// then keep the registry in sync with level streaming
+	for (ULevel* Level : GetWorld()->GetLevels())
+	{
+		RegisterPlayerStarts(Level);
+	}
+
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &AShooterGameMode::OnLevelAddedToWorld);
+	LevelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &AShooterGameMode::OnLevelRemovedFromWorld);
+}
 
 void AShooterGameMode::BeginPlay()
 {
 	Super::BeginPlay();
-    UE_LOG(LogGameMode, Warning, TEXT("AShooterGameMode::BeginPlay - GameMode loaded, Authority: %d"), HasAuthority());
+    UE_LOG(LogShooterGameMode, Log, TEXT("AShooterGameMode::BeginPlay - GameMode loaded, Authority: %d"), HasAuthority());
 	// UI will be created on each client's PlayerController BeginPlay.
 }
 
+void AShooterGameMode::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+	FWorldDelegates::LevelRemovedFromWorld.Remove(LevelRemovedHandle);
+
+	Super::EndPlay(EndPlayReason);
+}
+
 AActor* AShooterGameMode::ChoosePlayerStart(AController* PlayerController)
 {
-    if (!HasAuthority())
-    {
-        UE_LOG(LogGameMode, Warning, TEXT("ChoosePlayerStart - Client side, skip execution"));
-        return Super::ChoosePlayerStart_Implementation(PlayerController);
-    }
-
-    UE_LOG(LogTemp, Log, TEXT("Choose PlayerStart"));
-    if (!IsValid(PlayerController))
-    {
-        UE_LOG(LogGameMode, Warning, TEXT("ChoosePlayerStart - Player controller is invalid"));
-        return Super::ChoosePlayerStart_Implementation(PlayerController);
-    }
-
-    int32 PlayerId = PlayerController->PlayerState ? PlayerController->PlayerState->GetPlayerId() : -1;
-    UE_LOG(LogGameMode, Log, TEXT("ChoosePlayerStart - Server execute, Player ID: %d"), PlayerId);
-
-    TArray<AActor*> PlayerStarts;
-    UGameplayStatics::GetAllActorsOfClass(GetWorld(), APlayerStart::StaticClass(), PlayerStarts);
-
-    if (PlayerStarts.Num() == 0)
-    {
-        UE_LOG(LogGameMode, Warning, TEXT("ChoosePlayerStart - No PlayerStart found, use super logic"));
-        return Super::ChoosePlayerStart_Implementation(PlayerController);
-    }
-
-    if (PlayerId == 0)
-    {
-        UE_LOG(LogGameMode, Log, TEXT("ChoosePlayerStart - Assign PlayerStartA to Player %d"), PlayerId);
-        for (AActor* Start : PlayerStarts)
-        {
-            if (IsValid(Start) && Start->ActorHasTag(FName("PlayerStartA")))
-            {
-                return Start;
-            }
-        }
-    }
-    else if (PlayerId == 1)
-    {
-        UE_LOG(LogGameMode, Log, TEXT("ChoosePlayerStart - Assign PlayerStartB to Player %d"), PlayerId);
-        for (AActor* Start : PlayerStarts)
-        {
-            if (IsValid(Start) && Start->ActorHasTag(FName("PlayerStartB")))
-            {
-                return Start;
-            }
-        }
-    }
-
-    return PlayerStarts[0];
+	if (!HasAuthority())
+	{
+		UE_LOG(LogShooterGameMode, Verbose, TEXT("ChoosePlayerStart - Client side, skip execution"));
+		return Super::ChoosePlayerStart_Implementation(PlayerController);
+	}
+
+	if (!IsValid(PlayerController))
+	{
+		UE_LOG(LogShooterGameMode, Warning, TEXT("ChoosePlayerStart - Player controller is invalid"));
+		return Super::ChoosePlayerStart_Implementation(PlayerController);
+	}
+
+	const int32 Team = GetControllerTeam(PlayerController);
+
+	// prefer the team's own starts, then fall back to the untagged ones
+	APlayerStart* PlayerStart = TeamPlayerStarts.IsValidIndex(Team) ? ChooseSafestPlayerStart(TeamPlayerStarts[Team], Team) : nullptr;
+
+	if (!PlayerStart)
+	{
+		PlayerStart = ChooseSafestPlayerStart(SharedPlayerStarts, Team);
+	}
+
+	if (!PlayerStart)
+	{
+		UE_LOG(LogShooterGameMode, Warning, TEXT("ChoosePlayerStart - No PlayerStart registered for team %d, use super logic"), Team);
+		return Super::ChoosePlayerStart_Implementation(PlayerController);
+	}
+
+	UE_LOG(LogShooterGameMode, Verbose, TEXT("ChoosePlayerStart - Assign %s to team %d"), *PlayerStart->GetName(), Team);
+
+	return PlayerStart;
+}
+
+void AShooterGameMode::RegisterPlayerStarts(ULevel* Level)
+{
+	if (!Level)
+	{
+		return;
+	}
+
+	for (AActor* Actor : Level->Actors)
+	{
+		APlayerStart* PlayerStart = Cast<APlayerStart>(Actor);
+
+		if (!IsValid(PlayerStart))
+		{
+			continue;
+		}
+
+		const int32 Team = TeamStartTags.IndexOfByPredicate([PlayerStart](const FName& Tag) { return PlayerStart->ActorHasTag(Tag); });
+
+		if (Team == INDEX_NONE)
+		{
+			SharedPlayerStarts.AddUnique(PlayerStart);
+			continue;
+		}
+
+		if (!TeamPlayerStarts.IsValidIndex(Team))
+		{
+			TeamPlayerStarts.SetNum(Team + 1);
+		}
+
+		TeamPlayerStarts[Team].AddUnique(PlayerStart);
+	}
+}
+
+void AShooterGameMode::UnregisterPlayerStarts(ULevel* Level)
+{
+	auto IsInLevel = [Level](const TWeakObjectPtr<APlayerStart>& PlayerStart)
+	{
+		return !PlayerStart.IsValid() || PlayerStart->GetLevel() == Level;
+	};
+
+	for (TArray<TWeakObjectPtr<APlayerStart>>& PlayerStarts : TeamPlayerStarts)
+	{
+		PlayerStarts.RemoveAllSwap(IsInLevel);
+	}
+
+	SharedPlayerStarts.RemoveAllSwap(IsInLevel);
+}
+
+void AShooterGameMode::OnLevelAddedToWorld(ULevel* Level, UWorld* World)
+{
+	if (World == GetWorld())
+	{
+		RegisterPlayerStarts(Level);
+	}
+}
+
+void AShooterGameMode::OnLevelRemovedFromWorld(ULevel* Level, UWorld* World)
+{
+	// a null level means the whole world is going away
+	if (World == GetWorld() && Level)
+	{
+		UnregisterPlayerStarts(Level);
+	}
+}
+
+APlayerStart* AShooterGameMode::ChooseSafestPlayerStart(const TArray<TWeakObjectPtr<APlayerStart>>& Candidates, int32 Team) const
+{
+	const UShooterDamageQuery* DamageQuery = GetWorld()->GetSubsystem<UShooterDamageQuery>();
+
+	APlayerStart* BestStart = nullptr;
+	float BestDistanceSquared = -1.0f;
+	int32 NumTied = 0;
+
+	for (const TWeakObjectPtr<APlayerStart>& Candidate : Candidates)
+	{
+		APlayerStart* PlayerStart = Candidate.Get();
+
+		if (!PlayerStart)
+		{
+			continue;
+		}
+
+		const FVector StartLocation = PlayerStart->GetActorLocation();
+
+		// starts with no enemy in range all score the full radius
+		float NearestEnemyDistanceSquared = FMath::Square(SpawnEnemySearchRadius);
+
+		if (DamageQuery)
+		{
+			DamageQuery->ForEachActorInRadius(StartLocation, SpawnEnemySearchRadius, [&](AActor* Actor)
+			{
+				const int32 ActorTeam = GetActorTeam(Actor);
+
+				if (ActorTeam != INDEX_NONE && ActorTeam != Team)
+				{
+					NearestEnemyDistanceSquared = FMath::Min(NearestEnemyDistanceSquared, static_cast<float>(FVector::DistSquared(StartLocation, Actor->GetActorLocation())));
+				}
+			});
+		}
+
+		if (NearestEnemyDistanceSquared > BestDistanceSquared)
+		{
+			BestStart = PlayerStart;
+			BestDistanceSquared = NearestEnemyDistanceSquared;
+			NumTied = 1;
+
+		} else if (NearestEnemyDistanceSquared == BestDistanceSquared) {
+
+			// pick evenly between equally safe starts so players don't stack on one spot
+			++NumTied;
+
+			if (FMath::RandRange(1, NumTied) == 1)
+			{
+				BestStart = PlayerStart;
+			}
+		}
+	}
+
+	return BestStart;
+}
+
+int32 AShooterGameMode::GetControllerTeam(const AController* Controller)
+{
+	if (const AShooterPlayerController* ShooterPC = Cast<AShooterPlayerController>(Controller))
+	{
+		return ShooterPC->PlayerTeamByte;
+	}
+
+	if (const AShooterNPC* NPC = Controller ? Cast<AShooterNPC>(Controller->GetPawn()) : nullptr)
+	{
+		return NPC->GetTeamByte();
+	}
+
+	return INDEX_NONE;
+}
+
+int32 AShooterGameMode::GetActorTeam(const AActor* Actor)
+{
+	if (const AShooterNPC* NPC = Cast<AShooterNPC>(Actor))
+	{
+		return NPC->GetTeamByte();
+	}
+
+	// read the controller directly, dead characters have already been unpossessed
+	const APawn* Pawn = Cast<APawn>(Actor);
+
+	return Pawn ? GetControllerTeam(Pawn->GetController()) : INDEX_NONE;
 }
 
 void AShooterGameMode::IncrementTeamScore(uint8 TeamByte)
@@ -76,11 +244,11 @@ void AShooterGameMode::IncrementTeamScore(uint8 TeamByte)
 	// Delegate the score change to GameState (replicated)
 	if (AShooterGameState* GS = GetGameState<AShooterGameState>())
 	{
-		UE_LOG(LogTemp, Log, TEXT("IncrementTeamScore called for Team %d"), TeamByte);
+		UE_LOG(LogShooterGameMode, Log, TEXT("IncrementTeamScore called for Team %d"), TeamByte);
 		GS->AddTeamScore(TeamByte);
 	}
 	else {
-		UE_LOG(LogTemp, Error, TEXT("IncrementTeamScore - Failed to get ShooterGameState"));
+		UE_LOG(LogShooterGameMode, Error, TEXT("IncrementTeamScore - Failed to get ShooterGameState"));
 	}
 }
 
@@ -91,26 +259,21 @@ void AShooterGameMode::ScheduleRespawn(AController* Controller, float Delay)
 	FTimerHandle& Handle = RespawnTimerHandles.FindOrAdd(Controller);
 	FTimerDelegate Delegate = FTimerDelegate::CreateUObject(this, &AShooterGameMode::RespawnController, Controller);
 	GetWorld()->GetTimerManager().SetTimer(Handle, Delegate, Delay, false);
-	UE_LOG(LogTemp, Log, TEXT("Scheduled respawn for controller %s in %f seconds"), *Controller->GetName(), Delay);
+	UE_LOG(LogShooterGameMode, Log, TEXT("Scheduled respawn for controller %s in %f seconds"), *Controller->GetName(), Delay);
 }
 
 void AShooterGameMode::RespawnController(AController* Controller)
 {
 	if (!HasAuthority() || !IsValid(Controller)) return;
 
-	UE_LOG(LogTemp, Log, TEXT("Respawning controller %s"), *Controller->GetName());
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_ShooterRespawn);
+
+	const uint64 RespawnStartCycles = FPlatformTime::Cycles64();
+
+	UE_LOG(LogShooterGameMode, Log, TEXT("Respawning controller %s"), *Controller->GetName());
 	// Clear handle
 	RespawnTimerHandles.Remove(Controller);
 
-	// If controller still possesses a dead pawn, destroy it now (just-before-respawn)
-	if (APawn* OldPawn = Controller->GetPawn())
-	{
-		UE_LOG(LogTemp, Log, TEXT("RespawnController: Removing old pawn %s before respawn"), *OldPawn->GetName());
-		// Ensure controller is unpossessed before destroying pawn
-		Controller->UnPossess();
-		OldPawn->Destroy();
-	}
-
 	// Determine spawn transform (use ChoosePlayerStart)
 	AActor* StartSpot = ChoosePlayerStart(Controller);
 	FTransform SpawnTransform = StartSpot ? StartSpot->GetActorTransform() : FTransform::Identity;
@@ -132,9 +295,31 @@ void AShooterGameMode::RespawnController(AController* Controller)
 		}
 	}
 
+	// reuse the dead pawn if it's of the right class, instead of building a new one with all of its components
+	AShooterCharacter* OldCharacter = Cast<AShooterCharacter>(Controller->GetPawn());
+
+	if (ShooterGameMode::RecyclePawns && OldCharacter && OldCharacter->IsDead() && OldCharacter->GetClass() == CharClass)
+	{
+		Controller->UnPossess();
+		OldCharacter->ResetForRespawn(SpawnTransform);
+		Controller->Possess(OldCharacter);
+
+		OnControllerRespawned(Controller, OldCharacter, RespawnStartCycles);
+		return;
+	}
+
+	// If controller still possesses a dead pawn, destroy it now (just-before-respawn)
+	if (APawn* OldPawn = Controller->GetPawn())
+	{
+		UE_LOG(LogShooterGameMode, Verbose, TEXT("RespawnController: Removing old pawn %s before respawn"), *OldPawn->GetName());
+		// Ensure controller is unpossessed before destroying pawn
+		Controller->UnPossess();
+		OldPawn->Destroy();
+	}
+
 	if (!CharClass)
 	{
-		UE_LOG(LogTemp, Error, TEXT("RespawnController: No Character class available to spawn"));
+		UE_LOG(LogShooterGameMode, Error, TEXT("RespawnController: No Character class available to spawn"));
 		return;
 	}
 
@@ -146,21 +331,28 @@ void AShooterGameMode::RespawnController(AController* Controller)
 	AShooterCharacter* NewPawn = GetWorld()->SpawnActor<AShooterCharacter>(CharClass, SpawnTransform, SpawnParams);
 	if (!NewPawn)
 	{
-		UE_LOG(LogTemp, Error, TEXT("RespawnController: Failed to spawn pawn for controller %s"), *Controller->GetName());
+		UE_LOG(LogShooterGameMode, Error, TEXT("RespawnController: Failed to spawn pawn for controller %s"), *Controller->GetName());
 		return;
 	}
 
 	// Possess the pawn with the controller
 	Controller->Possess(NewPawn);
 
+	OnControllerRespawned(Controller, NewPawn, RespawnStartCycles);
+}
+
+void AShooterGameMode::OnControllerRespawned(AController* Controller, AShooterCharacter* Pawn, uint64 RespawnStartCycles)
+{
 	// Make sure pawn binds its delegates to the local Controller
-	NewPawn->BindPawnBroadcast();
+	Pawn->BindPawnBroadcast();
 
 	// Notify the owning client that respawn occurred (client-side effects / UI)
-	if (ShooterPC)
+	if (AShooterPlayerController* ShooterPC = Cast<AShooterPlayerController>(Controller))
 	{
 		ShooterPC->Client_OnRespawned();
 	}
 
-	UE_LOG(LogTemp, Log, TEXT("RespawnController: Respawned controller %s with pawn %s"), *Controller->GetName(), *NewPawn->GetName());
-}
\ No newline at end of file
+	ShooterCost::Respawns.Record(FPlatformTime::Cycles64() - RespawnStartCycles);
+
+	UE_LOG(LogShooterGameMode, Log, TEXT("RespawnController: Respawned controller %s with pawn %s"), *Controller->GetName(), *Pawn->GetName());
+}
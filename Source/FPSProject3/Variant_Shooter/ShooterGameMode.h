@@ -7,6 +7,9 @@
 #include "ShooterGameMode.generated.h"
 
 class UShooterUI;
+class AShooterCharacter;
+class APlayerStart;
+class ULevel;
 
 /**
  *  Simple GameMode for a first person shooter game
@@ -23,11 +26,35 @@ protected:
 	/** Respawn timer handles keyed by controller */
 	TMap<TWeakObjectPtr<AController>, FTimerHandle> RespawnTimerHandles;
 
+	/** Player start tag for each team, indexed by team byte */
+	UPROPERTY(EditDefaultsOnly, Category="Spawning")
+	TArray<FName> TeamStartTags = { FName("PlayerStartA"), FName("PlayerStartB") };
+
+	/** Radius around a player start searched for enemies when scoring it */
+	UPROPERTY(EditDefaultsOnly, Category="Spawning", meta = (ClampMin = 0, ClampMax = 100000, Units = "cm"))
+	float SpawnEnemySearchRadius = 5000.0f;
+
+	/** Registered player starts, indexed by team byte */
+	TArray<TArray<TWeakObjectPtr<APlayerStart>>> TeamPlayerStarts;
+
+	/** Registered player starts without a team tag. Used by teams that have none of their own */
+	TArray<TWeakObjectPtr<APlayerStart>> SharedPlayerStarts;
+
+	/** Streaming delegate handles */
+	FDelegateHandle LevelAddedHandle;
+	FDelegateHandle LevelRemovedHandle;
+
 protected:
 
+	/** Indexes the player starts before any player is spawned */
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+
 	/** Gameplay initialization */
 	virtual void BeginPlay() override;
 
+	/** Gameplay cleanup */
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 public:
 
 	/** Increases the score for the given team */
@@ -44,4 +71,26 @@ public:
 protected:
 	/** Called by timer to actually respawn controller's pawn */
 	void RespawnController(AController* Controller);
+
+	/** Finishes a respawn once the controller possesses its pawn */
+	void OnControllerRespawned(AController* Controller, AShooterCharacter* Pawn, uint64 RespawnStartCycles);
+
+	/** Adds every player start in the level to the registry */
+	void RegisterPlayerStarts(ULevel* Level);
+
+	/** Removes the level's player starts from the registry */
+	void UnregisterPlayerStarts(ULevel* Level);
+
+	/** Streaming callbacks */
+	void OnLevelAddedToWorld(ULevel* Level, UWorld* World);
+	void OnLevelRemovedFromWorld(ULevel* Level, UWorld* World);
+
+	/** Returns the start farthest from the team's enemies, or nullptr if there is none to choose from */
+	APlayerStart* ChooseSafestPlayerStart(const TArray<TWeakObjectPtr<APlayerStart>>& Candidates, int32 Team) const;
+
+	/** Returns the team of a controller, or INDEX_NONE if it has none */
+	static int32 GetControllerTeam(const AController* Controller);
+
+	/** Returns the team of a tracked character, or INDEX_NONE if it has none */
+	static int32 GetActorTeam(const AActor* Actor);
 };
@@ -2,11 +2,14 @@
 
 #include "Variant_Shooter/ShooterGameState.h"
 #include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
 #include "Engine/World.h"
 #include "GameFramework/PlayerController.h"
 #include "Variant_Shooter/ShooterPlayerController.h"
 #include "Variant_Shooter/ShooterGameMode.h"
 #include "Engine/Engine.h"
+#include "Variant_Shooter/ShooterLog.h"
+#include "Variant_Shooter/Weapons/ShooterPickupManager.h"
 
 AShooterGameState::AShooterGameState()
 {
@@ -22,14 +25,15 @@ void AShooterGameState::AddTeamScore(uint8 TeamByte)
 
 	if (TeamByte >= static_cast<uint8>(TeamScores.Num()))
 	{
-		UE_LOG(LogTemp, Warning, TEXT("AddTeamScore: TeamByte %d out of range (max %d)"), TeamByte, TeamScores.Num());
+		UE_LOG(LogShooterGameMode, Warning, TEXT("AddTeamScore: TeamByte %d out of range (max %d)"), TeamByte, TeamScores.Num());
 		return;
 	}
 
 	int32& ScoreRef = TeamScores[TeamByte];
 	++ScoreRef;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShooterGameState, TeamScores, this);
 
-	UE_LOG(LogTemp, Log, TEXT("Team %d scored. New score: %d"), TeamByte, ScoreRef);
+	UE_LOG(LogShooterGameMode, Log, TEXT("Team %d scored. New score: %d"), TeamByte, ScoreRef);
 
 	// If we've reached the winning score, notify game over
 	if (ScoreRef >= WinningScore)
@@ -48,6 +52,34 @@ void AShooterGameState::OnRep_TeamScores()
 	NotifyLocalPlayerControllers();
 }
 
+void AShooterGameState::SetPickupAvailable(uint32 PickupId, bool bAvailable)
+{
+	if (!HasAuthority()) return;
+
+	// only the few pickups waiting to respawn are listed, so the array stays small
+	if (bAvailable)
+	{
+		if (UnavailablePickups.RemoveSwap(PickupId) == 0) return;
+
+	} else {
+
+		if (UnavailablePickups.Contains(PickupId)) return;
+
+		UnavailablePickups.Add(PickupId);
+	}
+
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShooterGameState, UnavailablePickups, this);
+}
+
+void AShooterGameState::OnRep_PickupAvailability()
+{
+	// the pickup manager works out which pickups flipped
+	if (UShooterPickupManager* PickupManager = GetWorld()->GetSubsystem<UShooterPickupManager>())
+	{
+		PickupManager->OnPickupAvailabilityReplicated(this);
+	}
+}
+
 void AShooterGameState::NotifyLocalPlayerControllers()
 {
 	// Iterate player controllers available on this machine and tell them to update UI.
@@ -65,7 +97,7 @@ void AShooterGameState::NotifyLocalPlayerControllers()
 
 void AShooterGameState::NotifyGameOver(uint8 WinningTeam)
 {
-	UE_LOG(LogTemp, Log, TEXT("Game Over! Winning Team: %d"), WinningTeam);
+	UE_LOG(LogShooterGameMode, Log, TEXT("Game Over! Winning Team: %d"), WinningTeam);
 	IsGameOverNotified = true;
 	// Runs on server only: notify all PlayerControllers via client RPC (clients will run UI logic).
 	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
@@ -88,7 +120,11 @@ void AShooterGameState::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& Ou
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(AShooterGameState, TeamScores);
+	FDoRepLifetimeParams SharedParams;
+	SharedParams.bIsPushBased = true;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShooterGameState, TeamScores, SharedParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShooterGameState, UnavailablePickups, SharedParams);
 }
 
 
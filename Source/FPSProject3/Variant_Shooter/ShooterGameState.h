@@ -34,6 +34,14 @@ protected:
 	UFUNCTION()
 	void OnRep_TeamScores();
 
+	/** Stable ids of the pickups that have been taken and are waiting to respawn. Every other pickup is available */
+	UPROPERTY(ReplicatedUsing = OnRep_PickupAvailability)
+	TArray<uint32> UnavailablePickups;
+
+	/** Called on clients when UnavailablePickups is updated */
+	UFUNCTION()
+	void OnRep_PickupAvailability();
+
 	/** Helper to notify local player controller UI on clients */
 	void NotifyLocalPlayerControllers();
 
@@ -49,5 +57,17 @@ public:
 	UFUNCTION(BlueprintCallable)
 	virtual bool GetIsGameOverNotified() const { return IsGameOverNotified; }
 
+	/** Returns the score of a team, or zero for a team out of range */
+	int32 GetTeamScore(uint8 TeamByte) const { return TeamScores.IsValidIndex(TeamByte) ? TeamScores[TeamByte] : 0; }
+
 	int RegisteredServerControllersCount;
+
+	/** Server: sets the availability of the pickup with the stable id */
+	void SetPickupAvailable(uint32 PickupId, bool bAvailable);
+
+	/** Returns the replicated availability of the pickup with the stable id */
+	bool IsPickupAvailable(uint32 PickupId) const { return !UnavailablePickups.Contains(PickupId); }
+
+	/** Returns the stable ids of the pickups waiting to respawn */
+	const TArray<uint32>& GetUnavailablePickups() const { return UnavailablePickups; }
 };
@@ -0,0 +1,109 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Variant_Shooter/ShooterInputCommand.h"
+
+void FShooterInputCommand::SetAimRotation(const FRotator& AimRotation)
+{
+	AimPitch = FRotator::CompressAxisToShort(AimRotation.Pitch);
+	AimYaw = FRotator::CompressAxisToShort(AimRotation.Yaw);
+}
+
+FRotator FShooterInputCommand::GetAimRotation() const
+{
+	return FRotator(FRotator::DecompressAxisFromShort(AimPitch), FRotator::DecompressAxisFromShort(AimYaw), 0.0f);
+}
+
+void FShooterInputCommand::SetViewTime(double ViewTime)
+{
+	ViewTimeMs = static_cast<uint16>(static_cast<uint64>(FMath::Max(0.0, ViewTime) * 1000.0) & 0xFFFF);
+}
+
+double FShooterInputCommand::GetViewTime(double ServerTime) const
+{
+	// the signed difference to the server's wrapped clock covers +-32 seconds, plenty for any playable latency
+	const uint16 ServerTimeMs = static_cast<uint16>(static_cast<uint64>(ServerTime * 1000.0) & 0xFFFF);
+	const int16 BehindMs = static_cast<int16>(ServerTimeMs - ViewTimeMs);
+
+	return ServerTime - (BehindMs / 1000.0);
+}
+
+bool FShooterInputCommand::HasInputChanged(const FShooterInputCommand& Other) const
+{
+	return Buttons != Other.Buttons || WeaponIndex != Other.WeaponIndex || WeaponSwitchCount != Other.WeaponSwitchCount;
+}
+
+void FShooterInputCommand::SerializeBody(FArchive& Ar)
+{
+	Ar.SerializeBits(&Buttons, NumButtonBits);
+	Ar.SerializeBits(&WeaponIndex, NumWeaponIndexBits);
+	Ar.SerializeBits(&WeaponSwitchCount, NumWeaponSwitchBits);
+	Ar << AimPitch;
+	Ar << AimYaw;
+	Ar << ViewTimeMs;
+	Ar << ShotSequence;
+}
+
+int32 FShooterInputCommand::GetNumBodyBits() const
+{
+	return NumButtonBits + NumWeaponIndexBits + NumWeaponSwitchBits + 64;
+}
+
+int32 FShooterInputCommandBatch::GetNumBits() const
+{
+	int32 NumBits = 2 + 16;
+
+	for (const FShooterInputCommand& Command : Commands)
+	{
+		NumBits += Command.GetNumBodyBits();
+	}
+
+	return NumBits;
+}
+
+bool FShooterInputCommandBatch::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	// command count, stored as count - 1 in 2 bits
+	uint8 NumCommandsMinusOne = Ar.IsSaving() ? static_cast<uint8>(FMath::Clamp(Commands.Num(), 1, MaxCommands) - 1) : 0;
+	Ar.SerializeBits(&NumCommandsMinusOne, 2);
+
+	// newest sequence. The rest count down from it
+	uint16 NewestSequence = Commands.Num() > 0 ? Commands[0].Sequence : 0;
+	Ar << NewestSequence;
+
+	if (Ar.IsLoading())
+	{
+		Commands.SetNum(NumCommandsMinusOne + 1);
+	}
+
+	for (int32 Index = 0; Index <= NumCommandsMinusOne && Index < Commands.Num(); ++Index)
+	{
+		Commands[Index].Sequence = static_cast<uint16>(NewestSequence - Index);
+		Commands[Index].SerializeBody(Ar);
+	}
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
+
+void FShooterInputStreamStats::Record(double Now, int32 NumBits, int32 NumNewCommands)
+{
+	WindowBits += NumBits;
+	WindowCommands += NumNewCommands;
+	++WindowBatches;
+
+	const double Elapsed = Now - WindowStart;
+
+	// roll the window over about once a second
+	if (Elapsed >= 1.0)
+	{
+		BytesPerSecond = static_cast<float>((WindowBits / 8.0) / Elapsed);
+		CommandsPerSecond = static_cast<float>(WindowCommands / Elapsed);
+		BatchesPerSecond = static_cast<float>(WindowBatches / Elapsed);
+
+		WindowStart = Now;
+		WindowBits = 0;
+		WindowCommands = 0;
+		WindowBatches = 0;
+	}
+}
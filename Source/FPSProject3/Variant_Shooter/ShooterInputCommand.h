@@ -0,0 +1,135 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ShooterInputCommand.generated.h"
+
+/**
+ *  One frame of shooter input from the owning client, quantized for the wire
+ *  Carries the trigger state, weapon selection and aim. Sent unreliably, so every field is absolute state rather than a delta
+ */
+struct FShooterInputCommand
+{
+	/** Button bit for the fire trigger */
+	static constexpr uint8 ButtonFire = 1 << 0;
+
+	/** Number of bits used for the button field */
+	static constexpr int32 NumButtonBits = 2;
+
+	/** Number of bits used for the weapon index. Limits the inventory to 16 weapons */
+	static constexpr int32 NumWeaponIndexBits = 4;
+
+	/** Number of bits used for the weapon switch counter */
+	static constexpr int32 NumWeaponSwitchBits = 3;
+
+	/** Command number. Increases by one for every command the client sends */
+	uint16 Sequence = 0;
+
+	/** Bitfield of held buttons */
+	uint8 Buttons = 0;
+
+	/** Index of the weapon the client last asked to equip */
+	uint8 WeaponIndex = 0;
+
+	/** Incremented by the client for every weapon switch request, so the server only switches on a new request */
+	uint8 WeaponSwitchCount = 0;
+
+	/** Aim pitch compressed to 16 bits */
+	uint16 AimPitch = 0;
+
+	/** Aim yaw compressed to 16 bits */
+	uint16 AimYaw = 0;
+
+	/** Server time of the world state the client was viewing, in milliseconds, wrapped to 16 bits */
+	uint16 ViewTimeMs = 0;
+
+	/** Shot count of the client's weapon when the trigger state last changed */
+	uint16 ShotSequence = 0;
+
+	/** Returns true if the fire trigger is held */
+	bool IsFiring() const { return (Buttons & ButtonFire) != 0; }
+
+	/** Sets the aim, quantizing it to 16 bits per axis */
+	void SetAimRotation(const FRotator& AimRotation);
+
+	/** Returns the dequantized aim */
+	FRotator GetAimRotation() const;
+
+	/** Stores the server time of the world state the client is viewing */
+	void SetViewTime(double ViewTime);
+
+	/** Unwraps the client's view time against the server's own clock */
+	double GetViewTime(double ServerTime) const;
+
+	/** Returns true if the input state differs from another command, ignoring aim and timing */
+	bool HasInputChanged(const FShooterInputCommand& Other) const;
+
+	/** Serializes the command body. The sequence is written by the batch */
+	void SerializeBody(FArchive& Ar);
+
+	/** Returns the number of bits SerializeBody writes */
+	int32 GetNumBodyBits() const;
+};
+
+/**
+ *  A batch of the newest input commands, sent every packet so a dropped packet's commands arrive with the next one
+ */
+USTRUCT()
+struct FShooterInputCommandBatch
+{
+	GENERATED_BODY()
+
+	/** Max number of commands in one batch */
+	static constexpr int32 MaxCommands = 4;
+
+	/** Newest command first, followed by the ones sent before it. Sequences are consecutive */
+	TArray<FShooterInputCommand, TInlineAllocator<MaxCommands>> Commands;
+
+	/** Size of this batch on the wire */
+	int32 GetNumBits() const;
+
+	/** Custom net serialization. Only the newest sequence is written, the rest are implied */
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FShooterInputCommandBatch> : public TStructOpsTypeTraitsBase2<FShooterInputCommandBatch>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
+
+/**
+ *  Per second byte and command counters for one end of an input command stream
+ */
+struct FShooterInputStreamStats
+{
+	/** Bytes per second over the last full window */
+	float BytesPerSecond = 0.0f;
+
+	/** Commands per second over the last full window */
+	float CommandsPerSecond = 0.0f;
+
+	/** Batches per second over the last full window */
+	float BatchesPerSecond = 0.0f;
+
+	/** Records a batch and rolls the window over every second */
+	void Record(double Now, int32 NumBits, int32 NumNewCommands);
+
+private:
+
+	/** Time the current window started */
+	double WindowStart = 0.0;
+
+	/** Bits recorded in the current window */
+	int64 WindowBits = 0;
+
+	/** Commands recorded in the current window */
+	int32 WindowCommands = 0;
+
+	/** Batches recorded in the current window */
+	int32 WindowBatches = 0;
+};
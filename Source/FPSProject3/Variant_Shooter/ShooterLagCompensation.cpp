@@ -0,0 +1,253 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Variant_Shooter/ShooterLagCompensation.h"
+#include "GameFramework/Character.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Variant_Shooter/ShooterStats.h"
+
+namespace ShooterLagCompensation
+{
+	/** Number of poses kept per character. About a second of history at a 60Hz server tick */
+	static constexpr int32 HistorySize = 64;
+
+	static int32 Enabled = 1;
+	static FAutoConsoleVariableRef CVarEnabled(
+		TEXT("Shooter.LagCompensation.Enabled"),
+		Enabled,
+		TEXT("If non-zero, server hit validation rewinds characters to the time the shooter fired at"));
+
+	static float MaxRewindTime = 0.4f;
+	static FAutoConsoleVariableRef CVarMaxRewindTime(
+		TEXT("Shooter.LagCompensation.MaxRewindTime"),
+		MaxRewindTime,
+		TEXT("Max time in seconds a shot can be rewound, regardless of the shooter's latency"));
+}
+
+bool UShooterLagCompensation::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UShooterLagCompensation::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterLagCompensation, STATGROUP_Tickables);
+}
+
+void UShooterLagCompensation::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	// record the pose of every character. Back to front so stale entries can be swap removed
+	for (int32 Index = Histories.Num() - 1; Index >= 0; --Index)
+	{
+		FShooterPoseHistory& History = Histories[Index];
+
+		const ACharacter* Character = History.Character.Get();
+
+		if (!Character)
+		{
+			Histories.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+			continue;
+		}
+
+		const UCapsuleComponent* Capsule = Character->GetCapsuleComponent();
+
+		// overwrite the oldest sample in place, no allocations after registration
+		FShooterPoseSample& Sample = History.Samples[History.Head];
+		Sample.Time = Now;
+		Sample.Location = Capsule->GetComponentLocation();
+		Sample.Radius = Capsule->GetScaledCapsuleRadius();
+		Sample.HalfHeight = Capsule->GetScaledCapsuleHalfHeight();
+
+		History.Head = (History.Head + 1) % History.Samples.Num();
+		History.Count = FMath::Min(History.Count + 1, History.Samples.Num());
+	}
+}
+
+void UShooterLagCompensation::RegisterCharacter(ACharacter* Character)
+{
+	if (!IsValid(Character) || FindHistory(Character))
+	{
+		return;
+	}
+
+	// size the ring buffer once up front
+	FShooterPoseHistory& History = Histories.AddDefaulted_GetRef();
+	History.Character = Character;
+	History.Samples.SetNumZeroed(ShooterLagCompensation::HistorySize);
+}
+
+void UShooterLagCompensation::UnregisterCharacter(ACharacter* Character)
+{
+	Histories.RemoveAllSwap([Character](const FShooterPoseHistory& History)
+	{
+		return History.Character == Character;
+	});
+}
+
+void UShooterLagCompensation::SetShooterTimestamp(const ACharacter* Shooter, double ViewTime)
+{
+	if (FShooterPoseHistory* History = const_cast<FShooterPoseHistory*>(FindHistory(Shooter)))
+	{
+		// the difference to the server's clock is how stale the shooter's view of the world was, latency and interpolation included
+		History->RewindTime = FMath::Clamp(GetWorld()->GetTimeSeconds() - ViewTime, 0.0, static_cast<double>(ShooterLagCompensation::MaxRewindTime));
+	}
+}
+
+bool UShooterLagCompensation::LineTraceRewound(FHitResult& OutHit, const FVector& Start, const FVector& End, ECollisionChannel TraceChannel, const FCollisionQueryParams& QueryParams, const AActor* Shooter) const
+{
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_ShooterLagCompensatedTrace);
+	INC_DWORD_STAT(STAT_ShooterTraces);
+
+	UWorld* World = GetWorld();
+
+	const FShooterPoseHistory* ShooterHistory = FindHistory(Shooter);
+	const double RewindTime = ShooterHistory ? ShooterHistory->RewindTime : 0.0;
+
+	// nothing to compensate for, so just run a regular trace
+	if (ShooterLagCompensation::Enabled == 0 || RewindTime <= 0.0)
+	{
+		return World->LineTraceSingleByChannel(OutHit, Start, End, TraceChannel, QueryParams);
+	}
+
+	// trace the world without the recorded characters. They are tested at their rewound poses below
+	FCollisionQueryParams WorldQueryParams = QueryParams;
+
+	for (const FShooterPoseHistory& History : Histories)
+	{
+		WorldQueryParams.AddIgnoredActor(History.Character.Get());
+	}
+
+	World->LineTraceSingleByChannel(OutHit, Start, End, TraceChannel, WorldQueryParams);
+
+	const double TargetTime = World->GetTimeSeconds() - RewindTime;
+	const float TraceLength = FVector::Dist(Start, End);
+	const FVector TraceDir = (End - Start).GetSafeNormal();
+
+	float ClosestDistance = OutHit.bBlockingHit ? OutHit.Distance : TraceLength;
+
+	for (const FShooterPoseHistory& History : Histories)
+	{
+		ACharacter* Target = History.Character.Get();
+
+		// shooters can't hit themselves
+		if (!Target || Target == Shooter)
+		{
+			continue;
+		}
+
+		// characters that can't be hit right now, like dead ones, don't stop the shot
+		const UCapsuleComponent* Capsule = Target->GetCapsuleComponent();
+
+		if (!Capsule->IsQueryCollisionEnabled() || Capsule->GetCollisionResponseToChannel(TraceChannel) != ECR_Block)
+		{
+			continue;
+		}
+
+		FShooterPoseSample Pose;
+
+		if (!GetPoseAtTime(History, TargetTime, Pose))
+		{
+			continue;
+		}
+
+		// find the closest approach between the trace and the capsule axis
+		const FVector AxisOffset(0.0f, 0.0f, FMath::Max(0.0f, Pose.HalfHeight - Pose.Radius));
+		const FVector AxisTop = Pose.Location + AxisOffset;
+		const FVector AxisBottom = Pose.Location - AxisOffset;
+
+		FVector OnTrace, OnAxis;
+		FMath::SegmentDistToSegmentSafe(Start, End, AxisTop, AxisBottom, OnTrace, OnAxis);
+
+		const float DistSquared = FVector::DistSquared(OnTrace, OnAxis);
+
+		if (DistSquared > FMath::Square(Pose.Radius))
+		{
+			continue;
+		}
+
+		// step back from the closest approach to where the trace enters the capsule
+		const float HitDistance = FMath::Max(0.0f, static_cast<float>(FVector::Dist(Start, OnTrace)) - FMath::Sqrt(FMath::Square(Pose.Radius) - DistSquared));
+
+		if (HitDistance >= ClosestDistance)
+		{
+			continue;
+		}
+
+		ClosestDistance = HitDistance;
+
+		const FVector HitLocation = Start + (TraceDir * HitDistance);
+		const FVector HitNormal = (HitLocation - FMath::ClosestPointOnSegment(HitLocation, AxisBottom, AxisTop)).GetSafeNormal();
+
+		// report the hit against the character's capsule
+		OutHit = FHitResult(Target, Target->GetCapsuleComponent(), HitLocation, HitNormal);
+		OutHit.TraceStart = Start;
+		OutHit.TraceEnd = End;
+		OutHit.Distance = HitDistance;
+		OutHit.Time = TraceLength > 0.0f ? HitDistance / TraceLength : 0.0f;
+		OutHit.bBlockingHit = true;
+	}
+
+	return OutHit.bBlockingHit;
+}
+
+const FShooterPoseHistory* UShooterLagCompensation::FindHistory(const AActor* Character) const
+{
+	if (!Character)
+	{
+		return nullptr;
+	}
+
+	return Histories.FindByPredicate([Character](const FShooterPoseHistory& History)
+	{
+		return History.Character == Character;
+	});
+}
+
+bool UShooterLagCompensation::GetPoseAtTime(const FShooterPoseHistory& History, double Time, FShooterPoseSample& OutPose) const
+{
+	if (History.Count == 0)
+	{
+		return false;
+	}
+
+	const int32 Size = History.Samples.Num();
+	const FShooterPoseSample* Newer = nullptr;
+
+	// walk from the newest sample back until we pass the requested time
+	for (int32 Age = 0; Age < History.Count; ++Age)
+	{
+		const FShooterPoseSample& Sample = History.Samples[(History.Head - 1 - Age + Size) % Size];
+
+		if (Sample.Time <= Time)
+		{
+			// the requested time is newer than anything recorded
+			if (!Newer)
+			{
+				OutPose = Sample;
+				return true;
+			}
+
+			// blend between the two samples around the requested time
+			const double Span = Newer->Time - Sample.Time;
+			const float Alpha = Span > UE_SMALL_NUMBER ? static_cast<float>((Time - Sample.Time) / Span) : 0.0f;
+
+			OutPose.Time = Time;
+			OutPose.Location = FMath::Lerp(Sample.Location, Newer->Location, Alpha);
+			OutPose.Radius = FMath::Lerp(Sample.Radius, Newer->Radius, Alpha);
+			OutPose.HalfHeight = FMath::Lerp(Sample.HalfHeight, Newer->HalfHeight, Alpha);
+			return true;
+		}
+
+		Newer = &Sample;
+	}
+
+	// older than the whole history, so use the oldest pose we have
+	OutPose = *Newer;
+	return true;
+}
@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterLagCompensation.generated.h"
+
+class ACharacter;
+
+/**
+ *  Capsule pose of a character at a point in server time. Capsules stay upright, so no rotation is needed
+ */
+struct FShooterPoseSample
+{
+	/** Server time the pose was recorded at */
+	double Time = 0.0;
+
+	/** Capsule center */
+	FVector Location = FVector::ZeroVector;
+
+	/** Capsule radius */
+	float Radius = 0.0f;
+
+	/** Capsule half height, including the hemispheres */
+	float HalfHeight = 0.0f;
+};
+
+/**
+ *  Fixed size ring buffer of recent capsule poses for a single character
+ */
+struct FShooterPoseHistory
+{
+	/** Character being recorded */
+	TWeakObjectPtr<ACharacter> Character;
+
+	/** Ring buffer storage. Sized once on registration */
+	TArray<FShooterPoseSample> Samples;
+
+	/** Index the next sample will be written to */
+	int32 Head = 0;
+
+	/** Number of valid samples in the buffer */
+	int32 Count = 0;
+
+	/** How far back in time this character's shots are validated, from its last fire request */
+	double RewindTime = 0.0;
+};
+
+/**
+ *  Server side lag compensation for shooter hit validation
+ *  Records a ring buffer of capsule poses for every registered character each frame,
+ *  and traces shots against the poses the shooter saw when it pulled the trigger
+ */
+UCLASS()
+class FPSPROJECT3_API UShooterLagCompensation : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	/** Pose history for each registered character */
+	TArray<FShooterPoseHistory> Histories;
+
+public:
+
+	/** Only record poses in game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Records the current pose of every registered character */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Returns the stat id for this tickable */
+	virtual TStatId GetStatId() const override;
+
+	/** Starts recording poses for the character. Server only */
+	void RegisterCharacter(ACharacter* Character);
+
+	/** Stops recording poses for the character */
+	void UnregisterCharacter(ACharacter* Character);
+
+	/** Sets how far back the shooter's shots are rewound, from the server time of the world state it was viewing when it fired */
+	void SetShooterTimestamp(const ACharacter* Shooter, double ViewTime);
+
+	/**
+	 *  Line trace that tests registered characters at the poses the shooter saw. Characters whose capsule doesn't currently
+	 *  block the channel are skipped. Falls back to a regular trace when no rewind is needed
+	 */
+	bool LineTraceRewound(FHitResult& OutHit, const FVector& Start, const FVector& End, ECollisionChannel TraceChannel, const FCollisionQueryParams& QueryParams, const AActor* Shooter) const;
+
+protected:
+
+	/** Returns the history for the character, or nullptr if it isn't registered */
+	const FShooterPoseHistory* FindHistory(const AActor* Character) const;
+
+	/** Interpolates the recorded pose at the given time. Returns false if nothing was recorded */
+	bool GetPoseAtTime(const FShooterPoseHistory& History, double Time, FShooterPoseSample& OutPose) const;
+};
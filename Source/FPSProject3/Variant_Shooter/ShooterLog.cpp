@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Variant_Shooter/ShooterLog.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_LOG_CATEGORY(LogShooter);
+DEFINE_LOG_CATEGORY(LogShooterWeapon);
+DEFINE_LOG_CATEGORY(LogShooterProjectile);
+DEFINE_LOG_CATEGORY(LogShooterNet);
+DEFINE_LOG_CATEGORY(LogShooterAI);
+DEFINE_LOG_CATEGORY(LogShooterGameMode);
+
+#if !NO_LOGGING
+
+static FAutoConsoleCommand ShooterLogVerbosityCommand(
+	TEXT("Shooter.Log.Verbosity"),
+	TEXT("Sets the verbosity of every Shooter log category. Usage: Shooter.Log.Verbosity <Error|Warning|Display|Log|Verbose|VeryVerbose>"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		FLogCategoryBase* const Categories[] = { &LogShooter, &LogShooterWeapon, &LogShooterProjectile, &LogShooterNet, &LogShooterAI, &LogShooterGameMode };
+
+		const ELogVerbosity::Type Verbosity = Args.Num() > 0 ? ParseLogVerbosityFromString(Args[0]) : ELogVerbosity::Log;
+
+		// categories clamp this to their compiled verbosity
+		for (FLogCategoryBase* Category : Categories)
+		{
+			Category->SetVerbosity(Verbosity);
+		}
+
+		UE_LOG(LogShooter, Display, TEXT("Shooter log verbosity set to %s"), ToString(Verbosity));
+	}));
+
+#endif
@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Shipping and Test builds compile shooter logging down to warnings and errors, so verbose messages cost nothing */
+#if UE_BUILD_SHIPPING || UE_BUILD_TEST
+#define SHOOTER_LOG_COMPILED_VERBOSITY Warning
+#else
+#define SHOOTER_LOG_COMPILED_VERBOSITY All
+#endif
+
+/** Characters, health and UI */
+DECLARE_LOG_CATEGORY_EXTERN(LogShooter, Log, SHOOTER_LOG_COMPILED_VERBOSITY);
+
+/** Weapon firing, switching and pickups */
+DECLARE_LOG_CATEGORY_EXTERN(LogShooterWeapon, Log, SHOOTER_LOG_COMPILED_VERBOSITY);
+
+/** Projectiles and the projectile pool */
+DECLARE_LOG_CATEGORY_EXTERN(LogShooterProjectile, Log, SHOOTER_LOG_COMPILED_VERBOSITY);
+
+/** Input stream and replication */
+DECLARE_LOG_CATEGORY_EXTERN(LogShooterNet, Log, SHOOTER_LOG_COMPILED_VERBOSITY);
+
+/** NPCs and perception */
+DECLARE_LOG_CATEGORY_EXTERN(LogShooterAI, Log, SHOOTER_LOG_COMPILED_VERBOSITY);
+
+/** Game mode, scoring and respawns */
+DECLARE_LOG_CATEGORY_EXTERN(LogShooterGameMode, Log, SHOOTER_LOG_COMPILED_VERBOSITY);
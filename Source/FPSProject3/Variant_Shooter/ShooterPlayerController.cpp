@@ -10,9 +10,12 @@
 #include "ShooterCharacter.h"
 #include "ShooterBulletCounterUI.h"
 #include "FPSProject3.h"
+#include "Variant_Shooter/ShooterLog.h"
+#include "Variant_Shooter/ShooterStats.h"
 #include "Widgets/Input/SVirtualJoystick.h"
 #include "UI/ShooterUI.h"
 #include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
 #include "Variant_Shooter/ShooterGameState.h"
 void AShooterPlayerController::BeginPlay()
 {
@@ -83,6 +86,10 @@ void AShooterPlayerController::BeginPlay()
 			GameState->RegisteredServerControllersCount = GameState->RegisteredServerControllersCount + 1;
 			CustomPlayerName = FString::Printf(TEXT("Client Player %d"), NetworkPlayerID);
 		}
+
+		MARK_PROPERTY_DIRTY_FROM_NAME(AShooterPlayerController, PlayerTeamByte, this);
+		MARK_PROPERTY_DIRTY_FROM_NAME(AShooterPlayerController, CustomPlayerName, this);
+		MARK_PROPERTY_DIRTY_FROM_NAME(AShooterPlayerController, NetworkPlayerID, this);
 	}
 }
 
@@ -125,13 +132,11 @@ void AShooterPlayerController::OnPawnDestroyed(AActor* DestroyedActor)
 	}
 
 	// Respawn is now handled by GameMode. Just log and let server schedule/perform respawn.
-	UE_LOG(LogTemp, Log, TEXT("OnPawnDestroyed: pawn destroyed for controller %s - respawn will be handled by server GameMode"), *GetName());
+	UE_LOG(LogShooter, Verbose, TEXT("OnPawnDestroyed: pawn destroyed for controller %s - respawn will be handled by server GameMode"), *GetName());
 }
 
 void AShooterPlayerController::OnBulletCountUpdated(int32 MagazineSize, int32 Bullets)
 {
-	if(IsLocalPlayerController())
-		UE_LOG(LogTemp, Log, TEXT("调用AShooterPlayerController::OnBulletCountUpdated"));
 	// update the UI
 	if (BulletCounterUI)
 	{
@@ -149,6 +154,8 @@ void AShooterPlayerController::OnPawnDamaged(float LifePercent)
 
 void AShooterPlayerController::Client_UpdateTeamScore_Implementation(uint8 TeamByte, int32 Score)
 {
+	INC_DWORD_STAT(STAT_ShooterRPCs);
+
 	// Ensure this runs on owning client and UI exists
 	if (!IsLocalPlayerController()) return;
 
@@ -191,16 +198,20 @@ void AShooterPlayerController::UpdateLocalTeamScore(uint8 TeamByte, int32 Score)
 
 void AShooterPlayerController::Client_OnRespawned_Implementation()
 {
+	INC_DWORD_STAT(STAT_ShooterRPCs);
+
 	// Client-side hook after server respawned and possessed a new pawn.
 	// Blueprints can override or bind to this event. For now just log.
 	if (IsLocalPlayerController())
 	{
-		UE_LOG(LogTemp, Log, TEXT("Client_OnRespawned: local player has been respawned by server."));
+		UE_LOG(LogShooter, Log, TEXT("Client_OnRespawned: local player has been respawned by server."));
 	}
 }
 
 void AShooterPlayerController::Client_OnGameOver_Implementation(bool bWin, uint8 WinningTeam)
 {
+	INC_DWORD_STAT(STAT_ShooterRPCs);
+
 	// Ensure this runs on owning client
 	if (!IsLocalPlayerController()) return;
 
@@ -220,12 +231,17 @@ void AShooterPlayerController::Client_OnGameOver_Implementation(bool bWin, uint8
 		ShooterUI->BP_GameOver(bWin);
 	}
 
-	UE_LOG(LogTemp, Log, TEXT("Client_OnGameOver: WinningTeam=%d, bWin=%d"), WinningTeam, bWin);
+	UE_LOG(LogShooter, Log, TEXT("Client_OnGameOver: WinningTeam=%d, bWin=%d"), WinningTeam, bWin);
 }
 
 void AShooterPlayerController::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 	// 配置TeamByte从服务器复制到所有客户端
-	DOREPLIFETIME(AShooterPlayerController, PlayerTeamByte);
+	FDoRepLifetimeParams SharedParams;
+	SharedParams.bIsPushBased = true;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShooterPlayerController, PlayerTeamByte, SharedParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShooterPlayerController, CustomPlayerName, SharedParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShooterPlayerController, NetworkPlayerID, SharedParams);
 }
\ No newline at end of file
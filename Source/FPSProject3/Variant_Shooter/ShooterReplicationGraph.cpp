@@ -0,0 +1,320 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Variant_Shooter/ShooterReplicationGraph.h"
+#include "Variant_Shooter/ShooterCharacter.h"
+#include "Variant_Shooter/ShooterGameState.h"
+#include "Variant_Shooter/ShooterPlayerController.h"
+#include "Variant_Shooter/ShooterLog.h"
+#include "Variant_Shooter/Weapons/ShooterPickup.h"
+#include "Variant_Shooter/Weapons/ShooterProjectile.h"
+#include "Variant_Shooter/Weapons/ShooterWeapon.h"
+#include "Engine/NetConnection.h"
+#include "Algo/AnyOf.h"
+#include "UObject/UObjectIterator.h"
+
+UShooterReplicationGraphNode_Team::UShooterReplicationGraphNode_Team()
+{
+	// team lists are rebuilt once per frame rather than per connection
+	bRequiresPrepareForReplicationCall = true;
+}
+
+void UShooterReplicationGraphNode_Team::NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo)
+{
+	if (ActorInfo.Actor->IsA<AShooterCharacter>())
+	{
+		TeamActors.Add(ActorInfo.Actor);
+	}
+	else
+	{
+		SharedActors.Add(ActorInfo.Actor);
+	}
+}
+
+bool UShooterReplicationGraphNode_Team::NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound)
+{
+	// the actor is picked up from the team lists on the next rebuild
+	return TeamActors.RemoveFast(ActorInfo.Actor) || SharedActors.RemoveFast(ActorInfo.Actor);
+}
+
+void UShooterReplicationGraphNode_Team::NotifyResetAllNetworkActors()
+{
+	SharedActors.Reset();
+	TeamActors.Reset();
+	TeamLists.Reset();
+}
+
+void UShooterReplicationGraphNode_Team::PrepareForReplication()
+{
+	for (FActorRepListRefView& TeamList : TeamLists)
+	{
+		TeamList.Reset();
+	}
+
+	// teams are assigned after the character spawns, so sort on every frame instead of on add
+	for (FActorRepListType Actor : TeamActors)
+	{
+		const int32 Team = GetActorTeam(Actor);
+
+		if (Team == INDEX_NONE)
+		{
+			continue;
+		}
+
+		if (!TeamLists.IsValidIndex(Team))
+		{
+			TeamLists.SetNum(Team + 1);
+		}
+
+		TeamLists[Team].Add(Actor);
+	}
+}
+
+void UShooterReplicationGraphNode_Team::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	if (SharedActors.Num() > 0)
+	{
+		Params.OutGatheredReplicationLists.AddReplicationActorList(SharedActors);
+	}
+
+	const AShooterPlayerController* PC = Params.ConnectionManager.NetConnection ? Cast<AShooterPlayerController>(Params.ConnectionManager.NetConnection->PlayerController) : nullptr;
+
+	if (PC && TeamLists.IsValidIndex(PC->PlayerTeamByte) && TeamLists[PC->PlayerTeamByte].Num() > 0)
+	{
+		Params.OutGatheredReplicationLists.AddReplicationActorList(TeamLists[PC->PlayerTeamByte]);
+	}
+}
+
+int32 UShooterReplicationGraphNode_Team::GetActorTeam(const AActor* Actor)
+{
+	const APawn* Pawn = Cast<APawn>(Actor);
+
+	if (const AShooterPlayerController* PC = Pawn ? Cast<AShooterPlayerController>(Pawn->GetController()) : nullptr)
+	{
+		return PC->PlayerTeamByte;
+	}
+
+	return INDEX_NONE;
+}
+
+void UShooterReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	// explicit policies. Subclasses, including blueprints, inherit these through the class map
+	const TPair<UClass*, EShooterClassRepNodeMapping> ExplicitPolicies[] =
+	{
+		{ AShooterGameState::StaticClass(), EShooterClassRepNodeMapping::Team },
+		{ AShooterCharacter::StaticClass(), EShooterClassRepNodeMapping::Spatialize_Dynamic },
+		{ AShooterProjectile::StaticClass(), EShooterClassRepNodeMapping::Spatialize_Dynamic },
+		{ AShooterPickup::StaticClass(), EShooterClassRepNodeMapping::Spatialize_Dormancy },
+		{ AShooterWeapon::StaticClass(), EShooterClassRepNodeMapping::RelevantOwnerConnection }
+	};
+
+	for (const TPair<UClass*, EShooterClassRepNodeMapping>& Policy : ExplicitPolicies)
+	{
+		ClassRepNodePolicies.Set(Policy.Key, Policy.Value);
+	}
+
+	// derive a policy and replication settings for every other replicated class
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		UClass* Class = *It;
+
+		// skip blueprint skeleton and reinstancing classes
+		if (Class->GetName().StartsWith(TEXT("SKEL_")) || Class->GetName().StartsWith(TEXT("REINST_")))
+		{
+			continue;
+		}
+
+		const AActor* ActorCDO = Cast<AActor>(Class->GetDefaultObject(false));
+
+		if (!ActorCDO || !ActorCDO->GetIsReplicated())
+		{
+			continue;
+		}
+
+		const bool bHasExplicitPolicy = Algo::AnyOf(ExplicitPolicies, [Class](const TPair<UClass*, EShooterClassRepNodeMapping>& Policy)
+		{
+			return Class->IsChildOf(Policy.Key);
+		});
+
+		if (!bHasExplicitPolicy)
+		{
+			ClassRepNodePolicies.Set(Class, GetMappingPolicyFromDefaults(ActorCDO));
+		}
+
+		// cull distance and update rate come straight from the actor defaults
+		FClassReplicationInfo ClassInfo;
+		ClassInfo.SetCullDistanceSquared(ActorCDO->GetNetCullDistanceSquared());
+		ClassInfo.ReplicationPeriodFrame = GetReplicationPeriodFrameForFrequency(ActorCDO->GetNetUpdateFrequency());
+
+		GlobalActorReplicationInfoMap.SetClassInfo(Class, ClassInfo);
+	}
+}
+
+void UShooterReplicationGraph::InitGlobalGraphNodes()
+{
+	GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+	GridNode->CellSize = GridCellSize;
+	GridNode->SpatialBias = GridSpatialBias;
+	AddGlobalGraphNode(GridNode);
+
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddGlobalGraphNode(AlwaysRelevantNode);
+
+	TeamNode = CreateNewNode<UShooterReplicationGraphNode_Team>();
+	AddGlobalGraphNode(TeamNode);
+}
+
+void UShooterReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* ConnectionManager)
+{
+	Super::InitConnectionGraphNodes(ConnectionManager);
+
+	// gathers the connection's viewer and view target, plus any owner only actors routed to it
+	UReplicationGraphNode_AlwaysRelevant_ForConnection* OwnerNode = CreateNewNode<UReplicationGraphNode_AlwaysRelevant_ForConnection>();
+	AddConnectionGraphNode(OwnerNode, ConnectionManager);
+
+	OwnerRelevantNodes.Add(ConnectionManager->NetConnection, OwnerNode);
+}
+
+void UShooterReplicationGraph::RemoveClientConnection(UNetConnection* NetConnection)
+{
+	OwnerRelevantNodes.Remove(NetConnection);
+
+	Super::RemoveClientConnection(NetConnection);
+}
+
+void UShooterReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	switch (GetMappingPolicy(ActorInfo.Class))
+	{
+	case EShooterClassRepNodeMapping::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+		break;
+
+	case EShooterClassRepNodeMapping::RelevantOwnerConnection:
+		if (UReplicationGraphNode_AlwaysRelevant_ForConnection** OwnerNode = OwnerRelevantNodes.Find(ActorInfo.Actor->GetNetConnection()))
+		{
+			(*OwnerNode)->NotifyAddNetworkActor(ActorInfo);
+		}
+		break;
+
+	case EShooterClassRepNodeMapping::Team:
+		TeamNode->NotifyAddNetworkActor(ActorInfo);
+		break;
+
+	case EShooterClassRepNodeMapping::Spatialize_Static:
+		GridNode->AddActor_Static(ActorInfo, GlobalInfo);
+		break;
+
+	case EShooterClassRepNodeMapping::Spatialize_Dynamic:
+		GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+		break;
+
+	case EShooterClassRepNodeMapping::Spatialize_Dormancy:
+		GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+		break;
+
+	default:
+		break;
+	}
+
+	// player characters also stay relevant to their teammates at any distance
+	if (IsTeamCharacterClass(ActorInfo.Class))
+	{
+		TeamNode->NotifyAddNetworkActor(ActorInfo);
+	}
+}
+
+void UShooterReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	switch (GetMappingPolicy(ActorInfo.Class))
+	{
+	case EShooterClassRepNodeMapping::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+		break;
+
+	case EShooterClassRepNodeMapping::RelevantOwnerConnection:
+		// the owner may have changed since the actor was added, so check every connection
+		for (const TPair<UNetConnection*, UReplicationGraphNode_AlwaysRelevant_ForConnection*>& OwnerNode : OwnerRelevantNodes)
+		{
+			OwnerNode.Value->NotifyRemoveNetworkActor(ActorInfo, false);
+		}
+		break;
+
+	case EShooterClassRepNodeMapping::Team:
+		TeamNode->NotifyRemoveNetworkActor(ActorInfo);
+		break;
+
+	case EShooterClassRepNodeMapping::Spatialize_Static:
+		GridNode->RemoveActor_Static(ActorInfo);
+		break;
+
+	case EShooterClassRepNodeMapping::Spatialize_Dynamic:
+		GridNode->RemoveActor_Dynamic(ActorInfo);
+		break;
+
+	case EShooterClassRepNodeMapping::Spatialize_Dormancy:
+		GridNode->RemoveActor_Dormancy(ActorInfo);
+		break;
+
+	default:
+		break;
+	}
+
+	if (IsTeamCharacterClass(ActorInfo.Class))
+	{
+		TeamNode->NotifyRemoveNetworkActor(ActorInfo, false);
+	}
+}
+
+EShooterClassRepNodeMapping UShooterReplicationGraph::GetMappingPolicy(UClass* Class)
+{
+	if (const EShooterClassRepNodeMapping* Policy = ClassRepNodePolicies.Get(Class))
+	{
+		return *Policy;
+	}
+
+	// classes loaded after the graph initialized, like streamed in or soft loaded blueprints, aren't in the map yet.
+	// Route them from their defaults instead of leaving them out of replication
+	const AActor* ActorCDO = Class ? Cast<AActor>(Class->GetDefaultObject()) : nullptr;
+
+	if (!ActorCDO)
+	{
+		return EShooterClassRepNodeMapping::NotRouted;
+	}
+
+	const EShooterClassRepNodeMapping Policy = GetMappingPolicyFromDefaults(ActorCDO);
+	ClassRepNodePolicies.Set(Class, Policy);
+
+	UE_LOG(LogShooterNet, Warning, TEXT("ShooterReplicationGraph - %s was loaded after the graph initialized, routing it as %s"), *Class->GetName(), *UEnum::GetValueAsString(Policy));
+
+	return Policy;
+}
+
+EShooterClassRepNodeMapping UShooterReplicationGraph::GetMappingPolicyFromDefaults(const AActor* ActorCDO) const
+{
+	// controllers and other owner only actors are gathered through the connection's viewers
+	if (ActorCDO->bOnlyRelevantToOwner)
+	{
+		return EShooterClassRepNodeMapping::NotRouted;
+	}
+
+	if (ActorCDO->bAlwaysRelevant)
+	{
+		return EShooterClassRepNodeMapping::RelevantAllConnections;
+	}
+
+	if (ActorCDO->IsReplicatingMovement())
+	{
+		return EShooterClassRepNodeMapping::Spatialize_Dynamic;
+	}
+
+	return ActorCDO->NetDormancy > DORM_Awake ? EShooterClassRepNodeMapping::Spatialize_Dormancy : EShooterClassRepNodeMapping::Spatialize_Static;
+}
+
+bool UShooterReplicationGraph::IsTeamCharacterClass(const UClass* Class)
+{
+	return Class && Class->IsChildOf(AShooterCharacter::StaticClass());
+}
@@ -0,0 +1,139 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraph.h"
+#include "ShooterReplicationGraph.generated.h"
+
+class UReplicationGraphNode_GridSpatialization2D;
+class UReplicationGraphNode_ActorList;
+class UReplicationGraphNode_AlwaysRelevant_ForConnection;
+
+/**
+ *  How the replication graph routes a class of actors
+ */
+UENUM()
+enum class EShooterClassRepNodeMapping : uint8
+{
+	/** Not routed to any node. Gathered by the connection that views it, like player controllers */
+	NotRouted,
+
+	/** Replicated to every connection */
+	RelevantAllConnections,
+
+	/** Replicated only to the connection that owns it */
+	RelevantOwnerConnection,
+
+	/** Replicated through the team node */
+	Team,
+
+	/** Spatialized, never moves */
+	Spatialize_Static,
+
+	/** Spatialized, moves every frame */
+	Spatialize_Dynamic,
+
+	/** Spatialized, moves only while awake */
+	Spatialize_Dormancy
+};
+
+/**
+ *  Replicates actors by team
+ *  Shared actors such as the game state go to every connection. Characters also go to
+ *  every connection on their own team regardless of distance, so teammates never pop out
+ */
+UCLASS()
+class FPSPROJECT3_API UShooterReplicationGraphNode_Team : public UReplicationGraphNode
+{
+	GENERATED_BODY()
+
+	/** Actors replicated to every team */
+	FActorRepListRefView SharedActors;
+
+	/** Characters to sort into team lists */
+	FActorRepListRefView TeamActors;
+
+	/** Characters by team, rebuilt once per replication frame */
+	TArray<FActorRepListRefView> TeamLists;
+
+public:
+
+	/** Constructor */
+	UShooterReplicationGraphNode_Team();
+
+	//~Begin UReplicationGraphNode
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override;
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override;
+	virtual void NotifyResetAllNetworkActors() override;
+	virtual void PrepareForReplication() override;
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+	//~End UReplicationGraphNode
+
+protected:
+
+	/** Returns the team of a character, or INDEX_NONE if it isn't possessed by a player yet */
+	static int32 GetActorTeam(const AActor* Actor);
+};
+
+/**
+ *  Replication graph for the shooter variant
+ *  Characters, NPCs and projectiles are spatialized on a 2D grid, pickups sleep in the grid
+ *  until they change state, owner only actors go to their owning connection and the game state
+ *  is served by the team node
+ */
+UCLASS(Transient, Config=Engine)
+class FPSPROJECT3_API UShooterReplicationGraph : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+	/** Spatialized actors */
+	UPROPERTY()
+	TObjectPtr<UReplicationGraphNode_GridSpatialization2D> GridNode;
+
+	/** Actors relevant to every connection */
+	UPROPERTY()
+	TObjectPtr<UReplicationGraphNode_ActorList> AlwaysRelevantNode;
+
+	/** Game state and teammates */
+	UPROPERTY()
+	TObjectPtr<UShooterReplicationGraphNode_Team> TeamNode;
+
+	/** Owner only actors by owning connection */
+	TMap<UNetConnection*, UReplicationGraphNode_AlwaysRelevant_ForConnection*> OwnerRelevantNodes;
+
+	/** Routing policy by class */
+	TClassMap<EShooterClassRepNodeMapping> ClassRepNodePolicies;
+
+protected:
+
+	/** Size of a spatialization grid cell */
+	UPROPERTY(Config)
+	float GridCellSize = 10000.0f;
+
+	/** Lowest world coordinate covered by the grid. Actors below it are clamped into the first cell */
+	UPROPERTY(Config)
+	FVector2D GridSpatialBias = FVector2D(-200000.0f, -200000.0f);
+
+public:
+
+	//~Begin UReplicationGraph
+	virtual void InitGlobalActorClassSettings() override;
+	virtual void InitGlobalGraphNodes() override;
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* ConnectionManager) override;
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+	virtual void RemoveClientConnection(UNetConnection* NetConnection) override;
+	//~End UReplicationGraph
+
+protected:
+
+	/** Returns the routing policy for a class. Classes loaded after the graph initialized get one from their defaults */
+	EShooterClassRepNodeMapping GetMappingPolicy(UClass* Class);
+
+	/** Picks a routing policy for a replicated class from its defaults */
+	EShooterClassRepNodeMapping GetMappingPolicyFromDefaults(const AActor* ActorCDO) const;
+
+	/** Returns true if the class is a player character, which also routes through the team node */
+	static bool IsTeamCharacterClass(const UClass* Class);
+};
@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Variant_Shooter/ShooterStats.h"
+
+DEFINE_STAT(STAT_ShooterWeaponFire);
+DEFINE_STAT(STAT_ShooterProjectileHit);
+DEFINE_STAT(STAT_ShooterProjectileExplosion);
+DEFINE_STAT(STAT_ShooterProjectileSimulation);
+DEFINE_STAT(STAT_ShooterLagCompensatedTrace);
+DEFINE_STAT(STAT_ShooterTakeDamage);
+DEFINE_STAT(STAT_ShooterAITasks);
+DEFINE_STAT(STAT_ShooterAISenseEnemies);
+DEFINE_STAT(STAT_ShooterAICrowd);
+DEFINE_STAT(STAT_ShooterRespawn);
+
+DEFINE_STAT(STAT_ShooterShots);
+DEFINE_STAT(STAT_ShooterTraces);
+DEFINE_STAT(STAT_ShooterDamageEvents);
+DEFINE_STAT(STAT_ShooterRPCs);
+DEFINE_STAT(STAT_ShooterAIStimuli);
+
+DEFINE_STAT(STAT_ShooterLiveProjectiles);
+DEFINE_STAT(STAT_ShooterSimulatedProjectiles);
+DEFINE_STAT(STAT_ShooterCrowdAgents);
+
+FShooterCostCounter ShooterCost::Shots;
+FShooterCostCounter ShooterCost::Respawns;
+
+UE_TRACE_CHANNEL_DEFINE(ShooterChannel);
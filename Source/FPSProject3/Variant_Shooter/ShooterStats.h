@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+/** Shooter gameplay stats. Show them with "stat Shooter" */
+DECLARE_STATS_GROUP(TEXT("Shooter"), STATGROUP_Shooter, STATCAT_Advanced);
+
+/** Cycle counters */
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Weapon Fire"), STAT_ShooterWeaponFire, STATGROUP_Shooter, FPSPROJECT3_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Projectile Hit"), STAT_ShooterProjectileHit, STATGROUP_Shooter, FPSPROJECT3_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Projectile Explosion"), STAT_ShooterProjectileExplosion, STATGROUP_Shooter, FPSPROJECT3_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Projectile Simulation"), STAT_ShooterProjectileSimulation, STATGROUP_Shooter, FPSPROJECT3_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Lag Compensated Trace"), STAT_ShooterLagCompensatedTrace, STATGROUP_Shooter, FPSPROJECT3_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Take Damage"), STAT_ShooterTakeDamage, STATGROUP_Shooter, FPSPROJECT3_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("AI StateTree Tasks"), STAT_ShooterAITasks, STATGROUP_Shooter, FPSPROJECT3_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("AI Sense Enemies"), STAT_ShooterAISenseEnemies, STATGROUP_Shooter, FPSPROJECT3_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("AI Crowd"), STAT_ShooterAICrowd, STATGROUP_Shooter, FPSPROJECT3_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Respawn"), STAT_ShooterRespawn, STATGROUP_Shooter, FPSPROJECT3_API);
+
+/** Per frame counters */
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Shots"), STAT_ShooterShots, STATGROUP_Shooter, FPSPROJECT3_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Traces"), STAT_ShooterTraces, STATGROUP_Shooter, FPSPROJECT3_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Damage Events"), STAT_ShooterDamageEvents, STATGROUP_Shooter, FPSPROJECT3_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("RPCs Received"), STAT_ShooterRPCs, STATGROUP_Shooter, FPSPROJECT3_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("AI Stimuli Processed"), STAT_ShooterAIStimuli, STATGROUP_Shooter, FPSPROJECT3_API);
+
+/** Running totals */
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Live Projectiles"), STAT_ShooterLiveProjectiles, STATGROUP_Shooter, FPSPROJECT3_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Simulated Projectiles"), STAT_ShooterSimulatedProjectiles, STATGROUP_Shooter, FPSPROJECT3_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Crowd Agents"), STAT_ShooterCrowdAgents, STATGROUP_Shooter, FPSPROJECT3_API);
+
+/** Running cost of a server operation, kept in every build configuration so benchmark runs can gate on it */
+struct FShooterCostCounter
+{
+	/** Cycles spent over all recorded calls */
+	uint64 TotalCycles = 0;
+
+	/** Cycles spent in the most expensive call */
+	uint64 MaxCycles = 0;
+
+	/** Number of recorded calls */
+	int32 Count = 0;
+
+	/** Adds one call */
+	void Record(uint64 Cycles)
+	{
+		TotalCycles += Cycles;
+		MaxCycles = FMath::Max(MaxCycles, Cycles);
+		++Count;
+	}
+
+	/** Returns the average cost of a call in microseconds */
+	double GetAverageUs() const
+	{
+		return Count > 0 ? FPlatformTime::ToSeconds64(TotalCycles) * 1000000.0 / Count : 0.0;
+	}
+
+	/** Returns the cost of the most expensive call in microseconds */
+	double GetMaxUs() const
+	{
+		return FPlatformTime::ToSeconds64(MaxCycles) * 1000000.0;
+	}
+};
+
+namespace ShooterCost
+{
+	/** Authoritative AShooterWeapon::Fire calls */
+	extern FPSPROJECT3_API FShooterCostCounter Shots;
+
+	/** Player respawns handled by the game mode */
+	extern FPSPROJECT3_API FShooterCostCounter Respawns;
+}
+
+/** Insights channel for shooter scopes. Enable it with -trace=cpu,shooter */
+UE_TRACE_CHANNEL_EXTERN(ShooterChannel, FPSPROJECT3_API);
+
+/** Times a scope in the Shooter stat group and shows it as a named event on the Shooter trace channel */
+#define SHOOTER_SCOPE_CYCLE_COUNTER(Stat) \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Stat, ShooterChannel)
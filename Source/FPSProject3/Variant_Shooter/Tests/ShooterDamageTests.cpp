@@ -0,0 +1,124 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Variant_Shooter/Tests/ShooterTestActors.h"
+#include "Variant_Shooter/Tests/ShooterTestWorld.h"
+#include "Variant_Shooter/ShooterDamageQuery.h"
+#include "Components/CapsuleComponent.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FShooterResolvedHitDamageTest, "FPSProject3.Shooter.Damage.ResolvedHit", SHOOTER_TEST_FLAGS)
+
+bool FShooterResolvedHitDamageTest::RunTest(const FString& Parameters)
+{
+	FShooterTestWorld TestWorld;
+
+	AShooterTestWeaponHolder* Holder = TestWorld.Spawn<AShooterTestWeaponHolder>();
+	AShooterTestWeapon* Weapon = TestWorld.Spawn<AShooterTestWeapon>(FVector::ZeroVector, Holder, Holder);
+	AShooterTestDamageTarget* Target = TestWorld.Spawn<AShooterTestDamageTarget>(FVector(1000.0f, 0.0f, 0.0f));
+
+	// hitscan shots apply the projectile type's damage with the weapon standing in as the causer
+	const AShooterTestProjectile* ProjectileType = GetDefault<AShooterTestProjectile>();
+	ProjectileType->ProcessResolvedHit(Weapon, FHitResult(Target, Target->GetCapsuleComponent(), Target->GetActorLocation(), -FVector::ForwardVector), FVector::ForwardVector);
+
+	TestEqual("Hits", Target->NumHits, 1);
+	TestEqual("Damage", Target->DamageTaken, ProjectileType->GetHitDamage());
+	TestTrue("Damage causer is the weapon", Target->LastDamageCauser.Get() == Weapon);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FShooterProjectileHitDamageTest, "FPSProject3.Shooter.Damage.ProjectileHit", SHOOTER_TEST_FLAGS)
+
+bool FShooterProjectileHitDamageTest::RunTest(const FString& Parameters)
+{
+	FShooterTestWorld TestWorld;
+
+	AShooterTestWeaponHolder* Holder = TestWorld.Spawn<AShooterTestWeaponHolder>();
+	AShooterTestDamageTarget* Target = TestWorld.Spawn<AShooterTestDamageTarget>(FVector(1000.0f, 0.0f, 0.0f));
+	AShooterTestProjectile* Projectile = TestWorld.Spawn<AShooterTestProjectile>(FVector(950.0f, 0.0f, 0.0f), Holder, Holder);
+
+	const FHitResult Hit(Target, Target->GetCapsuleComponent(), Target->GetActorLocation(), -FVector::ForwardVector);
+
+	Projectile->SimulateHit(Hit);
+
+	TestEqual("Hits", Target->NumHits, 1);
+	TestEqual("Damage", Target->DamageTaken, Projectile->GetHitDamage());
+	TestTrue("Damage causer is the projectile", Target->LastDamageCauser.Get() == Projectile);
+
+	// a projectile only hits once
+	Projectile->SimulateHit(Hit);
+
+	TestEqual("Hits after a second collision", Target->NumHits, 1);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FShooterExplosionDamageTest, "FPSProject3.Shooter.Damage.Explosion", SHOOTER_TEST_FLAGS)
+
+bool FShooterExplosionDamageTest::RunTest(const FString& Parameters)
+{
+	FShooterTestWorld TestWorld;
+
+	UShooterDamageQuery* DamageQuery = TestWorld.World->GetSubsystem<UShooterDamageQuery>();
+
+	if (!TestNotNull("Damage query", DamageQuery))
+	{
+		return false;
+	}
+
+	AShooterTestWeaponHolder* Holder = TestWorld.Spawn<AShooterTestWeaponHolder>();
+	AShooterTestDamageTarget* NearTarget = TestWorld.Spawn<AShooterTestDamageTarget>(FVector(300.0f, 0.0f, 0.0f));
+	AShooterTestDamageTarget* FarTarget = TestWorld.Spawn<AShooterTestDamageTarget>(FVector(3000.0f, 0.0f, 0.0f));
+
+	for (AShooterTestDamageTarget* Target : { NearTarget, FarTarget })
+	{
+		DamageQuery->RegisterActor(Target, Target->GetCapsuleComponent(), Target->GetCapsuleComponent()->GetScaledCapsuleRadius());
+	}
+
+	AShooterTestProjectile* Projectile = TestWorld.Spawn<AShooterTestProjectile>(FVector::ZeroVector, Holder, Holder);
+	Projectile->SetExplosion(500.0f);
+
+	Projectile->SimulateHit(FHitResult());
+
+	TestEqual("Hits inside the radius", NearTarget->NumHits, 1);
+	TestEqual("Damage inside the radius", NearTarget->DamageTaken, Projectile->GetHitDamage());
+	TestTrue("Damage causer is the projectile", NearTarget->LastDamageCauser.Get() == Projectile);
+	TestEqual("Hits outside the radius", FarTarget->NumHits, 0);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FShooterKillAttributionTest, "FPSProject3.Shooter.Damage.KillAttribution", SHOOTER_TEST_FLAGS)
+
+bool FShooterKillAttributionTest::RunTest(const FString& Parameters)
+{
+	FShooterTestWorld TestWorld;
+
+	AShooterTestCharacter* Shooter = TestWorld.Spawn<AShooterTestCharacter>();
+	AShooterTestWeapon* Weapon = TestWorld.Spawn<AShooterTestWeapon>(FVector::ZeroVector, Shooter, Shooter);
+
+	AShooterTestProjectile* Projectile = TestWorld.Spawn<AShooterTestProjectile>(FVector::ZeroVector, Shooter, Shooter);
+	Projectile->SetWeaponComeFrom(Weapon);
+
+	TestTrue("Projectile kills go to the owner of its weapon", AShooterCharacter::FindKiller(Projectile) == Shooter);
+	TestTrue("Hitscan kills go to the owner of the weapon", AShooterCharacter::FindKiller(Weapon) == Shooter);
+	TestTrue("Direct kills go to the character", AShooterCharacter::FindKiller(Shooter) == Shooter);
+
+	// nobody gets the credit when the chain doesn't lead back to a shooter character
+	AShooterTestProjectile* StrayProjectile = TestWorld.Spawn<AShooterTestProjectile>();
+
+	AShooterTestWeaponHolder* Holder = TestWorld.Spawn<AShooterTestWeaponHolder>();
+	AShooterTestWeapon* HolderWeapon = TestWorld.Spawn<AShooterTestWeapon>(FVector::ZeroVector, Holder, Holder);
+
+	TestNull("Projectile without a weapon", AShooterCharacter::FindKiller(StrayProjectile));
+	TestNull("Weapon held by something else", AShooterCharacter::FindKiller(HolderWeapon));
+	TestNull("No damage causer", AShooterCharacter::FindKiller(nullptr));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
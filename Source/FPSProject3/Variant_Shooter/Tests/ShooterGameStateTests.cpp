@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Variant_Shooter/Tests/ShooterTestWorld.h"
+#include "Variant_Shooter/ShooterGameState.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FShooterTeamScoreTest, "FPSProject3.Shooter.GameState.TeamScore", SHOOTER_TEST_FLAGS)
+
+bool FShooterTeamScoreTest::RunTest(const FString& Parameters)
+{
+	FShooterTestWorld TestWorld;
+
+	AShooterGameState* GameState = TestWorld.Spawn<AShooterGameState>();
+
+	if (!TestNotNull("Game state", GameState))
+	{
+		return false;
+	}
+
+	// score one short of the win for team 0, and once for team 1
+	for (int32 Kill = 0; Kill < GameState->WinningScore - 1; ++Kill)
+	{
+		GameState->AddTeamScore(0);
+	}
+
+	GameState->AddTeamScore(1);
+
+	TestEqual("Team 0 score", GameState->GetTeamScore(0), GameState->WinningScore - 1);
+	TestEqual("Team 1 score", GameState->GetTeamScore(1), 1);
+	TestFalse("Game over before the winning score", GameState->GetIsGameOverNotified());
+
+	GameState->AddTeamScore(0);
+
+	TestEqual("Team 0 score at the win", GameState->GetTeamScore(0), GameState->WinningScore);
+	TestTrue("Game over at the winning score", GameState->GetIsGameOverNotified());
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Variant_Shooter/Tests/ShooterTestActors.h"
+#include "Variant_Shooter/Tests/ShooterTestWorld.h"
+#include "Variant_Shooter/ShooterStats.h"
+#include "HAL/IConsoleManager.h"
+
+namespace ShooterShotCostTest
+{
+	static int32 NumShots = 500;
+	static FAutoConsoleVariableRef CVarNumShots(
+		TEXT("Shooter.Test.ShotCostShots"),
+		NumShots,
+		TEXT("Number of hitscan shots fired by the shot cost automation test"));
+
+	static float MaxAverageUs = 100.0f;
+	static FAutoConsoleVariableRef CVarMaxAverageUs(
+		TEXT("Shooter.Test.ShotCostBudgetUs"),
+		MaxAverageUs,
+		TEXT("Average cost of an authoritative shot, in microseconds, above which the shot cost automation test fails"));
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FShooterShotCostTest, "FPSProject3.Shooter.Perf.ShotCost", SHOOTER_TEST_FLAGS)
+
+bool FShooterShotCostTest::RunTest(const FString& Parameters)
+{
+	FShooterTestWorld TestWorld;
+
+	AShooterTestWeaponHolder* Holder = TestWorld.Spawn<AShooterTestWeaponHolder>();
+	AShooterTestWeapon* Weapon = TestWorld.Spawn<AShooterTestWeapon>(FVector::ZeroVector, Holder, Holder);
+	AShooterTestDamageTarget* Target = TestWorld.Spawn<AShooterTestDamageTarget>(FVector(1000.0f, 0.0f, 0.0f));
+
+	// every shot goes through the full trace and damage path
+	Holder->TargetLocation = Target->GetActorLocation();
+
+	const int32 NumShots = FMath::Max(1, ShooterShotCostTest::NumShots);
+	Weapon->Configure(NumShots, 0.1f, true);
+
+	// measure only our shots, and leave the counter as it was for whoever else reads it
+	const FShooterCostCounter SavedShots = ShooterCost::Shots;
+	ShooterCost::Shots = FShooterCostCounter();
+
+	Weapon->StartFiring();
+
+	for (int32 Frame = 0; Frame < NumShots && Weapon->GetBulletCount() > 0; ++Frame)
+	{
+		Weapon->Tick(0.1f);
+	}
+
+	const FShooterCostCounter MeasuredShots = ShooterCost::Shots;
+	ShooterCost::Shots = SavedShots;
+
+	AddInfo(FString::Printf(TEXT("Shot cost: %d shots, %.2f us average, %.2f us max"), MeasuredShots.Count, MeasuredShots.GetAverageUs(), MeasuredShots.GetMaxUs()));
+
+	TestEqual("Recorded shots", MeasuredShots.Count, NumShots);
+	TestEqual("Target hits", Target->NumHits, NumShots);
+	TestTrue(FString::Printf(TEXT("Average shot cost under %.1f us"), ShooterShotCostTest::MaxAverageUs), MeasuredShots.GetAverageUs() <= ShooterShotCostTest::MaxAverageUs);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
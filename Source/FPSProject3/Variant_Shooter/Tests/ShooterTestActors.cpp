@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Variant_Shooter/Tests/ShooterTestActors.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/SceneComponent.h"
+
+AShooterTestWeaponHolder::AShooterTestWeaponHolder()
+{
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+}
+
+void AShooterTestWeaponHolder::AttachWeaponMeshes(AShooterWeapon* Weapon)
+{
+	// no meshes to attach to, keep the weapon on the holder so the muzzle follows it
+	Weapon->AttachToActor(this, FAttachmentTransformRules::SnapToTargetNotIncludingScale);
+}
+
+void AShooterTestWeaponHolder::UpdateWeaponHUD(int32 CurrentAmmo, int32 MagazineSize)
+{
+	++NumHUDUpdates;
+	LastHUDAmmo = CurrentAmmo;
+}
+
+void AShooterTestProjectile::SetExplosion(float Radius)
+{
+	bExplodeOnHit = true;
+	ExplosionRadius = Radius;
+	ExplosionDamageFalloff = 0.0f;
+	bExplosionChecksOcclusion = false;
+}
+
+void AShooterTestProjectile::SimulateHit(const FHitResult& Hit)
+{
+	NotifyHit(nullptr, Hit.GetActor(), Hit.GetComponent(), false, Hit.ImpactPoint, Hit.ImpactNormal, FVector::ZeroVector, Hit);
+}
+
+AShooterTestWeapon::AShooterTestWeapon()
+{
+	FireMode = EShooterWeaponFireMode::Hitscan;
+	ProjectileClass = AShooterTestProjectile::StaticClass();
+	MuzzleOffset = 0.0f;
+}
+
+void AShooterTestWeapon::Configure(int32 InMagazineSize, float InRefireRate, bool bInFullAuto, int32 InMaxShotsPerFrame)
+{
+	MagazineSize = InMagazineSize;
+	CurrentBullets = InMagazineSize;
+	RefireRate = InRefireRate;
+	bFullAuto = bInFullAuto;
+	MaxShotsPerFrame = InMaxShotsPerFrame;
+	RefireCooldown = 0.0f;
+}
+
+AShooterTestDamageTarget::AShooterTestDamageTarget()
+{
+	// block every trace channel so the hitscan shots find us
+	GetCapsuleComponent()->SetCollisionResponseToAllChannels(ECR_Block);
+}
+
+float AShooterTestDamageTarget::TakeDamage(float Damage, struct FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
+{
+	DamageTaken += Damage;
+	++NumHits;
+	LastDamageCauser = DamageCauser;
+
+	return Damage;
+}
@@ -0,0 +1,124 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/Character.h"
+#include "ShooterCharacter.h"
+#include "ShooterWeapon.h"
+#include "ShooterProjectile.h"
+#include "ShooterWeaponHolder.h"
+#include "ShooterTestActors.generated.h"
+
+/**
+ *  Minimal weapon holder for the automation tests
+ *  Aims at a fixed location and counts the weapon callbacks instead of driving meshes, animation and UI
+ */
+UCLASS(NotBlueprintable, NotPlaceable, HideDropdown)
+class FPSPROJECT3_API AShooterTestWeaponHolder : public APawn, public IShooterWeaponHolder
+{
+	GENERATED_BODY()
+
+public:
+
+	AShooterTestWeaponHolder();
+
+	/** Location the weapon fires at */
+	FVector TargetLocation = FVector(10000.0f, 0.0f, 0.0f);
+
+	/** Number of HUD updates received */
+	int32 NumHUDUpdates = 0;
+
+	/** Ammo passed with the last HUD update */
+	int32 LastHUDAmmo = INDEX_NONE;
+
+	/** Number of times a semi auto weapon reported it can fire again */
+	int32 NumSemiRefires = 0;
+
+	/** Number of hitscan impacts reported */
+	int32 NumHitscanImpacts = 0;
+
+	//~Begin IShooterWeaponHolder interface
+	virtual void AttachWeaponMeshes(AShooterWeapon* Weapon) override;
+	virtual void PlayFiringMontage(UAnimMontage* Montage) override {}
+	virtual void AddWeaponRecoil(float Recoil) override {}
+	virtual void UpdateWeaponHUD(int32 CurrentAmmo, int32 MagazineSize) override;
+	virtual FVector GetWeaponTargetLocation() override { return TargetLocation; }
+	virtual void AddWeaponClass(const TSubclassOf<AShooterWeapon>& WeaponClass) override {}
+	virtual void OnWeaponActivated(AShooterWeapon* Weapon) override {}
+	virtual void OnWeaponDeactivated(AShooterWeapon* Weapon) override {}
+	virtual void OnSemiWeaponRefire() override { ++NumSemiRefires; }
+	virtual void NotifyHitscanImpact(const FVector& TraceStart, const FVector& ImpactPoint, const FVector& ImpactNormal) override { ++NumHitscanImpacts; }
+	//~End IShooterWeaponHolder interface
+};
+
+/**
+ *  Projectile type used by the test weapons. Exposes its damage settings and hit handling to the tests
+ */
+UCLASS(NotBlueprintable, NotPlaceable, HideDropdown)
+class FPSPROJECT3_API AShooterTestProjectile : public AShooterProjectile
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Returns the damage of a direct hit */
+	float GetHitDamage() const { return HitDamage; }
+
+	/** Turns this projectile into an explosive one with full damage across the radius */
+	void SetExplosion(float Radius);
+
+	/** Runs the server hit handling as if the projectile had collided */
+	void SimulateHit(const FHitResult& Hit);
+};
+
+/**
+ *  Hitscan weapon with its fire cadence and magazine settable by the tests
+ */
+UCLASS(NotBlueprintable, NotPlaceable, HideDropdown)
+class FPSPROJECT3_API AShooterTestWeapon : public AShooterWeapon
+{
+	GENERATED_BODY()
+
+public:
+
+	AShooterTestWeapon();
+
+	/** Sets the fire cadence and refills a magazine of the given size */
+	void Configure(int32 InMagazineSize, float InRefireRate, bool bInFullAuto, int32 InMaxShotsPerFrame = 4);
+};
+
+/**
+ *  Character that records the damage it takes instead of dying
+ */
+UCLASS(NotBlueprintable, NotPlaceable, HideDropdown)
+class FPSPROJECT3_API AShooterTestDamageTarget : public ACharacter
+{
+	GENERATED_BODY()
+
+public:
+
+	AShooterTestDamageTarget();
+
+	/** Damage taken so far */
+	float DamageTaken = 0.0f;
+
+	/** Number of damage events received */
+	int32 NumHits = 0;
+
+	/** Causer of the last damage event */
+	TWeakObjectPtr<AActor> LastDamageCauser;
+
+	/** Records the damage */
+	virtual float TakeDamage(float Damage, struct FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser) override;
+};
+
+/**
+ *  Concrete shooter character for tests that need a real kill credit target
+ */
+UCLASS(NotBlueprintable, NotPlaceable, HideDropdown)
+class FPSPROJECT3_API AShooterTestCharacter : public AShooterCharacter
+{
+	GENERATED_BODY()
+};
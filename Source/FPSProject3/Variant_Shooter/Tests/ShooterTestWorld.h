@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+
+/** Flags shared by the shooter automation tests */
+#define SHOOTER_TEST_FLAGS (EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+/**
+ *  Empty game world that lives as long as the test holding it
+ *  The world subsystems are created and begun like in a match, but there is no game mode, so actors
+ *  are ticked by the test instead of the engine and the server is the standalone game itself
+ */
+struct FShooterTestWorld
+{
+	/** The test world */
+	UWorld* World = nullptr;
+
+	FShooterTestWorld()
+	{
+		World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("ShooterTestWorld"));
+
+		GEngine->CreateNewWorldContext(EWorldType::Game).SetCurrentWorld(World);
+
+		World->InitializeActorsForPlay(FURL());
+		World->BeginPlay();
+
+		// there's no game mode to start the match, so let the actors begin play as they spawn
+		World->GetWorldSettings()->NotifyBeginPlay();
+	}
+
+	~FShooterTestWorld()
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+	}
+
+	FShooterTestWorld(const FShooterTestWorld&) = delete;
+	FShooterTestWorld& operator=(const FShooterTestWorld&) = delete;
+
+	/** Spawns an actor at the location */
+	template<typename T>
+	T* Spawn(const FVector& Location = FVector::ZeroVector, AActor* Owner = nullptr, APawn* Instigator = nullptr)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.Owner = Owner;
+		SpawnParams.Instigator = Instigator;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		return World->SpawnActor<T>(T::StaticClass(), FTransform(Location), SpawnParams);
+	}
+};
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,159 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Variant_Shooter/Tests/ShooterTestActors.h"
+#include "Variant_Shooter/Tests/ShooterTestWorld.h"
+
+BEGIN_DEFINE_SPEC(FShooterWeaponSpec, "FPSProject3.Shooter.Weapon", SHOOTER_TEST_FLAGS)
+
+	TUniquePtr<FShooterTestWorld> TestWorld;
+	AShooterTestWeaponHolder* Holder = nullptr;
+	AShooterTestWeapon* Weapon = nullptr;
+
+END_DEFINE_SPEC(FShooterWeaponSpec)
+
+void FShooterWeaponSpec::Define()
+{
+	BeforeEach([this]()
+	{
+		TestWorld = MakeUnique<FShooterTestWorld>();
+
+		Holder = TestWorld->Spawn<AShooterTestWeaponHolder>();
+		Weapon = TestWorld->Spawn<AShooterTestWeapon>(FVector::ZeroVector, Holder, Holder);
+	});
+
+	AfterEach([this]()
+	{
+		Holder = nullptr;
+		Weapon = nullptr;
+		TestWorld.Reset();
+	});
+
+	Describe("Full auto", [this]()
+	{
+		BeforeEach([this]()
+		{
+			Weapon->Configure(10, 0.25f, true);
+		});
+
+		It("fires on the trigger, then once per refire interval", [this]()
+		{
+			Weapon->StartFiring();
+			TestEqual("Shots on the trigger pull", Weapon->GetShotSequence(), 1);
+
+			Weapon->Tick(0.125f);
+			TestEqual("Shots halfway through the cooldown", Weapon->GetShotSequence(), 1);
+
+			Weapon->Tick(0.125f);
+			TestEqual("Shots once the cooldown ran out", Weapon->GetShotSequence(), 2);
+
+			// a long frame fires every shot that came due in it
+			Weapon->Tick(0.75f);
+			TestEqual("Shots after a long frame", Weapon->GetShotSequence(), 5);
+			TestEqual("Bullets after a long frame", Weapon->GetBulletCount(), 5);
+		});
+
+		It("drops the shots over the per frame cap", [this]()
+		{
+			Weapon->StartFiring();
+			Weapon->Tick(2.0f);
+
+			TestEqual("Shots after a hitch", Weapon->GetShotSequence(), 5);
+
+			// the dropped shots don't carry over, the next frame only fires the shot that's due
+			Weapon->Tick(0.125f);
+			TestEqual("Shots in the frame after the hitch", Weapon->GetShotSequence(), 6);
+		});
+
+		It("stops when the magazine runs dry and fires again after a reload", [this]()
+		{
+			Weapon->StartFiring();
+
+			for (int32 Frame = 0; Frame < 20; ++Frame)
+			{
+				Weapon->Tick(0.25f);
+			}
+
+			TestEqual("Shots from a full magazine", Weapon->GetShotSequence(), 10);
+			TestEqual("Bullets left", Weapon->GetBulletCount(), 0);
+			TestEqual("HUD updates", Holder->NumHUDUpdates, 10);
+			TestEqual("Last HUD ammo", Holder->LastHUDAmmo, 0);
+
+			Weapon->StartFiring();
+			TestEqual("Shots with an empty magazine", Weapon->GetShotSequence(), 10);
+
+			Weapon->Reload();
+			TestEqual("Bullets after reloading", Weapon->GetBulletCount(), 10);
+			TestEqual("Last HUD ammo after reloading", Holder->LastHUDAmmo, 10);
+
+			Weapon->StartFiring();
+			TestEqual("Shots after reloading", Weapon->GetShotSequence(), 11);
+		});
+
+		It("stops when the trigger is released", [this]()
+		{
+			Weapon->StartFiring();
+			Weapon->Tick(0.25f);
+			Weapon->StopFiring();
+			Weapon->Tick(1.0f);
+
+			TestEqual("Shots", Weapon->GetShotSequence(), 2);
+			TestEqual("Bullets", Weapon->GetBulletCount(), 8);
+		});
+	});
+
+	Describe("Semi auto", [this]()
+	{
+		BeforeEach([this]()
+		{
+			Weapon->Configure(10, 0.5f, false);
+		});
+
+		It("fires once per trigger pull and tells the holder when it can fire again", [this]()
+		{
+			Weapon->StartFiring();
+			Weapon->Tick(0.25f);
+
+			TestEqual("Shots while holding the trigger", Weapon->GetShotSequence(), 1);
+			TestEqual("Refire notifications during the cooldown", Holder->NumSemiRefires, 0);
+
+			// pulling again during the cooldown doesn't fire
+			Weapon->StopFiring();
+			Weapon->StartFiring();
+			TestEqual("Shots when spamming the trigger", Weapon->GetShotSequence(), 1);
+
+			Weapon->Tick(0.25f);
+			TestEqual("Refire notifications after the cooldown", Holder->NumSemiRefires, 1);
+
+			Weapon->StopFiring();
+			Weapon->StartFiring();
+			TestEqual("Shots after the cooldown", Weapon->GetShotSequence(), 2);
+			TestEqual("Bullets", Weapon->GetBulletCount(), 8);
+		});
+	});
+
+	Describe("Hitscan", [this]()
+	{
+		It("damages the character it hits, with the weapon as the damage causer", [this]()
+		{
+			AShooterTestDamageTarget* Target = TestWorld->Spawn<AShooterTestDamageTarget>(FVector(1000.0f, 0.0f, 0.0f));
+			Holder->TargetLocation = Target->GetActorLocation();
+
+			Weapon->Configure(10, 0.25f, false);
+			Weapon->StartFiring();
+
+			const float HitDamage = GetDefault<AShooterTestProjectile>()->GetHitDamage();
+
+			TestEqual("Hits", Target->NumHits, 1);
+			TestEqual("Damage", Target->DamageTaken, HitDamage);
+			TestTrue("Damage causer is the weapon", Target->LastDamageCauser.Get() == Weapon);
+			TestEqual("Impacts sent to the holder", Holder->NumHitscanImpacts, 1);
+		});
+	});
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -8,58 +8,145 @@
 #include "ShooterWeaponHolder.h"
 #include "ShooterWeapon.h"
 #include "Engine/World.h"
-#include "TimerManager.h"
 #include "ShooterCharacter.h"
+#include "ShooterLog.h"
+#include "ShooterPickupPreloader.h"
+#include "ShooterPickupManager.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
 
 AShooterPickup::AShooterPickup()
 {
-	UE_LOG(LogTemp, Log, TEXT("拾取物触发：构造函数"));
- 	PrimaryActorTick.bCanEverTick = true;
+ 	// the pickup manager handles proximity and respawns for every pickup
+	PrimaryActorTick.bCanEverTick = false;
 
 	// create the root
 	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
 
-	// create the collision sphere
+	// create the pickup radius sphere. It only marks the radius, the pickup manager checks it against player positions
 	SphereCollision = CreateDefaultSubobject<USphereComponent>(TEXT("Sphere Collision"));
 	SphereCollision->SetupAttachment(RootComponent);
 
 	SphereCollision->SetRelativeLocation(FVector(0.0f, 0.0f, 84.0f));
-	SphereCollision->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
-	SphereCollision->SetCollisionObjectType(ECC_WorldStatic);
-	SphereCollision->SetCollisionResponseToAllChannels(ECR_Ignore);
-	SphereCollision->SetCollisionResponseToChannel(ECC_Pawn, ECR_Overlap);
-	SphereCollision->bFillCollisionUnderneathForNavmesh = true;
-
-	// subscribe to the collision overlap on the sphere
-	SphereCollision->OnComponentBeginOverlap.AddDynamic(this, &AShooterPickup::OnOverlap);
+	SphereCollision->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	SphereCollision->SetGenerateOverlapEvents(false);
 
 	// create the mesh
 	Mesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Mesh"));
 	Mesh->SetupAttachment(SphereCollision);
 
 	Mesh->SetCollisionProfileName(FName("NoCollision"));
+
+#if WITH_EDITORONLY_DATA
+	// create the editor preview mesh. Editor only components are left out of cooked levels
+	PreviewMesh = CreateEditorOnlyDefaultSubobject<UStaticMeshComponent>(TEXT("Preview Mesh"));
+
+	if (PreviewMesh)
+	{
+		PreviewMesh->SetupAttachment(SphereCollision);
+		PreviewMesh->SetCollisionProfileName(FName("NoCollision"));
+		PreviewMesh->bHiddenInGame = true;
+	}
+#endif
+
+	// pickups only send an update when they're taken or respawn, so keep them asleep the rest of the time
+	bReplicates = true;
+	NetDormancy = DORM_Initial;
 }
 
 void AShooterPickup::OnConstruction(const FTransform& Transform)
 {
 	Super::OnConstruction(Transform);
 
+#if WITH_EDITORONLY_DATA
+	// game worlds stream the mesh in through the preloader. Only load it here for the editor preview
+	if (!PreviewMesh || (GetWorld() && GetWorld()->IsGameWorld()))
+	{
+		return;
+	}
+
+	// levels saved before the preview had its own component kept the mesh on the runtime one
+	Mesh->SetStaticMesh(nullptr);
+
 	if (FWeaponTableRow* WeaponData = WeaponType.GetRow<FWeaponTableRow>(FString()))
 	{
-		// set the mesh
-		Mesh->SetStaticMesh(WeaponData->StaticMesh.LoadSynchronous());
+		// set the preview mesh
+		PreviewMesh->SetStaticMesh(WeaponData->StaticMesh.LoadSynchronous());
+	}
+#endif
+}
+
+void AShooterPickup::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	UWorld* World = GetWorld();
+
+	if (!World || !World->IsGameWorld())
+	{
+		return;
+	}
+
+	// stay hidden and out of reach until the weapon is ready to hand out
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+
+	if (UShooterPickupManager* PickupManager = World->GetSubsystem<UShooterPickupManager>())
+	{
+		PickupManager->RegisterPickup(this);
+	}
+
+	TArray<FSoftObjectPath> Assets;
+
+	if (FWeaponTableRow* WeaponData = WeaponType.GetRow<FWeaponTableRow>(FString()))
+	{
+		Assets.Add(WeaponData->WeaponToSpawn.ToSoftObjectPath());
+
+		// dedicated servers never draw the pickup
+		if (!IsRunningDedicatedServer())
+		{
+			Assets.Add(WeaponData->StaticMesh.ToSoftObjectPath());
+		}
+	}
+
+	if (UShooterPickupPreloader* Preloader = World->GetSubsystem<UShooterPickupPreloader>())
+	{
+		Preloader->RequestAssets(this, Assets);
+	}
+	else
+	{
+		OnAssetsLoaded();
 	}
 }
 
 void AShooterPickup::BeginPlay()
 {
 	Super::BeginPlay();
-	UE_LOG(LogTemp, Log, TEXT("拾取物触发：Beginplay"));
+	UE_LOG(LogShooterWeapon, Verbose, TEXT("拾取物触发：Beginplay"));
+}
 
+void AShooterPickup::OnAssetsLoaded()
+{
 	if (FWeaponTableRow* WeaponData = WeaponType.GetRow<FWeaponTableRow>(FString()))
 	{
 		// copy the weapon class
-		WeaponClass = WeaponData->WeaponToSpawn;
+		WeaponClass = WeaponData->WeaponToSpawn.Get();
+
+		// set the mesh
+		Mesh->SetStaticMesh(WeaponData->StaticMesh.Get());
+	}
+
+	bAssetsLoaded = true;
+
+	// show the pickup right away if it's up, otherwise keep following the replicated availability
+	if (bIsAvailable)
+	{
+		SetActorHiddenInGame(false);
+		FinishRespawn();
+	}
+	else
+	{
+		OnRep_IsAvailable();
 	}
 }
 
@@ -67,62 +154,98 @@ void AShooterPickup::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
 	Super::EndPlay(EndPlayReason);
 
-	// clear the respawn timer
-	GetWorld()->GetTimerManager().ClearTimer(RespawnTimer);
+	if (UShooterPickupManager* PickupManager = GetWorld()->GetSubsystem<UShooterPickupManager>())
+	{
+		PickupManager->UnregisterPickup(PickupIndex);
+	}
 }
 
-void AShooterPickup::OnOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
+void AShooterPickup::HandlePlayerReached(AShooterCharacter* PlayerCharacter)
 {
 	//Server Only
-	if (GetLocalRole() != ROLE_Authority)
+	if (GetLocalRole() != ROLE_Authority || !PlayerCharacter)
 	{
 		return;
 	}
-	// 检测重叠对象是否为玩家角色
-	AShooterCharacter* PlayerCharacter = Cast<AShooterCharacter>(OtherActor);
-	if (!PlayerCharacter)
+	// the weapon inventory replicates to the clients, local and remote players are handled the same
+	GivePickupToHolder(PlayerCharacter);
+}
+
+void AShooterPickup::GivePickupToHolder(IShooterWeaponHolder* WeaponHolder)
+{
+	// server only, clients receive the weapon through the holder's replicated inventory
+	if (!HasAuthority())
 	{
-		return; // 非玩家角色不处理
+		return;
 	}
-	// 获取玩家控制器，区分服务端玩家和客户端玩家
-	APlayerController* PlayerController = PlayerCharacter->GetController<APlayerController>();
-	if (!PlayerController)
+
+	if (!WeaponClass)
 	{
+		UE_LOG(LogShooterWeapon, Warning, TEXT("GivePickupToHolder - %s has no weapon class loaded"), *GetName());
 		return;
 	}
-	if (PlayerController->IsLocalController())
+
+	WeaponHolder -> AddWeaponClass(WeaponClass);
+
+	// hide the pickup and schedule the respawn
+	if (UShooterPickupManager* PickupManager = GetWorld()->GetSubsystem<UShooterPickupManager>())
 	{
-		GivePickupToHolder(PlayerCharacter);
-	}
-	else {
-		PlayerCharacter->ServerNotifyPickUpWeapon(this); // 服务端触发多播
+		PickupManager->OnPickupTaken(PickupIndex);
 	}
 }
 
-void AShooterPickup::GivePickupToHolder(IShooterWeaponHolder* WeaponHolder)
+void AShooterPickup::SetAvailable(bool bAvailable)
 {
-	WeaponHolder -> AddWeaponClass(WeaponClass);
+	bIsAvailable = bAvailable;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShooterPickup, bIsAvailable, this);
 
-	// hide this mesh
-	SetActorHiddenInGame(true);
+	// wake the pickup for a single update. Flushing an initially dormant actor leaves it dormant afterwards
+	FlushNetDormancy();
 
-	// disable collision
-	SetActorEnableCollision(false);
+	OnRep_IsAvailable();
+}
 
-	// disable ticking
-	SetActorTickEnabled(false);
+void AShooterPickup::ApplyAvailability(bool bAvailable)
+{
+	bIsAvailable = bAvailable;
 
-	// schedule the respawn
-	GetWorld()->GetTimerManager().SetTimer(RespawnTimer, this, &AShooterPickup::RespawnPickup, RespawnTime, false);
+	OnRep_IsAvailable();
 }
 
-void AShooterPickup::RespawnPickup()
+FVector AShooterPickup::GetPickupLocation() const
 {
-	// unhide this pickup
-	SetActorHiddenInGame(false);
+	return SphereCollision->GetComponentLocation();
+}
 
-	// call the BP handler
-	BP_OnRespawn();
+float AShooterPickup::GetPickupRadius() const
+{
+	return SphereCollision->GetScaledSphereRadius();
+}
+
+void AShooterPickup::OnRep_IsAvailable()
+{
+	// the pickup shows up once its assets land
+	if (!bAssetsLoaded)
+	{
+		return;
+	}
+
+	if (bIsAvailable)
+	{
+		// unhide this pickup
+		SetActorHiddenInGame(false);
+
+		// call the BP handler
+		BP_OnRespawn();
+	}
+	else
+	{
+		// hide this mesh
+		SetActorHiddenInGame(true);
+
+		// disable collision
+		SetActorEnableCollision(false);
+	}
 }
 
 void AShooterPickup::FinishRespawn()
@@ -130,6 +253,22 @@ void AShooterPickup::FinishRespawn()
 	// enable collision
 	SetActorEnableCollision(true);
 
-	// enable tick
-	SetActorTickEnabled(true);
+	// let players collect it again
+	if (HasAuthority())
+	{
+		if (UShooterPickupManager* PickupManager = GetWorld()->GetSubsystem<UShooterPickupManager>())
+		{
+			PickupManager->OnPickupRespawnFinished(PickupIndex);
+		}
+	}
+}
+
+void AShooterPickup::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams SharedParams;
+	SharedParams.bIsPushBased = true;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShooterPickup, bIsAvailable, SharedParams);
 }
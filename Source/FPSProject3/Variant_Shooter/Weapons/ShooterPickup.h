@@ -12,6 +12,7 @@
 class USphereComponent;
 class UPrimitiveComponent;
 class AShooterWeapon;
+class AShooterCharacter;
 
 /**
  *  Holds information about a type of weapon pickup
@@ -25,26 +26,33 @@ struct FWeaponTableRow : public FTableRowBase
 	UPROPERTY(EditAnywhere)
 	TSoftObjectPtr<UStaticMesh> StaticMesh;
 
-	/** Weapon class to grant on pickup */
+	/** Weapon class to grant on pickup. Streamed in by the pickup preloader */
 	UPROPERTY(EditAnywhere)
-	TSubclassOf<AShooterWeapon> WeaponToSpawn;
+	TSoftClassPtr<AShooterWeapon> WeaponToSpawn;
 };
 
 /**
  *  Simple shooter game weapon pickup
+ *  Proximity checks and respawns are run by the pickup manager, so pickups don't tick or overlap
  */
 UCLASS(abstract)
 class FPSPROJECT3_API AShooterPickup : public AActor
 {
 	GENERATED_BODY()
 
-	/** Collision sphere */
+	/** Pickup radius. Players within it collect the pickup */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Components", meta = (AllowPrivateAccess = "true"))
 	USphereComponent* SphereCollision;
 
 	/** Weapon pickup mesh. Its mesh asset is set from the weapon data table */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Components", meta = (AllowPrivateAccess = "true"))
 	UStaticMeshComponent* Mesh;
+
+#if WITH_EDITORONLY_DATA
+	/** Mesh shown while placing the pickup in the editor. Editor only, so cooked levels don't load the weapon mesh with the map */
+	UPROPERTY()
+	UStaticMeshComponent* PreviewMesh;
+#endif
 	
 protected:
 
@@ -59,8 +67,15 @@ protected:
 	UPROPERTY(EditAnywhere, Category="Pickup", meta = (ClampMin = 0, ClampMax = 120, Units = "s"))
 	float RespawnTime = 4.0f;
 
-	/** Timer to respawn the pickup */
-	FTimerHandle RespawnTimer;
+	/** Index of this pickup in the pickup manager */
+	int32 PickupIndex = INDEX_NONE;
+
+	/** If false, the pickup has been taken and is waiting to respawn */
+	UPROPERTY(ReplicatedUsing = OnRep_IsAvailable)
+	bool bIsAvailable = true;
+
+	/** True once the weapon class and mesh have been streamed in. The pickup stays hidden until then */
+	bool bAssetsLoaded = false;
 
 public:	
 	
@@ -72,20 +87,20 @@ protected:
 	/** Native construction script */
 	virtual void OnConstruction(const FTransform& Transform) override;
 
+	/** Queues the weapon assets with the preloader */
+	virtual void PostInitializeComponents() override;
+
 	/** Gameplay Initialization*/
 	virtual void BeginPlay() override;
 
 	/** Gameplay cleanup */
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
-	/** Handles collision overlap */
-	UFUNCTION()
-	virtual void OnOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
-
 protected:
 
-	/** Called when it's time to respawn this pickup */
-	void RespawnPickup();
+	/** Shows or hides the pickup to match its availability */
+	UFUNCTION()
+	void OnRep_IsAvailable();
 
 	/** Passes control to Blueprint to animate the pickup respawn. Should end by calling FinishRespawn */
 	UFUNCTION(BlueprintImplementableEvent, Category="Pickup", meta = (DisplayName = "OnRespawn"))
@@ -95,6 +110,34 @@ protected:
 	UFUNCTION(BlueprintCallable, Category="Pickup")
 	void FinishRespawn();
 public:
+
+	/** Registers replicated properties */
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
 	/** FWD decleration*/
 	void GivePickupToHolder(IShooterWeaponHolder* WeaponHolder);
+
+	/** Called by the preloader once the weapon class and mesh are resident */
+	void OnAssetsLoaded();
+
+	/** Server: gives the weapon to a player that walked into the pickup. Called by the pickup manager */
+	void HandlePlayerReached(AShooterCharacter* PlayerCharacter);
+
+	/** Server: changes availability and sends it to clients through the pickup actor */
+	void SetAvailable(bool bAvailable);
+
+	/** Changes availability locally. Used for pickups replicated through the game state */
+	void ApplyAvailability(bool bAvailable);
+
+	/** Sets the index assigned by the pickup manager */
+	void SetPickupIndex(int32 InPickupIndex) { PickupIndex = InPickupIndex; }
+
+	/** Returns the center of the pickup radius */
+	FVector GetPickupLocation() const;
+
+	/** Returns the pickup radius */
+	float GetPickupRadius() const;
+
+	/** Returns the time to wait before respawning this pickup */
+	float GetRespawnTime() const { return RespawnTime; }
 };
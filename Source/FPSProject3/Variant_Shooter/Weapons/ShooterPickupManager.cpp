@@ -0,0 +1,301 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterPickupManager.h"
+#include "ShooterPickup.h"
+#include "ShooterCharacter.h"
+#include "Variant_Shooter/ShooterGameState.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "ShooterLog.h"
+
+bool UShooterPickupManager::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UShooterPickupManager::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	TimingWheel.SetNum(WheelSize);
+}
+
+void UShooterPickupManager::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// clients only follow the replicated availability
+	if (GetWorld()->GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	ProximityAccumulator += DeltaTime;
+
+	if (ProximityAccumulator >= ProximityInterval)
+	{
+		ProximityAccumulator = 0.0f;
+		CheckProximity();
+	}
+
+	AdvanceTimingWheel(DeltaTime);
+}
+
+TStatId UShooterPickupManager::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterPickupManager, STATGROUP_Tickables);
+}
+
+int32 UShooterPickupManager::RegisterPickup(AShooterPickup* Pickup)
+{
+	if (!Pickup)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 PickupIndex = Pickups.Add(Pickup);
+
+	Locations.Add(Pickup->GetPickupLocation());
+	Radii.Add(Pickup->GetPickupRadius());
+	Collectible.Add(false);
+
+	Pickup->SetPickupIndex(PickupIndex);
+
+	uint32 PickupId = GetStablePickupId(Pickup);
+
+	if (PickupId != 0 && PickupIndicesById.Contains(PickupId))
+	{
+		UE_LOG(LogShooterWeapon, Warning, TEXT("PickupManager - %s shares its id with another pickup, it replicates its own availability"), *Pickup->GetName());
+		PickupId = 0;
+	}
+
+	PickupIds.Add(PickupId);
+
+	if (PickupId != 0)
+	{
+		PickupIndicesById.Add(PickupId, PickupIndex);
+
+		// a pickup streaming in on a client picks up the state the game state already has for it
+		const AShooterGameState* GameState = GetWorld()->GetGameState<AShooterGameState>();
+
+		if (GetWorld()->GetNetMode() == NM_Client && GameState && !GameState->IsPickupAvailable(PickupId))
+		{
+			ReplicatedUnavailable.Add(PickupId);
+			Pickup->ApplyAvailability(false);
+		}
+	}
+
+	return PickupIndex;
+}
+
+void UShooterPickupManager::UnregisterPickup(int32 PickupIndex)
+{
+	if (!Pickups.IsValidIndex(PickupIndex))
+	{
+		return;
+	}
+
+	// leave the slot empty. Removing it would shift the indices the other pickups hold
+	Pickups[PickupIndex].Reset();
+	Collectible[PickupIndex] = false;
+
+	const uint32 PickupId = PickupIds[PickupIndex];
+
+	if (PickupId == 0)
+	{
+		return;
+	}
+
+	PickupIds[PickupIndex] = 0;
+	PickupIndicesById.Remove(PickupId);
+
+	if (GetWorld()->GetNetMode() == NM_Client)
+	{
+		ReplicatedUnavailable.Remove(PickupId);
+
+	} else if (AShooterGameState* GameState = GetWorld()->GetGameState<AShooterGameState>()) {
+
+		// its respawn is dropped with it, so don't leave it listed as taken if its level streams back in
+		GameState->SetPickupAvailable(PickupId, true);
+	}
+}
+
+void UShooterPickupManager::OnPickupTaken(int32 PickupIndex)
+{
+	if (!Pickups.IsValidIndex(PickupIndex) || !Pickups[PickupIndex].IsValid())
+	{
+		return;
+	}
+
+	Collectible[PickupIndex] = false;
+	SetAvailable(PickupIndex, false);
+
+	ScheduleRespawn(PickupIndex, Pickups[PickupIndex]->GetRespawnTime());
+}
+
+void UShooterPickupManager::OnPickupRespawnFinished(int32 PickupIndex)
+{
+	if (Pickups.IsValidIndex(PickupIndex) && Pickups[PickupIndex].IsValid())
+	{
+		Collectible[PickupIndex] = true;
+	}
+}
+
+void UShooterPickupManager::OnPickupAvailabilityReplicated(const AShooterGameState* GameState)
+{
+	if (!GameState)
+	{
+		return;
+	}
+
+	TSet<uint32> Unavailable(GameState->GetUnavailablePickups());
+
+	// pickups that respawned since the last update
+	for (const uint32 PickupId : ReplicatedUnavailable)
+	{
+		if (!Unavailable.Contains(PickupId))
+		{
+			ApplyReplicatedAvailability(PickupId, true);
+		}
+	}
+
+	// pickups that were taken since the last update
+	for (const uint32 PickupId : Unavailable)
+	{
+		if (!ReplicatedUnavailable.Contains(PickupId))
+		{
+			ApplyReplicatedAvailability(PickupId, false);
+		}
+	}
+
+	ReplicatedUnavailable = MoveTemp(Unavailable);
+}
+
+void UShooterPickupManager::ApplyReplicatedAvailability(uint32 PickupId, bool bAvailable)
+{
+	// pickups in levels that haven't streamed in here yet read the game state when they register
+	const int32* PickupIndex = PickupIndicesById.Find(PickupId);
+
+	if (AShooterPickup* Pickup = PickupIndex ? Pickups[*PickupIndex].Get() : nullptr)
+	{
+		Pickup->ApplyAvailability(bAvailable);
+	}
+}
+
+uint32 UShooterPickupManager::GetStablePickupId(const AShooterPickup* Pickup)
+{
+	if (!Pickup || !Pickup->IsNameStableForNetworking())
+	{
+		return 0;
+	}
+
+	// level package and actor name, without the PIE prefix that differs between the server and clients
+	const FString StableName = UWorld::RemovePIEPrefix(Pickup->GetLevel()->GetOutermost()->GetName()) + TEXT(".") + Pickup->GetName();
+	const uint32 PickupId = FCrc::StrCrc32(*StableName);
+
+	// 0 means no id
+	return PickupId != 0 ? PickupId : 1;
+}
+
+void UShooterPickupManager::CheckProximity()
+{
+	// gather the players that can pick things up
+	TArray<TPair<AShooterCharacter*, FVector>, TInlineAllocator<16>> Players;
+
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		AShooterCharacter* Character = It->IsValid() ? Cast<AShooterCharacter>((*It)->GetPawn()) : nullptr;
+
+		if (Character && !Character->IsDead())
+		{
+			Players.Emplace(Character, Character->GetActorLocation());
+		}
+	}
+
+	if (Players.Num() == 0)
+	{
+		return;
+	}
+
+	// walk the collectible pickups only
+	for (TConstSetBitIterator<> It(Collectible); It; ++It)
+	{
+		const int32 PickupIndex = It.GetIndex();
+
+		for (const TPair<AShooterCharacter*, FVector>& Player : Players)
+		{
+			const float ReachRadius = Radii[PickupIndex] + Player.Key->GetCapsuleComponent()->GetScaledCapsuleRadius();
+
+			if (FVector::DistSquared(Locations[PickupIndex], Player.Value) > FMath::Square(ReachRadius))
+			{
+				continue;
+			}
+
+			if (AShooterPickup* Pickup = Pickups[PickupIndex].Get())
+			{
+				Pickup->HandlePlayerReached(Player.Key);
+			}
+
+			break;
+		}
+	}
+}
+
+void UShooterPickupManager::AdvanceTimingWheel(float DeltaTime)
+{
+	WheelAccumulator += DeltaTime;
+
+	while (WheelAccumulator >= WheelResolution)
+	{
+		WheelAccumulator -= WheelResolution;
+		WheelCursor = (WheelCursor + 1) % WheelSize;
+
+		// respawn everything due in this slot
+		TArray<int32> DuePickups = MoveTemp(TimingWheel[WheelCursor]);
+		TimingWheel[WheelCursor].Reset();
+
+		for (const int32 PickupIndex : DuePickups)
+		{
+			if (Pickups.IsValidIndex(PickupIndex) && Pickups[PickupIndex].IsValid())
+			{
+				SetAvailable(PickupIndex, true);
+			}
+		}
+	}
+}
+
+void UShooterPickupManager::ScheduleRespawn(int32 PickupIndex, float Delay)
+{
+	// round up so a pickup never respawns early. Delays past the end of the wheel are clamped to its length
+	const int32 NumSlots = FMath::Clamp(FMath::CeilToInt((Delay + WheelAccumulator) / WheelResolution), 1, WheelSize - 1);
+
+	TimingWheel[(WheelCursor + NumSlots) % WheelSize].Add(PickupIndex);
+}
+
+void UShooterPickupManager::SetAvailable(int32 PickupIndex, bool bAvailable)
+{
+	AShooterPickup* Pickup = Pickups[PickupIndex].Get();
+
+	if (!Pickup)
+	{
+		return;
+	}
+
+	if (IsReplicatedPickup(PickupIndex))
+	{
+		// one id on the game state instead of waking the pickup actor
+		if (AShooterGameState* GameState = GetWorld()->GetGameState<AShooterGameState>())
+		{
+			GameState->SetPickupAvailable(PickupIds[PickupIndex], bAvailable);
+		}
+
+		Pickup->ApplyAvailability(bAvailable);
+
+	} else {
+
+		Pickup->SetAvailable(bAvailable);
+	}
+}
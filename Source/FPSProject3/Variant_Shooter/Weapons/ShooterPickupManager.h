@@ -0,0 +1,117 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterPickupManager.generated.h"
+
+class AShooterPickup;
+class AShooterGameState;
+
+/**
+ *  Runs every weapon pickup in the world from flat arrays instead of per pickup ticks, overlaps and timers
+ *  The server checks player positions against the pickups on a throttled cadence and drives respawns
+ *  from a single timing wheel. Pickups placed in a level replicate the ids of the taken ones through the
+ *  game state. The ids come from the pickup's level and actor name, so they match on the server and clients
+ *  no matter in which order levels stream in. Pickups without a stable name fall back to replicating their own availability
+ */
+UCLASS()
+class FPSPROJECT3_API UShooterPickupManager : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	/** Registered pickups. Slots of unregistered pickups are left empty so indices stay put. Indices are local to this machine */
+	TArray<TWeakObjectPtr<AShooterPickup>> Pickups;
+
+	/** Stable id of each pickup, shared by the server and clients. 0 for pickups that replicate their own availability */
+	TArray<uint32> PickupIds;
+
+	/** Pickup index by stable id */
+	TMap<uint32, int32> PickupIndicesById;
+
+	/** Pickup locations */
+	TArray<FVector> Locations;
+
+	/** Pickup radii */
+	TArray<float> Radii;
+
+	/** Pickups that can be collected right now. Server only */
+	TBitArray<> Collectible;
+
+	/** Ids of the pickups that were unavailable as of the last replicated update, used to find the ones that flipped. Clients only */
+	TSet<uint32> ReplicatedUnavailable;
+
+	/** Pickups to respawn, bucketed by the wheel slot they're due in. Server only */
+	TArray<TArray<int32>> TimingWheel;
+
+	/** Wheel slot for the current time */
+	int32 WheelCursor = 0;
+
+	/** Time not yet consumed by the wheel */
+	float WheelAccumulator = 0.0f;
+
+	/** Time since the last proximity check */
+	float ProximityAccumulator = 0.0f;
+
+	/** Time covered by each wheel slot */
+	float WheelResolution = 0.25f;
+
+	/** Number of wheel slots. Covers delays up to WheelResolution * WheelSize */
+	int32 WheelSize = 512;
+
+	/** Time between proximity checks */
+	float ProximityInterval = 0.1f;
+
+public:
+
+	/** Only run in game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Sets up the timing wheel */
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	/** Checks proximity and advances the timing wheel */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Returns the stat id for this tickable */
+	virtual TStatId GetStatId() const override;
+
+	/** Starts managing a pickup. Returns its index */
+	int32 RegisterPickup(AShooterPickup* Pickup);
+
+	/** Stops managing a pickup */
+	void UnregisterPickup(int32 PickupIndex);
+
+	/** Server: takes the pickup away and schedules its respawn */
+	void OnPickupTaken(int32 PickupIndex);
+
+	/** Server: lets players collect the pickup again once its respawn has finished playing */
+	void OnPickupRespawnFinished(int32 PickupIndex);
+
+	/** Applies the availability changes replicated through the game state */
+	void OnPickupAvailabilityReplicated(const AShooterGameState* GameState);
+
+	/** Returns true if the pickup's availability goes through the game state */
+	bool IsReplicatedPickup(int32 PickupIndex) const { return PickupIds.IsValidIndex(PickupIndex) && PickupIds[PickupIndex] != 0; }
+
+protected:
+
+	/** Hands out the pickups players are standing in */
+	void CheckProximity();
+
+	/** Moves the wheel forward, respawning the pickups that came due */
+	void AdvanceTimingWheel(float DeltaTime);
+
+	/** Queues a pickup on the wheel */
+	void ScheduleRespawn(int32 PickupIndex, float Delay);
+
+	/** Server: changes availability on the game state or the pickup itself */
+	void SetAvailable(int32 PickupIndex, bool bAvailable);
+
+	/** Client: changes the availability of the pickup with the stable id, if it's loaded here */
+	void ApplyReplicatedAvailability(uint32 PickupId, bool bAvailable);
+
+	/** Returns an id for the pickup that is the same on the server and clients, or 0 if its name isn't stable */
+	static uint32 GetStablePickupId(const AShooterPickup* Pickup);
+};
@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterPickupPreloader.h"
+#include "ShooterPickup.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
+#include "Engine/World.h"
+#include "TimerManager.h"
+#include "ShooterLog.h"
+
+bool UShooterPickupPreloader::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UShooterPickupPreloader::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	bHasBegunPlay = true;
+
+	// placed pickups registered while the level initialized. Send them out together
+	FlushRequests();
+}
+
+void UShooterPickupPreloader::Deinitialize()
+{
+	for (const TSharedPtr<FStreamableHandle>& Handle : LoadHandles)
+	{
+		if (Handle.IsValid())
+		{
+			Handle->CancelHandle();
+		}
+	}
+
+	LoadHandles.Empty();
+	PendingPickups.Empty();
+	PendingAssets.Empty();
+
+	Super::Deinitialize();
+}
+
+void UShooterPickupPreloader::RequestAssets(AShooterPickup* Pickup, const TArray<FSoftObjectPath>& Assets)
+{
+	if (!Pickup)
+	{
+		return;
+	}
+
+	PendingPickups.Add(Pickup);
+
+	for (const FSoftObjectPath& Asset : Assets)
+	{
+		if (!Asset.IsNull())
+		{
+			PendingAssets.AddUnique(Asset);
+		}
+	}
+
+	// before BeginPlay everything waits for the level batch, afterwards batch once per frame
+	if (bHasBegunPlay && !bFlushScheduled)
+	{
+		bFlushScheduled = true;
+
+		GetWorld()->GetTimerManager().SetTimerForNextTick(FTimerDelegate::CreateUObject(this, &UShooterPickupPreloader::FlushRequests));
+	}
+}
+
+void UShooterPickupPreloader::FlushRequests()
+{
+	bFlushScheduled = false;
+
+	if (PendingPickups.Num() == 0)
+	{
+		return;
+	}
+
+	TArray<TWeakObjectPtr<AShooterPickup>> Pickups = MoveTemp(PendingPickups);
+	TArray<FSoftObjectPath> Assets = MoveTemp(PendingAssets);
+
+	PendingPickups.Reset();
+	PendingAssets.Reset();
+
+	UE_LOG(LogShooterWeapon, Log, TEXT("PickupPreloader - Streaming %d assets for %d pickups"), Assets.Num(), Pickups.Num());
+
+	const double RequestTime = FPlatformTime::Seconds();
+
+	FStreamableDelegate OnLoaded = FStreamableDelegate::CreateWeakLambda(this, [Pickups, RequestTime]()
+	{
+		UE_LOG(LogShooterWeapon, Log, TEXT("PickupPreloader - Batch of %d pickups loaded in %.1fms"), Pickups.Num(), (FPlatformTime::Seconds() - RequestTime) * 1000.0);
+
+		for (const TWeakObjectPtr<AShooterPickup>& Pickup : Pickups)
+		{
+			if (Pickup.IsValid())
+			{
+				Pickup->OnAssetsLoaded();
+			}
+		}
+	});
+
+	// nothing to stream, e.g. pickups without a weapon row
+	if (Assets.Num() == 0)
+	{
+		OnLoaded.Execute();
+		return;
+	}
+
+	// already resident assets complete the handle straight away
+	TSharedPtr<FStreamableHandle> Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(Assets, MoveTemp(OnLoaded), FStreamableManager::AsyncLoadHighPriority);
+
+	if (Handle.IsValid())
+	{
+		LoadHandles.Add(Handle);
+	}
+}
@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/SoftObjectPath.h"
+#include "ShooterPickupPreloader.generated.h"
+
+class AShooterPickup;
+struct FStreamableHandle;
+
+/**
+ *  Streams in the weapon classes and meshes referenced by pickups
+ *  Pickups register their assets while the level initializes, and everything requested before
+ *  gameplay starts goes out as a single batched async load instead of one blocking load per pickup.
+ *  Pickups from streamed in levels or spawned later are batched once per frame
+ */
+UCLASS()
+class FPSPROJECT3_API UShooterPickupPreloader : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+	/** Pickups waiting for the next batch */
+	TArray<TWeakObjectPtr<AShooterPickup>> PendingPickups;
+
+	/** Assets requested by the pending pickups */
+	TArray<FSoftObjectPath> PendingAssets;
+
+	/** Handles of the issued loads. Keep the assets resident for the lifetime of the world */
+	TArray<TSharedPtr<FStreamableHandle>> LoadHandles;
+
+	/** True once gameplay has started and requests are batched per frame */
+	bool bHasBegunPlay = false;
+
+	/** True while a batch is scheduled for the next tick */
+	bool bFlushScheduled = false;
+
+public:
+
+	/** Only stream assets in game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Sends out everything the level's pickups asked for */
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	/** Releases the loaded assets */
+	virtual void Deinitialize() override;
+
+	/** Queues the pickup's assets. The pickup is notified through OnAssetsLoaded once they're all resident */
+	void RequestAssets(AShooterPickup* Pickup, const TArray<FSoftObjectPath>& Assets);
+
+protected:
+
+	/** Issues one async load for every pending request */
+	void FlushRequests();
+};
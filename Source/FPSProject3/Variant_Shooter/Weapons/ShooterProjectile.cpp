@@ -13,6 +13,10 @@
 #include "Engine/World.h"
 #include "TimerManager.h"
 #include "Variant_Shooter/Weapons/ShooterWeapon.h"
+#include "ShooterProjectilePool.h"
+#include "ShooterDamageQuery.h"
+#include "ShooterLog.h"
+#include "ShooterStats.h"
 
 AShooterProjectile::AShooterProjectile()
 {
@@ -47,17 +51,29 @@ AShooterProjectile::AShooterProjectile()
 void AShooterProjectile::BeginPlay()
 {
 	Super::BeginPlay();
+
+	INC_DWORD_STAT(STAT_ShooterLiveProjectiles);
+
 	bool bIsServerAuthority = (GetLocalRole() == ROLE_Authority);
 	/*UE_LOG(LogActor, Log, TEXT("Bullet spawned - Real Authority: %d, Net Role: %d"),
 		bIsServerAuthority, (int)GetLocalRole());*/
 	// ignore the pawn that shot this projectile
 	CollisionComponent->IgnoreActorWhenMoving(GetInstigator(), true);
+
+	// save the collision mode so it can be restored if this projectile is pooled
+	ActiveCollisionEnabled = CollisionComponent->GetCollisionEnabled();
 }
 
 void AShooterProjectile::EndPlay(EEndPlayReason::Type EndPlayReason)
 {
 	Super::EndPlay(EndPlayReason);
 
+	// pooled projectiles were already counted out when they were released
+	if (!bInPool)
+	{
+		DEC_DWORD_STAT(STAT_ShooterLiveProjectiles);
+	}
+
 	// clear the destruction timer
 	GetWorld()->GetTimerManager().ClearTimer(DestructionTimer);
 }
@@ -70,6 +86,9 @@ void AShooterProjectile::NotifyHit(class UPrimitiveComponent* MyComp, AActor* Ot
 	{
 		return;
 	}
+
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_ShooterProjectileHit);
+
 	// ignore if we've already hit something else
 	if (bHit)
 	{
@@ -98,7 +117,7 @@ void AShooterProjectile::NotifyHit(class UPrimitiveComponent* MyComp, AActor* Ot
 	}
 
 	// pass control to BP for any extra effects
-	UE_LOG(LogTemp, Warning, TEXT("Call Multicast OnHitRegistered"));
+	UE_LOG(LogShooterProjectile, Verbose, TEXT("Call Multicast OnHitRegistered"));
 	Multicast_OnHitRegistered(Hit);
 
 	// check if we should schedule deferred destruction of the projectile
@@ -108,21 +127,55 @@ void AShooterProjectile::NotifyHit(class UPrimitiveComponent* MyComp, AActor* Ot
 
 	} else {
 
-		// destroy the projectile right away
-		Destroy();
+		// recycle the projectile right away
+		Recycle();
 	}
 }
 
 void AShooterProjectile::ExplosionCheck(const FVector& ExplosionCenter)
 {
-	// do a sphere overlap check look for nearby actors to damage
+	// damage and impulses are applied by the server only
+	if (GetLocalRole() != ROLE_Authority)
+	{
+		return;
+	}
+
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_ShooterProjectileExplosion);
+
+	// ensure we only affect each actor once
+	TSet<AActor*, DefaultKeyFuncs<AActor*>, TInlineSetAllocator<16>> DamagedActors;
+
+	// characters come from the damage query grid, with falloff and occlusion resolved in the same pass
+	if (UShooterDamageQuery* DamageQuery = GetWorld()->GetSubsystem<UShooterDamageQuery>())
+	{
+		FShooterRadialQueryParams RadialParams;
+		RadialParams.FalloffExponent = ExplosionDamageFalloff;
+		RadialParams.bCheckOcclusion = bExplosionChecksOcclusion;
+		RadialParams.IgnoredActors.Add(this);
+
+		if (!bDamageOwner)
+		{
+			RadialParams.IgnoredActors.Add(GetInstigator());
+		}
+
+		TArray<FShooterRadialQueryResult> Results;
+		DamageQuery->QueryRadius(ExplosionCenter, ExplosionRadius, RadialParams, Results);
+
+		for (const FShooterRadialQueryResult& Result : Results)
+		{
+			DamagedActors.Add(Result.Actor);
+
+			ApplyHitDamage(Result.Actor, Result.Component, ExplosionCenter, Result.Direction, GetOwner(), GetInstigator(), this, Result.DamageScale);
+		}
+	}
+
+	// physics objects aren't tracked by the grid, so overlap for those only
 	TArray<FOverlapResult> Overlaps;
 
 	FCollisionShape OverlapShape;
 	OverlapShape.SetSphere(ExplosionRadius);
 
 	FCollisionObjectQueryParams ObjectParams;
-	ObjectParams.AddObjectTypesToQuery(ECC_Pawn);
 	ObjectParams.AddObjectTypesToQuery(ECC_WorldDynamic);
 	ObjectParams.AddObjectTypesToQuery(ECC_PhysicsBody);
 
@@ -135,53 +188,78 @@ void AShooterProjectile::ExplosionCheck(const FVector& ExplosionCenter)
 
 	GetWorld()->OverlapMultiByObjectType(Overlaps, ExplosionCenter, FQuat::Identity, ObjectParams, OverlapShape, QueryParams);
 
-	TArray<AActor*> DamagedActors;
-
 	// process the overlap results
 	for (const FOverlapResult& CurrentOverlap : Overlaps)
 	{
-		// overlaps may return the same actor multiple times per each component overlapped
-		// ensure we only damage each actor once by adding it to a damaged list
-		if (DamagedActors.Find(CurrentOverlap.GetActor()) == INDEX_NONE)
+		AActor* OverlapActor = CurrentOverlap.GetActor();
+
+		if (!OverlapActor)
 		{
-			DamagedActors.Add(CurrentOverlap.GetActor());
+			continue;
+		}
 
-			// apply physics force away from the explosion
-			const FVector& ExplosionDir = CurrentOverlap.GetActor()->GetActorLocation() - GetActorLocation();
+		// overlaps may return the same actor multiple times per each component overlapped,
+		// and characters were already handled by the grid
+		bool bAlreadyDamaged = false;
+		DamagedActors.Add(OverlapActor, &bAlreadyDamaged);
 
-			// push and/or damage the overlapped actor
-			ProcessHit(CurrentOverlap.GetActor(), CurrentOverlap.GetComponent(), GetActorLocation(), ExplosionDir.GetSafeNormal());
+		if (bAlreadyDamaged)
+		{
+			continue;
 		}
-			
+
+		// apply physics force away from the explosion
+		const FVector ExplosionDir = OverlapActor->GetActorLocation() - ExplosionCenter;
+
+		// push and/or damage the overlapped actor
+		ApplyHitDamage(OverlapActor, CurrentOverlap.GetComponent(), ExplosionCenter, ExplosionDir.GetSafeNormal(), GetOwner(), GetInstigator(), this);
 	}
 }
 
 void AShooterProjectile::ProcessHit(AActor* HitActor, UPrimitiveComponent* HitComp, const FVector& HitLocation, const FVector& HitDirection)
 {
-	auto owner = GetOwner();
-	bool isAuthority = (GetLocalRole() == ROLE_Authority);
+	// damage and impulses are applied by the server only
+	if (GetLocalRole() != ROLE_Authority)
+	{
+		return;
+	}
+
+	ApplyHitDamage(HitActor, HitComp, HitLocation, HitDirection, GetOwner(), GetInstigator(), this);
+}
+
+void AShooterProjectile::ProcessResolvedHit(AShooterWeapon* Weapon, const FHitResult& Hit, const FVector& ShotDirection) const
+{
+	// make AI perception noise at the impact point
+	Weapon->MakeNoise(NoiseLoudness, Weapon->GetInstigator(), Hit.ImpactPoint, NoiseRange, NoiseTag);
+
+	// the weapon stands in as the damage causer so kills can still be traced back to the shooter
+	ApplyHitDamage(Hit.GetActor(), Hit.GetComponent(), Hit.ImpactPoint, ShotDirection, Weapon->GetOwner(), Weapon->GetInstigator(), Weapon);
+}
+
+float AShooterProjectile::GetCollisionRadius() const
+{
+	return CollisionComponent->GetUnscaledSphereRadius();
+}
+
+void AShooterProjectile::ApplyHitDamage(AActor* HitActor, UPrimitiveComponent* HitComp, const FVector& HitLocation, const FVector& HitDirection, AActor* ShooterActor, APawn* ShooterPawn, AActor* DamageCauser, float DamageScale) const
+{
 	// have we hit a character?
 	if (ACharacter* HitCharacter = Cast<ACharacter>(HitActor))
 	{
 		// ignore the owner of this projectile
-		if (HitCharacter != owner || bDamageOwner)
+		if (HitCharacter != ShooterActor || bDamageOwner)
 		{
-			if (isAuthority) {
-				// apply damage to the character(Server Only)
-				UGameplayStatics::ApplyDamage(HitCharacter, HitDamage, GetInstigator()->GetController(), this, HitDamageType);
-			}
+			// apply damage to the character
+			UGameplayStatics::ApplyDamage(HitCharacter, HitDamage * DamageScale, ShooterPawn ? ShooterPawn->GetController() : nullptr, DamageCauser, HitDamageType);
 		}
 	}
 
 	// have we hit a physics object?
-	if (isAuthority) {
-		if (HitComp->IsSimulatingPhysics())
-		{
-			// give some physics impulse to the object
-			HitComp->AddImpulseAtLocation(HitDirection * PhysicsForce, HitLocation);
-		}
+	if (HitComp && HitComp->IsSimulatingPhysics())
+	{
+		// give some physics impulse to the object
+		HitComp->AddImpulseAtLocation(HitDirection * PhysicsForce, HitLocation);
 	}
-	
 }
 
 void AShooterProjectile::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
@@ -191,15 +269,41 @@ void AShooterProjectile::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& O
 
 void AShooterProjectile::OnDeferredDestruction()
 {
-	// destroy this actor
-	Destroy();
+	// return this actor to its pool
+	Recycle();
+}
+
+void AShooterProjectile::Recycle()
+{
+	if (UShooterProjectilePool* Pool = OwningPool.Get())
+	{
+		Pool->ReleaseProjectile(this);
+
+	} else {
+
+		Destroy();
+	}
+}
+
+void AShooterProjectile::LifeSpanExpired()
+{
+	// pooled projectiles time out back into the pool
+	if (OwningPool.IsValid())
+	{
+		Recycle();
+		return;
+	}
+
+	Super::LifeSpanExpired();
 }
 
 void AShooterProjectile::Multicast_OnHitRegistered_Implementation(const FHitResult& Hit)
 {
+	INC_DWORD_STAT(STAT_ShooterRPCs);
+
 	if (GetLocalRole() == ROLE_Authority)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("Multicast OnHitRegistered"));
+		UE_LOG(LogShooterProjectile, Verbose, TEXT("Multicast OnHitRegistered"));
 		CollisionComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
 		BP_OnProjectileHit(Hit);
 		if (DeferredDestructionTime > 0.0f)
@@ -208,7 +312,7 @@ void AShooterProjectile::Multicast_OnHitRegistered_Implementation(const FHitResu
 		}
 		else
 		{
-			Destroy();
+			Recycle();
 		}
 	}
 }
@@ -221,4 +325,74 @@ void AShooterProjectile::SetWeaponComeFrom(AShooterWeapon* Weapon)
 AShooterWeapon* AShooterProjectile::GetWeaponComeFrom() const
 {
 	return WeaponComeFrom;
+}
+
+void AShooterProjectile::SetOwningPool(UShooterProjectilePool* Pool)
+{
+	OwningPool = Pool;
+}
+
+void AShooterProjectile::OnAcquiredFromPool()
+{
+	bInPool = false;
+
+	INC_DWORD_STAT(STAT_ShooterLiveProjectiles);
+	bHit = false;
+
+	// resume replication and show the projectile again
+	SetNetDormancy(DORM_Awake);
+	SetActorHiddenInGame(false);
+
+	// ignore the new shooter and restore collision
+	CollisionComponent->ClearMoveIgnoreActors();
+	CollisionComponent->IgnoreActorWhenMoving(GetInstigator(), true);
+	CollisionComponent->SetCollisionEnabled(ActiveCollisionEnabled);
+
+	// rebuild the launch velocity from the class defaults, along the new facing
+	const UProjectileMovementComponent* DefaultMovement = GetDefault<AShooterProjectile>(GetClass())->ProjectileMovement;
+
+	FVector LaunchVelocity = DefaultMovement->Velocity;
+
+	if (DefaultMovement->bInitialVelocityInLocalSpace)
+	{
+		LaunchVelocity = GetActorRotation().RotateVector(LaunchVelocity);
+	}
+
+	if (DefaultMovement->InitialSpeed > 0.0f)
+	{
+		LaunchVelocity = LaunchVelocity.GetSafeNormal() * DefaultMovement->InitialSpeed;
+	}
+
+	// the movement component drops its updated component when it stops, so hook it back up
+	ProjectileMovement->SetUpdatedComponent(CollisionComponent);
+	ProjectileMovement->Velocity = LaunchVelocity;
+	ProjectileMovement->UpdateComponentVelocity();
+	ProjectileMovement->Activate(true);
+
+	// restart the class life span, if any
+	SetLifeSpan(InitialLifeSpan);
+}
+
+void AShooterProjectile::OnReleasedToPool()
+{
+	bInPool = true;
+
+	DEC_DWORD_STAT(STAT_ShooterLiveProjectiles);
+
+	// cancel any pending end of life
+	GetWorld()->GetTimerManager().ClearTimer(DestructionTimer);
+	SetLifeSpan(0.0f);
+
+	// stop moving and colliding
+	ProjectileMovement->StopMovementImmediately();
+	ProjectileMovement->Deactivate();
+	CollisionComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+	// hide the projectile and forget the previous shooter
+	SetActorHiddenInGame(true);
+	SetOwner(nullptr);
+	WeaponComeFrom = nullptr;
+
+	// stop replicating while the projectile waits in the pool
+	SetNetDormancy(DORM_DormantAll);
 }
\ No newline at end of file
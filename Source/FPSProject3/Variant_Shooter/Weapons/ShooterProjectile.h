@@ -11,6 +11,7 @@ class UProjectileMovementComponent;
 class ACharacter;
 class UPrimitiveComponent;
 class AShooterWeapon; // forward declare the weapon class
+class UShooterProjectilePool;
 
 /**
  *  Simple projectile class for a first person shooter game
@@ -66,6 +67,14 @@ protected:
 	UPROPERTY(EditAnywhere, Category="Projectile|Explosion", meta = (ClampMin = 0, ClampMax = 5000, Units = "cm"))
 	float ExplosionRadius = 500.0f;	
 
+	/** Exponent of the explosion damage falloff towards the edge of the radius. Zero applies full damage across the whole radius */
+	UPROPERTY(EditAnywhere, Category="Projectile|Explosion", meta = (ClampMin = 0, ClampMax = 8, EditCondition = "bExplodeOnHit"))
+	float ExplosionDamageFalloff = 0.0f;
+
+	/** If true, characters behind cover from the explosion center are not damaged */
+	UPROPERTY(EditAnywhere, Category="Projectile|Explosion", meta = (EditCondition = "bExplodeOnHit"))
+	bool bExplosionChecksOcclusion = false;
+
 	/** If true, this projectile has already hit another surface */
 	bool bHit = false;
 
@@ -78,6 +87,15 @@ protected:
 
 	AShooterWeapon* WeaponComeFrom;
 
+	/** Pool this projectile is returned to instead of being destroyed. Null if the projectile was spawned outside a pool */
+	TWeakObjectPtr<UShooterProjectilePool> OwningPool;
+
+	/** If true, this projectile is deactivated and waiting in its pool */
+	bool bInPool = false;
+
+	/** Collision mode to restore when this projectile is reused */
+	ECollisionEnabled::Type ActiveCollisionEnabled = ECollisionEnabled::QueryAndPhysics;
+
 public:	
 
 	/** Constructor */
@@ -89,6 +107,30 @@ public:
 	void SetWeaponComeFrom(AShooterWeapon* Weapon);
 	AShooterWeapon* GetWeaponComeFrom() const;
 
+	/** Sets the pool this projectile will be recycled into */
+	void SetOwningPool(UShooterProjectilePool* Pool);
+
+	/** Returns true if this projectile is currently deactivated in its pool */
+	bool IsInPool() const { return bInPool; }
+
+	/** Resets hit, collision and movement state and launches this projectile from its current transform */
+	void OnAcquiredFromPool();
+
+	/** Hides and deactivates this projectile so it can wait in its pool */
+	void OnReleasedToPool();
+
+	/** Returns true if this projectile explodes and applies radial damage on hit */
+	bool ExplodesOnHit() const { return bExplodeOnHit; }
+
+	/** Applies this projectile type's hit damage, impulse and noise for a shot resolved without a projectile actor. Called on the class default object */
+	void ProcessResolvedHit(AShooterWeapon* Weapon, const FHitResult& Hit, const FVector& ShotDirection) const;
+
+	/** Returns the projectile movement component */
+	const UProjectileMovementComponent* GetProjectileMovement() const { return ProjectileMovement; }
+
+	/** Returns the radius of the collision sphere */
+	float GetCollisionRadius() const;
+
 protected:
 	
 	/** Gameplay initialization */
@@ -108,6 +150,9 @@ protected:
 	/** Processes a projectile hit for the given actor */
 	void ProcessHit(AActor* HitActor, UPrimitiveComponent* HitComp, const FVector& HitLocation, const FVector& HitDirection);
 
+	/** Damages and pushes the hit actor on behalf of the given shooter */
+	void ApplyHitDamage(AActor* HitActor, UPrimitiveComponent* HitComp, const FVector& HitLocation, const FVector& HitDirection, AActor* ShooterActor, APawn* ShooterPawn, AActor* DamageCauser, float DamageScale = 1.0f) const;
+
 	/** Passes control to Blueprint to implement any effects on hit. */
 	UFUNCTION(BlueprintImplementableEvent, Category="Projectile", meta = (DisplayName = "On Projectile Hit"))
 	void BP_OnProjectileHit(const FHitResult& Hit);
@@ -115,6 +160,12 @@ protected:
 	/** Called from the destruction timer to destroy this projectile */
 	void OnDeferredDestruction();
 
+	/** Returns this projectile to its pool, or destroys it if it isn't pooled */
+	void Recycle();
+
+	/** Recycles instead of destroying when the life span runs out */
+	virtual void LifeSpanExpired() override;
+
 protected:
 	// Multicast RPC to notify all clients of a hit event
 	UFUNCTION(NetMulticast, Reliable)
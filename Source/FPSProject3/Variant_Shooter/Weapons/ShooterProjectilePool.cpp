@@ -0,0 +1,166 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterProjectilePool.h"
+#include "ShooterProjectile.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "ShooterLog.h"
+
+static FAutoConsoleCommandWithWorld DumpProjectilePoolStatsCommand(
+	TEXT("Shooter.ProjectilePool.Stats"),
+	TEXT("Logs projectile pool hit, miss and high water counters for the current world"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UShooterProjectilePool* Pool = World ? World->GetSubsystem<UShooterProjectilePool>() : nullptr)
+		{
+			Pool->DumpStats();
+		}
+	})
+);
+
+bool UShooterProjectilePool::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UShooterProjectilePool::Deinitialize()
+{
+	// leave the final counters in the log so soak runs can size the pools
+	DumpStats();
+
+	Pools.Empty();
+
+	Super::Deinitialize();
+}
+
+void UShooterProjectilePool::Prewarm(TSubclassOf<AShooterProjectile> ProjectileClass, int32 Count)
+{
+	if (!ProjectileClass || GetWorld()->GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	FShooterProjectilePoolEntry& Pool = Pools.FindOrAdd(ProjectileClass);
+
+	// only top up the free list, several weapons may share the same projectile class
+	while (Pool.FreeProjectiles.Num() < Count)
+	{
+		AShooterProjectile* Projectile = SpawnPooledProjectile(ProjectileClass, FTransform::Identity, nullptr, nullptr);
+
+		if (!Projectile)
+		{
+			break;
+		}
+
+		Projectile->OnReleasedToPool();
+		Pool.FreeProjectiles.Add(Projectile);
+	}
+}
+
+AShooterProjectile* UShooterProjectilePool::AcquireProjectile(TSubclassOf<AShooterProjectile> ProjectileClass, const FTransform& SpawnTransform, AActor* InOwner, APawn* InInstigator)
+{
+	if (!ProjectileClass)
+	{
+		return nullptr;
+	}
+
+	FShooterProjectilePoolEntry& Pool = Pools.FindOrAdd(ProjectileClass);
+
+	// grab the most recently released projectile that is still alive
+	AShooterProjectile* Projectile = nullptr;
+
+	while (!Projectile && Pool.FreeProjectiles.Num() > 0)
+	{
+		AShooterProjectile* Candidate = Pool.FreeProjectiles.Pop(EAllowShrinking::No);
+
+		if (IsValid(Candidate))
+		{
+			Projectile = Candidate;
+		}
+	}
+
+	if (Projectile)
+	{
+		++Pool.Hits;
+
+		// move the pooled projectile into place and launch it
+		Projectile->SetOwner(InOwner);
+		Projectile->SetInstigator(InInstigator);
+		Projectile->SetActorTransform(SpawnTransform, false, nullptr, ETeleportType::ResetPhysics);
+		Projectile->OnAcquiredFromPool();
+
+	} else {
+
+		++Pool.Misses;
+
+		// the pool is dry, so grow it with a freshly spawned projectile
+		Projectile = SpawnPooledProjectile(ProjectileClass, SpawnTransform, InOwner, InInstigator);
+	}
+
+	if (Projectile)
+	{
+		++Pool.ActiveCount;
+		Pool.HighWater = FMath::Max(Pool.HighWater, Pool.ActiveCount);
+	}
+
+	return Projectile;
+}
+
+void UShooterProjectilePool::ReleaseProjectile(AShooterProjectile* Projectile)
+{
+	// ignore invalid or already pooled projectiles
+	if (!IsValid(Projectile) || Projectile->IsInPool())
+	{
+		return;
+	}
+
+	FShooterProjectilePoolEntry& Pool = Pools.FindOrAdd(Projectile->GetClass());
+
+	Projectile->OnReleasedToPool();
+
+	Pool.ActiveCount = FMath::Max(0, Pool.ActiveCount - 1);
+	Pool.FreeProjectiles.Add(Projectile);
+}
+
+int32 UShooterProjectilePool::GetTotalAcquired() const
+{
+	int32 TotalAcquired = 0;
+
+	for (const TPair<TSubclassOf<AShooterProjectile>, FShooterProjectilePoolEntry>& Pair : Pools)
+	{
+		TotalAcquired += Pair.Value.Hits + Pair.Value.Misses;
+	}
+
+	return TotalAcquired;
+}
+
+void UShooterProjectilePool::DumpStats() const
+{
+	for (const TPair<TSubclassOf<AShooterProjectile>, FShooterProjectilePoolEntry>& Pair : Pools)
+	{
+		const FShooterProjectilePoolEntry& Pool = Pair.Value;
+
+		UE_LOG(LogShooterProjectile, Log, TEXT("ProjectilePool [%s] Hits=%d Misses=%d HighWater=%d Active=%d Free=%d"),
+			*GetNameSafe(Pair.Key), Pool.Hits, Pool.Misses, Pool.HighWater, Pool.ActiveCount, Pool.FreeProjectiles.Num());
+	}
+}
+
+AShooterProjectile* UShooterProjectilePool::SpawnPooledProjectile(TSubclassOf<AShooterProjectile> ProjectileClass, const FTransform& SpawnTransform, AActor* InOwner, APawn* InInstigator)
+{
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.TransformScaleMethod = ESpawnActorScaleMethod::OverrideRootScale;
+	SpawnParams.Owner = InOwner;
+	SpawnParams.Instigator = InInstigator;
+
+	AShooterProjectile* Projectile = GetWorld()->SpawnActor<AShooterProjectile>(ProjectileClass, SpawnTransform, SpawnParams);
+
+	if (Projectile)
+	{
+		// route the projectile's end of life back to this pool
+		Projectile->SetOwningPool(this);
+	}
+
+	return Projectile;
+}
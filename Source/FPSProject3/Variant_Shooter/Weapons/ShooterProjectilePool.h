@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterProjectilePool.generated.h"
+
+class AShooterProjectile;
+
+/**
+ *  Pooled instances and usage counters for a single projectile class
+ */
+USTRUCT()
+struct FShooterProjectilePoolEntry
+{
+	GENERATED_BODY()
+
+	/** Inactive projectiles ready to be reused */
+	UPROPERTY()
+	TArray<TObjectPtr<AShooterProjectile>> FreeProjectiles;
+
+	/** Number of projectiles of this class currently in flight or waiting for deferred release */
+	int32 ActiveCount = 0;
+
+	/** Number of acquisitions served from the free list */
+	int32 Hits = 0;
+
+	/** Number of acquisitions that had to spawn a new projectile */
+	int32 Misses = 0;
+
+	/** Highest number of simultaneously active projectiles seen */
+	int32 HighWater = 0;
+};
+
+/**
+ *  Recycles shooter projectiles instead of spawning and destroying an actor per shot
+ *  Keeps one pool per projectile class, pre-warmed by the weapons that fire them
+ *  Server only. Clients see pooled projectiles through regular actor replication
+ */
+UCLASS()
+class FPSPROJECT3_API UShooterProjectilePool : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+	/** Pools keyed by projectile class */
+	UPROPERTY()
+	TMap<TSubclassOf<AShooterProjectile>, FShooterProjectilePoolEntry> Pools;
+
+public:
+
+	/** Only create pools for game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Logs the final pool counters */
+	virtual void Deinitialize() override;
+
+	/** Ensures at least Count inactive projectiles of the given class are waiting in the pool */
+	void Prewarm(TSubclassOf<AShooterProjectile> ProjectileClass, int32 Count);
+
+	/** Returns a launched projectile at the given transform, reusing a pooled instance when possible */
+	AShooterProjectile* AcquireProjectile(TSubclassOf<AShooterProjectile> ProjectileClass, const FTransform& SpawnTransform, AActor* InOwner, APawn* InInstigator);
+
+	/** Deactivates the projectile and returns it to its pool */
+	void ReleaseProjectile(AShooterProjectile* Projectile);
+
+	/** Returns the counters for the given projectile class, or nullptr if it has never been pooled */
+	const FShooterProjectilePoolEntry* GetPoolStats(TSubclassOf<AShooterProjectile> ProjectileClass) const { return Pools.Find(ProjectileClass); }
+
+	/** Returns the number of projectiles handed out by every pool, pooled or freshly spawned */
+	int32 GetTotalAcquired() const;
+
+	/** Logs hit, miss and high water counters for every pool */
+	void DumpStats() const;
+
+protected:
+
+	/** Spawns a new projectile owned by this pool */
+	AShooterProjectile* SpawnPooledProjectile(TSubclassOf<AShooterProjectile> ProjectileClass, const FTransform& SpawnTransform, AActor* InOwner, APawn* InInstigator);
+};
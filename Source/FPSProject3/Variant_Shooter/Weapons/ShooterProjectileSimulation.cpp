@@ -0,0 +1,148 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterProjectileSimulation.h"
+#include "ShooterProjectile.h"
+#include "ShooterWeapon.h"
+#include "ShooterWeaponHolder.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+#include "Engine/World.h"
+#include "ShooterStats.h"
+
+bool UShooterProjectileSimulation::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UShooterProjectileSimulation::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterProjectileSimulation, STATGROUP_Tickables);
+}
+
+void UShooterProjectileSimulation::LaunchProjectile(TSubclassOf<AShooterProjectile> ProjectileClass, AShooterWeapon* Weapon, const FVector& Location, const FVector& Direction, ECollisionChannel TraceChannel)
+{
+	if (!ProjectileClass || !IsValid(Weapon))
+	{
+		return;
+	}
+
+	// read the flight parameters from the projectile type
+	const AShooterProjectile* ProjectileDefaults = GetDefault<AShooterProjectile>(ProjectileClass);
+	const UProjectileMovementComponent* Movement = ProjectileDefaults->GetProjectileMovement();
+
+	const float Speed = Movement->InitialSpeed > 0.0f ? Movement->InitialSpeed : Movement->MaxSpeed;
+
+	Positions.Add(Location);
+	Velocities.Add(Direction.GetSafeNormal() * Speed);
+	LaunchPositions.Add(Location);
+	Lifetimes.Add(ProjectileDefaults->InitialLifeSpan > 0.0f ? ProjectileDefaults->InitialLifeSpan : DefaultLifetime);
+	Radii.Add(ProjectileDefaults->GetCollisionRadius());
+	GravityScales.Add(Movement->ProjectileGravityScale);
+	TraceChannels.Add(TraceChannel);
+	ProjectileClasses.Add(ProjectileClass);
+	OwnerWeapons.Add(Weapon);
+
+	++NumLaunched;
+}
+
+void UShooterProjectileSimulation::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_ShooterProjectileSimulation);
+
+	const int32 NumProjectiles = Positions.Num();
+
+	SET_DWORD_STAT(STAT_ShooterSimulatedProjectiles, NumProjectiles);
+
+	if (NumProjectiles == 0)
+	{
+		return;
+	}
+
+	INC_DWORD_STAT_BY(STAT_ShooterTraces, NumProjectiles);
+
+	UWorld* World = GetWorld();
+	const float GravityZ = World->GetGravityZ();
+
+	SweepResults.SetNum(NumProjectiles, EAllowShrinking::No);
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ShooterSimulatedProjectile), false);
+
+	// integrate and sweep every projectile in a single pass over the arrays
+	for (int32 Index = 0; Index < NumProjectiles; ++Index)
+	{
+		FHitResult& OutHit = SweepResults[Index];
+		OutHit.Reset(1.0f, false);
+
+		AShooterWeapon* Weapon = OwnerWeapons[Index].Get();
+
+		// the weapon is gone, so nobody can be credited with the hit. Retire the projectile
+		if (!Weapon)
+		{
+			Lifetimes[Index] = 0.0f;
+			continue;
+		}
+
+		Velocities[Index].Z += GravityZ * GravityScales[Index] * DeltaTime;
+
+		const FVector Start = Positions[Index];
+		const FVector End = Start + (Velocities[Index] * DeltaTime);
+
+		// ignore the weapon and the shooter
+		QueryParams.ClearIgnoredActors();
+		QueryParams.AddIgnoredActor(Weapon);
+		QueryParams.AddIgnoredActor(Weapon->GetOwner());
+
+		World->SweepSingleByChannel(OutHit, Start, End, FQuat::Identity, TraceChannels[Index], FCollisionShape::MakeSphere(Radii[Index]), QueryParams);
+
+		Positions[Index] = OutHit.bBlockingHit ? OutHit.Location : End;
+		Lifetimes[Index] -= DeltaTime;
+	}
+
+	// resolve impacts and retire expired projectiles. Go back to front so swap removal doesn't skip entries
+	for (int32 Index = NumProjectiles - 1; Index >= 0; --Index)
+	{
+		if (SweepResults[Index].bBlockingHit)
+		{
+			ResolveImpact(Index, SweepResults[Index]);
+			RemoveProjectileAt(Index);
+
+		} else if (Lifetimes[Index] <= 0.0f) {
+
+			RemoveProjectileAt(Index);
+		}
+	}
+}
+
+void UShooterProjectileSimulation::ResolveImpact(int32 Index, const FHitResult& Hit)
+{
+	AShooterWeapon* Weapon = OwnerWeapons[Index].Get();
+
+	if (!Weapon)
+	{
+		return;
+	}
+
+	// apply damage through the projectile type's hit path
+	GetDefault<AShooterProjectile>(ProjectileClasses[Index])->ProcessResolvedHit(Weapon, Hit, Velocities[Index].GetSafeNormal());
+
+	// only the impact is sent to clients, for cosmetics
+	if (IShooterWeaponHolder* WeaponOwner = Weapon->GetWeaponOwner())
+	{
+		WeaponOwner->NotifyHitscanImpact(LaunchPositions[Index], Hit.ImpactPoint, Hit.ImpactNormal);
+	}
+}
+
+void UShooterProjectileSimulation::RemoveProjectileAt(int32 Index)
+{
+	Positions.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Velocities.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	LaunchPositions.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Lifetimes.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Radii.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	GravityScales.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	TraceChannels.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	ProjectileClasses.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	OwnerWeapons.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+}
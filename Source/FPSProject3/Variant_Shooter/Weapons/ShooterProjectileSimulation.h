@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterProjectileSimulation.generated.h"
+
+class AShooterProjectile;
+class AShooterWeapon;
+
+/**
+ *  Simulates every in-flight non-exploding projectile in one tick, without an actor per bullet
+ *  Projectiles are stored as parallel arrays, integrated and swept together, and only
+ *  produce damage and a cosmetic impact event when they hit something
+ *  Server only. Exploding projectiles stay on the pooled actor path
+ */
+UCLASS()
+class FPSPROJECT3_API UShooterProjectileSimulation : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	/** Current location of each projectile */
+	TArray<FVector> Positions;
+
+	/** Current velocity of each projectile */
+	TArray<FVector> Velocities;
+
+	/** Location each projectile was launched from, used as the tracer start for impact cosmetics */
+	TArray<FVector> LaunchPositions;
+
+	/** Remaining life time of each projectile */
+	TArray<float> Lifetimes;
+
+	/** Collision sphere radius of each projectile */
+	TArray<float> Radii;
+
+	/** Gravity scale of each projectile */
+	TArray<float> GravityScales;
+
+	/** Trace channel each projectile sweeps against */
+	TArray<TEnumAsByte<ECollisionChannel>> TraceChannels;
+
+	/** Projectile type of each projectile. Damage values are read from its class defaults */
+	TArray<TSubclassOf<AShooterProjectile>> ProjectileClasses;
+
+	/** Weapon that fired each projectile */
+	TArray<TWeakObjectPtr<AShooterWeapon>> OwnerWeapons;
+
+	/** Sweep results for the current tick. Kept around to avoid reallocating every frame */
+	TArray<FHitResult> SweepResults;
+
+	/** Life time to use for projectile types that don't set an initial life span */
+	float DefaultLifetime = 5.0f;
+
+	/** Number of projectiles launched since the world started */
+	int32 NumLaunched = 0;
+
+public:
+
+	/** Only simulate projectiles in game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Advances and sweeps every projectile */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Returns the stat id for this tickable */
+	virtual TStatId GetStatId() const override;
+
+	/** Starts simulating a projectile of the given type fired by the weapon */
+	void LaunchProjectile(TSubclassOf<AShooterProjectile> ProjectileClass, AShooterWeapon* Weapon, const FVector& Location, const FVector& Direction, ECollisionChannel TraceChannel);
+
+	/** Returns the number of projectiles currently in flight */
+	int32 GetNumActiveProjectiles() const { return Positions.Num(); }
+
+	/** Returns the number of projectiles launched since the world started */
+	int32 GetNumLaunched() const { return NumLaunched; }
+
+protected:
+
+	/** Applies damage and sends the impact event for a projectile that hit something */
+	void ResolveImpact(int32 Index, const FHitResult& Hit);
+
+	/** Removes a projectile by swapping the last one into its slot */
+	void RemoveProjectileAt(int32 Index);
+};
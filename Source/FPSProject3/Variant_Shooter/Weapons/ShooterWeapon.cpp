@@ -5,9 +5,13 @@
 #include "Kismet/KismetMathLibrary.h"
 #include "Engine/World.h"
 #include "ShooterProjectile.h"
+#include "ShooterProjectilePool.h"
+#include "ShooterProjectileSimulation.h"
 #include "ShooterWeaponHolder.h"
+#include "ShooterLagCompensation.h"
+#include "ShooterLog.h"
+#include "ShooterStats.h"
 #include "Components/SceneComponent.h"
-#include "TimerManager.h"
 #include "Animation/AnimInstance.h"
 #include "Components/SkeletalMeshComponent.h"
 #include "GameFramework/Pawn.h"
@@ -15,6 +19,7 @@
 AShooterWeapon::AShooterWeapon()
 {
 	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
 
 	// create the root
 	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
@@ -52,14 +57,59 @@ void AShooterWeapon::BeginPlay()
 
 	// attach the meshes to the owner
 	WeaponOwner->AttachWeaponMeshes(this);
+
+	// make sure projectiles are waiting in the pool before the first shot (server only)
+	if (GetNetMode() != NM_Client && GetEffectiveFireMode() == EShooterWeaponFireMode::Projectile)
+	{
+		if (UShooterProjectilePool* ProjectilePool = GetWorld()->GetSubsystem<UShooterProjectilePool>())
+		{
+			ProjectilePool->Prewarm(ProjectileClass, ProjectilePoolPrewarmCount);
+		}
+	}
 }
 
 void AShooterWeapon::EndPlay(EEndPlayReason::Type EndPlayReason)
 {
 	Super::EndPlay(EndPlayReason);
+}
 
-	// clear the refire timer
-	GetWorld()->GetTimerManager().ClearTimer(RefireTimer);
+void AShooterWeapon::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	const bool bWasCoolingDown = RefireCooldown > 0.0f;
+
+	RefireCooldown -= DeltaTime;
+
+	// full auto fires every shot that came due this frame. Each shot adds to the cooldown, so leftover time carries over
+	int32 ShotsThisFrame = 0;
+
+	while (bIsFiring && bFullAuto && RefireCooldown <= 0.0f && ShotsThisFrame < MaxShotsPerFrame)
+	{
+		Fire();
+		++ShotsThisFrame;
+	}
+
+	// still cooling down
+	if (RefireCooldown > 0.0f)
+	{
+		return;
+	}
+
+	// drop any shots over the per frame cap instead of firing them late
+	RefireCooldown = 0.0f;
+
+	// semi auto weapons let the owner know they can shoot again
+	if (bWasCoolingDown && !bFullAuto && CurrentBullets > 0)
+	{
+		FireCooldownExpired();
+	}
+
+	// nothing left to schedule, stop ticking until the next shot
+	if (!bIsFiring || !bFullAuto)
+	{
+		SetActorTickEnabled(false);
+	}
 }
 
 void AShooterWeapon::OnOwnerDestroyed(AActor* DestroyedActor)
@@ -91,9 +141,10 @@ void AShooterWeapon::DeactivateWeapon()
 
 void AShooterWeapon::StartFiring()
 {
-	if (!HasAuthority())
+	// only the server and the locally controlled owner fire. The owner's shots are predicted and never deal damage
+	if (!HasShotAuthority() && !(PawnOwner && PawnOwner->IsLocallyControlled()))
 	{
-		UE_LOG(LogTemp, Warning, TEXT("StartFiring - Client blocked (only server allowed)"));
+		UE_LOG(LogShooterWeapon, Verbose, TEXT("StartFiring - Remote client blocked"));
 		return;
 	}
 	// raise the firing flag
@@ -102,42 +153,29 @@ void AShooterWeapon::StartFiring()
 	// If no bullets, do not start firing
 	if (CurrentBullets <= 0)
 	{
-		UE_LOG(LogTemp, Log, TEXT("StartFiring - No bullets, aborting fire."));
+		UE_LOG(LogShooterWeapon, Verbose, TEXT("StartFiring - No bullets, aborting fire."));
 		StopFiring();
 		return;
 	}
 
-	// check how much time has passed since we last shot
-	// this may be under the refire rate if the weapon shoots slow enough and the player is spamming the trigger
-	const float TimeSinceLastShot = GetWorld()->GetTimeSeconds() - TimeOfLastShot;
-
-	if (TimeSinceLastShot > RefireRate)
+	// fire right away if the weapon has cooled down
+	// otherwise the player is spamming the trigger. Full auto weapons will fire from Tick when the cooldown runs out
+	if (RefireCooldown <= 0.0f)
 	{
-		// fire the weapon right away
 		Fire();
-
-	} else {
-
-		// if we're full auto, schedule the next shot (only if there are bullets)
-		if (bFullAuto && CurrentBullets > 0)
-		{
-			GetWorld()->GetTimerManager().SetTimer(RefireTimer, this, &AShooterWeapon::Fire, TimeSinceLastShot, false);
-		}
-
 	}
 }
 
 void AShooterWeapon::StopFiring()
 {
-	// lower the firing flag
+	// lower the firing flag. Tick keeps running the cooldown down, if any
 	bIsFiring = false;
-
-	// clear the refire timer
-	GetWorld()->GetTimerManager().ClearTimer(RefireTimer);
 }
 
 void AShooterWeapon::Fire()
 {
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_ShooterWeaponFire);
+
 	// ensure the player still wants to fire. They may have let go of the trigger
 	if (!bIsFiring)
 	{
@@ -148,47 +186,56 @@ void AShooterWeapon::Fire()
 	if (CurrentBullets <= 0)
 	{
 		// No bullets left - stop firing (important for full-auto)
-		UE_LOG(LogTemp, Log, TEXT("Fire - No bullets left, stopping fire."));
+		UE_LOG(LogShooterWeapon, Verbose, TEXT("Fire - No bullets left, stopping fire."));
 		StopFiring();
 		return;
 	}
+
+	INC_DWORD_STAT(STAT_ShooterShots);
+
+	const uint64 ShotStartCycles = FPlatformTime::Cycles64();
 	
-	// fire a projectile at the target
-	FireProjectile(WeaponOwner->GetWeaponTargetLocation());
+	const FVector TargetLocation = WeaponOwner->GetWeaponTargetLocation();
+
+	// fire at the target
+	switch (GetEffectiveFireMode())
+	{
+	case EShooterWeaponFireMode::Hitscan:
+		FireHitscan(TargetLocation);
+		break;
+
+	case EShooterWeaponFireMode::SimulatedProjectile:
+		FireSimulatedProjectile(TargetLocation);
+		break;
 
-	// update the time of our last shot
-	TimeOfLastShot = GetWorld()->GetTimeSeconds();
+	default:
+		FireProjectile(TargetLocation);
+		break;
+	}
 
 	// make noise so the AI perception system can hear us
-	MakeNoise(ShotLoudness, PawnOwner, PawnOwner->GetActorLocation(), ShotNoiseRange, ShotNoiseTag);
+	if (HasShotAuthority())
+	{
+		MakeNoise(ShotLoudness, PawnOwner, PawnOwner->GetActorLocation(), ShotNoiseRange, ShotNoiseTag);
+
+		ShooterCost::Shots.Record(FPlatformTime::Cycles64() - ShotStartCycles);
+	}
 
 	// consume bullets
 	--CurrentBullets;
+	++ShotSequence;
 
 	// update the weapon HUD immediately after consuming bullet
 	WeaponOwner->UpdateWeaponHUD(CurrentBullets, MagazineSize);
 
-	// are we full auto?
-	if (bFullAuto)
-	{
-		// if still firing and still have bullets, schedule the next shot
-		if (bIsFiring && CurrentBullets > 0)
-		{
-			GetWorld()->GetTimerManager().SetTimer(RefireTimer, this, &AShooterWeapon::Fire, RefireRate, false);
-		}
-		else
-		{
-			// out of bullets or player stopped firing -> ensure firing stops
-			StopFiring();
-		}
-	}
-	else
+	// start the refire cooldown. Adding to the remaining time instead of resetting it keeps the fire rate exact at any frame rate
+	RefireCooldown += RefireRate;
+	SetActorTickEnabled(true);
+
+	// out of bullets -> ensure firing stops
+	if (CurrentBullets <= 0)
 	{
-		// semi-auto: schedule cooldown notification only if bullets remain
-		if (CurrentBullets > 0)
-		{
-			GetWorld()->GetTimerManager().SetTimer(RefireTimer, this, &AShooterWeapon::FireCooldownExpired, RefireRate, false);
-		}
+		StopFiring();
 	}
 }
 
@@ -200,19 +247,16 @@ void AShooterWeapon::FireCooldownExpired()
 
 void AShooterWeapon::FireProjectile(const FVector& TargetLocation)
 {
-	if (HasAuthority()) {
+	if (HasShotAuthority()) {
 		//Server only logic
-		UE_LOG(LogTemp, Warning, TEXT("Firing Projectile"));
 		// get the projectile transform
 		FTransform ProjectileTransform = CalculateProjectileSpawnTransform(TargetLocation);
-		// spawn the projectile
-		FActorSpawnParameters SpawnParams;
-		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
-		SpawnParams.TransformScaleMethod = ESpawnActorScaleMethod::OverrideRootScale;
-		SpawnParams.Owner = GetOwner();
-		SpawnParams.Instigator = PawnOwner;
-		//SpawnParams.Name = "Bullets/bullet";
-		AShooterProjectile* Projectile = GetWorld()->SpawnActor<AShooterProjectile>(ProjectileClass, ProjectileTransform, SpawnParams);
+		// take a projectile from the pool, it will be spawned if the pool is empty
+		AShooterProjectile* Projectile = nullptr;
+		if (UShooterProjectilePool* ProjectilePool = GetWorld()->GetSubsystem<UShooterProjectilePool>())
+		{
+			Projectile = ProjectilePool->AcquireProjectile(ProjectileClass, ProjectileTransform, GetOwner(), PawnOwner);
+		}
 		if (Projectile)
 		{
 			Projectile->SetFolderPath("Bullets");
@@ -223,16 +267,95 @@ void AShooterWeapon::FireProjectile(const FVector& TargetLocation)
 			Projectile->SetWeaponComeFrom(this);
 		}
 	}
-	else {
-		//Client Only logic
+
+	WeaponOwner->PlayFiringMontage(FiringMontage);	// play the firing montage
+	WeaponOwner->AddWeaponRecoil(FiringRecoil);	// add recoil
+}
+
+void AShooterWeapon::FireHitscan(const FVector& TargetLocation)
+{
+	// aim from the muzzle with the same variance a projectile would get
+	const FTransform ShotTransform = CalculateProjectileSpawnTransform(TargetLocation);
+	const FVector ShotDirection = ShotTransform.GetRotation().GetForwardVector();
+	const FVector TraceStart = ShotTransform.GetLocation();
+	const FVector TraceEnd = TraceStart + (ShotDirection * HitscanRange);
+
+	// ignore the weapon and the shooter
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ShooterHitscan), false, this);
+	QueryParams.AddIgnoredActor(GetOwner());
+
+	FHitResult OutHit;
+
+	if (HasShotAuthority())
+	{
+		// test characters where the shooter saw them when it fired
+		const UShooterLagCompensation* LagCompensation = GetWorld()->GetSubsystem<UShooterLagCompensation>();
+		const bool bBlockingHit = LagCompensation
+			? LagCompensation->LineTraceRewound(OutHit, TraceStart, TraceEnd, ShotTraceChannel, QueryParams, GetOwner())
+			: GetWorld()->LineTraceSingleByChannel(OutHit, TraceStart, TraceEnd, ShotTraceChannel, QueryParams);
+
+		if (bBlockingHit)
+		{
+			// apply damage through the projectile type's hit path
+			GetDefault<AShooterProjectile>(ProjectileClass)->ProcessResolvedHit(this, OutHit, ShotDirection);
+		}
+
+		// only the impact is sent to clients, for cosmetics
+		WeaponOwner->NotifyHitscanImpact(TraceStart, bBlockingHit ? FVector(OutHit.ImpactPoint) : TraceEnd, bBlockingHit ? FVector(OutHit.ImpactNormal) : FVector::ZeroVector);
+
+	} else {
+
+		// predicted shot on the owning client. Trace locally for the tracer and impact effects only, the server deals the damage
+		INC_DWORD_STAT(STAT_ShooterTraces);
+
+		const bool bBlockingHit = GetWorld()->LineTraceSingleByChannel(OutHit, TraceStart, TraceEnd, ShotTraceChannel, QueryParams);
+
+		BP_OnHitscanImpact(TraceStart, bBlockingHit ? FVector(OutHit.ImpactPoint) : TraceEnd, bBlockingHit ? FVector(OutHit.ImpactNormal) : FVector::ZeroVector);
 	}
 
 	WeaponOwner->PlayFiringMontage(FiringMontage);	// play the firing montage
-	WeaponOwner->AddWeaponRecoil(FiringRecoil);	// add recoil// consume bullets
-	// --CurrentBullets;  // consumed in Fire() now
-	// if the clip is depleted, reload it
-	// update the weapon HUD
-	//WeaponOwner->UpdateWeaponHUD(CurrentBullets, MagazineSize); // updated in Fire()
+	WeaponOwner->AddWeaponRecoil(FiringRecoil);	// add recoil
+}
+
+void AShooterWeapon::FireSimulatedProjectile(const FVector& TargetLocation)
+{
+	if (HasShotAuthority())
+	{
+		// launch from the muzzle with the same variance a projectile actor would get
+		const FTransform ShotTransform = CalculateProjectileSpawnTransform(TargetLocation);
+
+		if (UShooterProjectileSimulation* ProjectileSimulation = GetWorld()->GetSubsystem<UShooterProjectileSimulation>())
+		{
+			ProjectileSimulation->LaunchProjectile(ProjectileClass, this, ShotTransform.GetLocation(), ShotTransform.GetRotation().GetForwardVector(), ShotTraceChannel);
+		}
+	}
+
+	WeaponOwner->PlayFiringMontage(FiringMontage);	// play the firing montage
+	WeaponOwner->AddWeaponRecoil(FiringRecoil);	// add recoil
+}
+
+EShooterWeaponFireMode AShooterWeapon::GetEffectiveFireMode() const
+{
+	// exploding projectiles need the actor path for their radial damage
+	if (!ProjectileClass || GetDefault<AShooterProjectile>(ProjectileClass)->ExplodesOnHit())
+	{
+		return EShooterWeaponFireMode::Projectile;
+	}
+
+	return FireMode;
+}
+
+bool AShooterWeapon::HasShotAuthority() const
+{
+	return GetNetMode() != NM_Client;
+}
+
+void AShooterWeapon::ReconcileAmmo(int32 ServerBullets, uint16 ServerShotSequence)
+{
+	// shots we predicted that the server hasn't accounted for yet. The signed difference survives wrap around
+	const int32 PendingShots = FMath::Max(0, static_cast<int32>(static_cast<int16>(ShotSequence - ServerShotSequence)));
+
+	CurrentBullets = FMath::Clamp(ServerBullets - PendingShots, 0, MagazineSize);
 }
 
 void AShooterWeapon::Reload()
@@ -14,6 +14,22 @@ class USkeletalMeshComponent;
 class UAnimMontage;
 class UAnimInstance;
 
+/**
+ *  How a shooter weapon resolves its shots
+ */
+UENUM()
+enum class EShooterWeaponFireMode : uint8
+{
+	/** Spawns a replicated projectile actor for every shot */
+	Projectile,
+
+	/** Resolves the shot with a single server trace and only multicasts the impact for cosmetics */
+	Hitscan,
+
+	/** Flies the projectile in the batched projectile simulation and only multicasts the impact for cosmetics */
+	SimulatedProjectile
+};
+
 /**
  *  Base class for a simple first person shooter weapon
  *  Provides both first person and third person perspective meshes
@@ -42,12 +58,31 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Ammo")
 	TSubclassOf<AShooterProjectile> ProjectileClass;
 
+	/** How shots from this weapon are resolved. Exploding projectile types always fire as projectiles */
+	UPROPERTY(EditAnywhere, Category="Ammo")
+	EShooterWeaponFireMode FireMode = EShooterWeaponFireMode::Projectile;
+
+	/** Max distance for hitscan shots */
+	UPROPERTY(EditAnywhere, Category="Ammo", meta = (ClampMin = 0, ClampMax = 100000, Units = "cm", EditCondition = "FireMode == EShooterWeaponFireMode::Hitscan"))
+	float HitscanRange = 10000.0f;
+
+	/** Trace channel for hitscan and simulated shots. Defaults to the Projectile channel so they are blocked like projectile actors */
+	UPROPERTY(EditAnywhere, Category="Ammo", meta = (EditCondition = "FireMode != EShooterWeaponFireMode::Projectile"))
+	TEnumAsByte<ECollisionChannel> ShotTraceChannel = ECC_GameTraceChannel1;
+
+	/** Number of projectiles to pre-spawn into the projectile pool when this weapon starts play */
+	UPROPERTY(EditAnywhere, Category="Ammo", meta = (ClampMin = 0, ClampMax = 200))
+	int32 ProjectilePoolPrewarmCount = 8;
+
 	/** Number of bullets in a magazine */
 	UPROPERTY(EditAnywhere, Category="Ammo", meta = (ClampMin = 0, ClampMax = 100))
 	int32 MagazineSize = 10;
 
 	/** Number of bullets in the current magazine */
 	int32 CurrentBullets = 0;
+
+	/** Number of shots fired by this weapon. Wraps around. Used to match the owning client's predicted shots with the server's */
+	uint16 ShotSequence = 0;
 	
 	/** Animation montage to play when firing this weapon */
 	UPROPERTY(EditAnywhere, Category="Animation")
@@ -85,15 +120,16 @@ protected:
 	UPROPERTY(EditAnywhere, Category="Refire", meta = (ClampMin = 0, ClampMax = 5, Units = "s"))
 	float RefireRate = 0.5f;
 
-	/** Game time of last shot fired, used to enforce refire rate on semi auto */
-	float TimeOfLastShot = 0.0f;
+	/** Max number of shots a full auto weapon fires in a single frame when its refire rate is shorter than the frame */
+	UPROPERTY(EditAnywhere, Category="Refire", meta = (ClampMin = 1, ClampMax = 32))
+	int32 MaxShotsPerFrame = 4;
+
+	/** Time left until the weapon can fire again. Goes negative within a frame to carry the leftover time into the next shot */
+	float RefireCooldown = 0.0f;
 
 	/** If true, the weapon is currently firing */
 	bool bIsFiring = false;
 
-	/** Timer to handle full auto refiring */
-	FTimerHandle RefireTimer;
-
 	/** Cast pawn pointer to the owner for AI perception system interactions */
 	TObjectPtr<APawn> PawnOwner;
 
@@ -122,6 +158,11 @@ protected:
 	/** Gameplay Cleanup */
 	virtual void EndPlay(EEndPlayReason::Type EndPlayReason) override;
 
+public:
+
+	/** Runs the refire cooldown and full auto fire. Only enabled while firing or cooling down */
+	virtual void Tick(float DeltaTime) override;
+
 protected:
 
 	/** Called when the weapon's owner is destroyed */
@@ -153,6 +194,18 @@ protected:
 	/** Fire a projectile towards the target location */
 	virtual void FireProjectile(const FVector& TargetLocation);
 
+	/** Resolve a shot towards the target location with a single trace, without spawning a projectile */
+	virtual void FireHitscan(const FVector& TargetLocation);
+
+	/** Launch a projectile towards the target location in the batched projectile simulation */
+	virtual void FireSimulatedProjectile(const FVector& TargetLocation);
+
+	/** Returns the fire mode shots will actually use, accounting for projectile types that need an actor */
+	EShooterWeaponFireMode GetEffectiveFireMode() const;
+
+	/** Returns true if shots from this weapon are resolved on this machine. Weapons are spawned locally everywhere, so HasAuthority can't tell */
+	bool HasShotAuthority() const;
+
 	/** Calculates the spawn transform for projectiles shot by this weapon */
 	FTransform CalculateProjectileSpawnTransform(const FVector& TargetLocation) const;
 
@@ -180,5 +233,21 @@ public:
 	/** Returns the current bullet count */
 	int32 GetBulletCount() const { return CurrentBullets; }
 
+	/** Returns the number of shots fired so far */
+	uint16 GetShotSequence() const { return ShotSequence; }
+
+	/** Lines up the shot count with the owning client's, so the server's ammo updates can be matched to its predicted shots */
+	void SetShotSequence(uint16 NewShotSequence) { ShotSequence = NewShotSequence; }
+
+	/** Corrects the predicted bullet count from the server's, keeping any shots the server hasn't processed yet */
+	void ReconcileAmmo(int32 ServerBullets, uint16 ServerShotSequence);
+
+	/** Returns true if the owning client plays its own impact effects for predicted shots */
+	bool PredictsImpactEffects() const { return GetEffectiveFireMode() == EShooterWeaponFireMode::Hitscan; }
+
 	void Reload();
+
+	/** Passes control to Blueprint to play tracer and impact effects for a hitscan shot. ImpactNormal is zero if nothing was hit */
+	UFUNCTION(BlueprintImplementableEvent, Category="Weapon", meta = (DisplayName = "On Hitscan Impact"))
+	void BP_OnHitscanImpact(const FVector& TraceStart, const FVector& ImpactPoint, const FVector& ImpactNormal);
 };
@@ -52,4 +52,7 @@ public:
 
 	/** Notifies the owner that the weapon cooldown has expired and it's ready to shoot again */
 	virtual void OnSemiWeaponRefire() = 0;
+
+	/** Broadcasts the cosmetic result of a server hitscan shot. ImpactNormal is zero if nothing was hit */
+	virtual void NotifyHitscanImpact(const FVector& TraceStart, const FVector& ImpactPoint, const FVector& ImpactNormal) = 0;
 };
@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterWeaponInventory.h"
+#include "ShooterCharacter.h"
+
+void FShooterWeaponInventoryEntry::PostReplicatedAdd(const FShooterWeaponInventory& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+	{
+		InArraySerializer.Owner->OnWeaponEntryAdded(*this);
+	}
+}
+
+void FShooterWeaponInventoryEntry::PostReplicatedChange(const FShooterWeaponInventory& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+	{
+		InArraySerializer.Owner->OnWeaponEntryChanged(*this);
+	}
+}
+
+void FShooterWeaponInventoryEntry::PreReplicatedRemove(const FShooterWeaponInventory& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+	{
+		InArraySerializer.Owner->OnWeaponEntryRemoved(*this);
+	}
+}
+
+FShooterWeaponInventoryEntry* FShooterWeaponInventory::FindSlot(uint8 Slot)
+{
+	return Entries.FindByPredicate([Slot](const FShooterWeaponInventoryEntry& Entry) { return Entry.Slot == Slot; });
+}
+
+FShooterWeaponInventoryEntry* FShooterWeaponInventory::FindWeaponClass(TSubclassOf<AShooterWeapon> WeaponClass)
+{
+	return Entries.FindByPredicate([WeaponClass](const FShooterWeaponInventoryEntry& Entry) { return Entry.WeaponClass == WeaponClass; });
+}
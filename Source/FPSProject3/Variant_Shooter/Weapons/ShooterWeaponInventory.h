@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Net/Serialization/FastArraySerializer.h"
+#include "ShooterWeaponInventory.generated.h"
+
+class AShooterWeapon;
+class AShooterCharacter;
+struct FShooterWeaponInventory;
+
+/**
+ *  A weapon owned by a shooter character
+ *  Only the weapon type is replicated. Every machine spawns its own local weapon actor from it
+ */
+USTRUCT()
+struct FShooterWeaponInventoryEntry : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	/** Type of weapon owned */
+	UPROPERTY()
+	TSubclassOf<AShooterWeapon> WeaponClass;
+
+	/** Inventory slot. Fast array order isn't kept on clients, so weapons are looked up and switched by slot */
+	UPROPERTY()
+	uint8 Slot = 0;
+
+	/** Incremented every time the weapon is refilled by picking up another one of its type */
+	UPROPERTY()
+	uint8 RefillCount = 0;
+
+	/** Spawns the local weapon */
+	void PostReplicatedAdd(const FShooterWeaponInventory& InArraySerializer);
+
+	/** Refills the local weapon */
+	void PostReplicatedChange(const FShooterWeaponInventory& InArraySerializer);
+
+	/** Destroys the local weapon */
+	void PreReplicatedRemove(const FShooterWeaponInventory& InArraySerializer);
+};
+
+/**
+ *  Replicated list of the weapons owned by a shooter character
+ *  Clients converge on it from state, so late joiners see the right weapons without replaying pickup events
+ */
+USTRUCT()
+struct FShooterWeaponInventory : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	/** Owned weapons */
+	UPROPERTY()
+	TArray<FShooterWeaponInventoryEntry> Entries;
+
+	/** Character owning this inventory */
+	UPROPERTY(NotReplicated)
+	TObjectPtr<AShooterCharacter> Owner;
+
+	/** Returns the entry in the given slot, or nullptr */
+	FShooterWeaponInventoryEntry* FindSlot(uint8 Slot);
+
+	/** Returns the entry for the weapon type, or nullptr */
+	FShooterWeaponInventoryEntry* FindWeaponClass(TSubclassOf<AShooterWeapon> WeaponClass);
+
+	/** Delta serializes the changed entries only */
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FShooterWeaponInventoryEntry, FShooterWeaponInventory>(Entries, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FShooterWeaponInventory> : public TStructOpsTypeTraitsBase2<FShooterWeaponInventory>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
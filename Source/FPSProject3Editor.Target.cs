@@ -11,5 +11,9 @@ public class FPSProject3EditorTarget : TargetRules
 		DefaultBuildSettings = BuildSettingsVersion.V5;
 		IncludeOrderVersion = EngineIncludeOrderVersion.Unreal5_6;
 		ExtraModuleNames.Add("FPSProject3");
+
+		// push model replication, matching the game target
+		bOverrideBuildEnvironment = true;
+		bWithPushModel = true;
 	}
 }
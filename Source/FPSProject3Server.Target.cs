@@ -0,0 +1,19 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+using System.Collections.Generic;
+
+public class FPSProject3ServerTarget : TargetRules
+{
+	public FPSProject3ServerTarget(TargetInfo Target) : base(Target)
+	{
+		Type = TargetType.Server;
+		DefaultBuildSettings = BuildSettingsVersion.V5;
+		IncludeOrderVersion = EngineIncludeOrderVersion.Unreal5_6;
+		ExtraModuleNames.Add("FPSProject3");
+
+		// push model replication needs its own build environment
+		BuildEnvironment = TargetBuildEnvironment.Unique;
+		bWithPushModel = true;
+	}
+}